@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// Подсчёт выделений памяти через operator new. Замена глобальных operator new и delete
+// лежит в allocation_counter.cpp и действует только в программах, которые его линкуют
+// (сам справочник и бенчмарки); без неё счётчик всегда нулевой
+namespace allocation_counter {
+
+// Счётчик свой у каждого потока, поэтому подсчёт не требует синхронизации
+inline thread_local uint64_t thread_allocation_count = 0;
+
+// Число выделений памяти в текущем потоке с его запуска.
+// Разность двух значений - выделения за время запроса
+inline uint64_t GetThreadAllocationCount() {
+    return thread_allocation_count;
+}
+
+} // namespace allocation_counter
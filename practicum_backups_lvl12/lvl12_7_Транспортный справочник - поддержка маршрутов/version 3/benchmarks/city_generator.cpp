@@ -0,0 +1,229 @@
+#include "city_generator.h"
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace city_generator {
+
+namespace {
+
+constexpr double CELL_SIZE = 0.004;  // Градусы широты между соседними кварталами
+constexpr const char* RENDER_SETTINGS = R"("render_settings": {"width": 1200, "height": 1200, "padding": 50,
+"line_width": 14, "stop_radius": 5, "bus_label_font_size": 20, "bus_label_offset": [7, 15],
+"stop_label_font_size": 20, "stop_label_offset": [7, -3], "underlayer_color": [255, 255, 255, 0.85],
+"underlayer_width": 3, "color_palette": ["green", [255, 160, 0], "red"]})";
+constexpr const char* ROUTING_SETTINGS = R"("routing_settings": {"bus_wait_time": 6, "bus_velocity": 40})";
+
+class City {
+public:
+    explicit City(const CitySettings& settings)
+        : settings_(settings)
+        , side_(static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(settings.stop_count)))))
+        , generator_(settings.seed)
+        , roads_(settings.stop_count) {
+        std::uniform_real_distribution<double> jitter(-0.3 * CELL_SIZE, 0.3 * CELL_SIZE);
+        coordinates_.reserve(settings.stop_count);
+        for (size_t i = 0; i < settings.stop_count; ++i) {
+            // Долгота растянута, чтобы на широте Москвы кварталы были примерно квадратными
+            coordinates_.push_back({55.55 + (i / side_) * CELL_SIZE + jitter(generator_),
+                                    37.35 + (i % side_) * CELL_SIZE * 1.7 + jitter(generator_)});
+        }
+        for (size_t i = 0; i < settings.bus_count; ++i) {
+            buses_.push_back(MakeRoute());
+            for (size_t j = 1; j < buses_.back().first.size(); ++j) {
+                AddRoad(buses_.back().first[j - 1], buses_.back().first[j]);
+            }
+        }
+        AddExtraRoads();
+    }
+
+    std::string ToJson() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(6) << R"({"base_requests": [)";
+        for (size_t i = 0; i < coordinates_.size(); ++i) {
+            out << (i == 0 ? "" : ",") << "\n" << R"({"type": "Stop", "name": "Stop )" << i
+                << R"(", "latitude": )" << coordinates_[i].lat << R"(, "longitude": )" << coordinates_[i].lng
+                << R"(, "road_distances": {)";
+            for (size_t j = 0; j < roads_[i].size(); ++j) {
+                out << (j == 0 ? "" : ", ") << R"("Stop )" << roads_[i][j].first << R"(": )" << roads_[i][j].second;
+            }
+            out << "}}";
+        }
+        for (size_t i = 0; i < buses_.size(); ++i) {
+            const auto& [stops, is_roundtrip] = buses_[i];
+            out << ",\n" << R"({"type": "Bus", "name": "Bus )" << i << R"(", "stops": [)";
+            for (size_t j = 0; j < stops.size(); ++j) {
+                out << (j == 0 ? "" : ", ") << R"("Stop )" << stops[j] << '"';
+            }
+            out << R"(], "is_roundtrip": )" << (is_roundtrip ? "true" : "false") << "}";
+        }
+        out << "],\n" << RENDER_SETTINGS << ",\n" << ROUTING_SETTINGS << "}\n";
+        return out.str();
+    }
+
+private:
+    const CitySettings& settings_;
+    size_t side_;
+    std::mt19937 generator_;
+    std::vector<geo::Coordinates> coordinates_;
+    // Расстояния от остановки до соседей: номер соседа и метры
+    std::vector<std::vector<std::pair<size_t, int>>> roads_;
+    // Остановки маршрута и признак кольцевого
+    std::vector<std::pair<std::vector<size_t>, bool>> buses_;
+
+    std::vector<size_t> GetNeighbors(size_t stop) const {
+        std::vector<size_t> neighbors;
+        const long row = static_cast<long>(stop / side_);
+        const long column = static_cast<long>(stop % side_);
+        for (long dr = -1; dr <= 1; ++dr) {
+            for (long dc = -1; dc <= 1; ++dc) {
+                const long r = row + dr;
+                const long c = column + dc;
+                if ((dr == 0 && dc == 0) || r < 0 || c < 0 || c >= static_cast<long>(side_)) {
+                    continue;
+                }
+                if (const size_t index = static_cast<size_t>(r) * side_ + static_cast<size_t>(c);
+                    index < settings_.stop_count) {
+                    neighbors.push_back(index);
+                }
+            }
+        }
+        return neighbors;
+    }
+
+    size_t Random(size_t bound) {
+        return std::uniform_int_distribution<size_t>(0, bound - 1)(generator_);
+    }
+
+    std::pair<std::vector<size_t>, bool> MakeRoute() {
+        const size_t length = settings_.min_route_length
+            + Random(settings_.max_route_length - settings_.min_route_length + 1);
+        if (std::uniform_real_distribution<double>(0.0, 1.0)(generator_) < settings_.round_trip_share) {
+            if (auto loop = MakeLoop(length); !loop.empty()) {
+                return {std::move(loop), true};
+            }
+        }
+        return {MakeWalk(length), false};
+    }
+
+    // Случайное блуждание без немедленного возврата на предыдущую остановку
+    std::vector<size_t> MakeWalk(size_t length) {
+        std::vector<size_t> stops{Random(settings_.stop_count)};
+        while (stops.size() < length) {
+            std::vector<size_t> neighbors = GetNeighbors(stops.back());
+            if (stops.size() > 1 && neighbors.size() > 1) {
+                neighbors.erase(std::remove(neighbors.begin(), neighbors.end(), stops[stops.size() - 2]),
+                                neighbors.end());
+            }
+            if (neighbors.empty()) {
+                break;
+            }
+            stops.push_back(neighbors[Random(neighbors.size())]);
+        }
+        return stops;
+    }
+
+    // Обход прямоугольника кварталов по часовой стрелке; пусто, если город для него мал
+    std::vector<size_t> MakeLoop(size_t length) {
+        const size_t full_rows = settings_.stop_count / side_;
+        const size_t width = std::min(std::max<size_t>(1, (length - 1) / 4), side_ - 1);
+        const size_t height = std::min(std::max<size_t>(1, (length - 1) / 2 - width), full_rows == 0 ? 0 : full_rows - 1);
+        if (width == 0 || height == 0) {
+            return {};
+        }
+        const size_t row = Random(full_rows - height);
+        const size_t column = Random(side_ - width);
+        std::vector<size_t> stops;
+        for (size_t c = 0; c < width; ++c) {
+            stops.push_back(row * side_ + column + c);
+        }
+        for (size_t r = 0; r < height; ++r) {
+            stops.push_back((row + r) * side_ + column + width);
+        }
+        for (size_t c = width; c > 0; --c) {
+            stops.push_back((row + height) * side_ + column + c);
+        }
+        for (size_t r = height; r > 0; --r) {
+            stops.push_back((row + r) * side_ + column);
+        }
+        stops.push_back(stops.front());
+        return stops;
+    }
+
+    void AddRoad(size_t from, size_t to) {
+        auto& roads = roads_[from];
+        if (from == to || std::any_of(roads.begin(), roads.end(), [to](const auto& road) { return road.first == to; })) {
+            return;
+        }
+        const double detour = std::uniform_real_distribution<double>(1.1, 1.5)(generator_);
+        const int distance = static_cast<int>(std::lround(geo::ComputeDistance(coordinates_[from], coordinates_[to]) * detour));
+        roads.emplace_back(to, std::max(distance, 1));
+    }
+
+    void AddExtraRoads() {
+        const auto whole = static_cast<size_t>(settings_.distance_density);
+        const double fraction = settings_.distance_density - static_cast<double>(whole);
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        for (size_t stop = 0; stop < settings_.stop_count; ++stop) {
+            const size_t target = whole + (chance(generator_) < fraction ? 1 : 0);
+            const std::vector<size_t> neighbors = GetNeighbors(stop);
+            for (size_t attempt = 0; roads_[stop].size() < target && attempt < 2 * neighbors.size(); ++attempt) {
+                AddRoad(stop, neighbors[Random(neighbors.size())]);
+            }
+        }
+    }
+};
+
+} // namespace
+
+std::string GenerateBaseDocument(const CitySettings& settings) {
+    return City(settings).ToJson();
+}
+
+std::string GenerateStatRequests(const CitySettings& city, const WorkloadSettings& workload) {
+    std::mt19937 generator(workload.seed);
+    std::uniform_int_distribution<size_t> stop_index(0, city.stop_count - 1);
+    std::uniform_int_distribution<size_t> bus_index(0, city.bus_count - 1);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    enum class Type { BUS, STOP, ROUTE, MAP };
+    std::vector<Type> types(std::min(workload.map_count, workload.request_count), Type::MAP);
+    while (types.size() < workload.request_count) {
+        const double value = chance(generator);
+        types.push_back(value < workload.bus_share                       ? Type::BUS
+                        : value < workload.bus_share + workload.stop_share ? Type::STOP
+                                                                           : Type::ROUTE);
+    }
+    std::shuffle(types.begin(), types.end(), generator);
+
+    std::ostringstream out;
+    out << "[";
+    for (size_t id = 0; id < types.size(); ++id) {
+        out << (id == 0 ? "" : ",") << "\n" << R"({"id": )" << id;
+        switch (types[id]) {
+        case Type::BUS:
+            out << R"(, "type": "Bus", "name": "Bus )" << bus_index(generator) << R"("})";
+            break;
+        case Type::STOP:
+            out << R"(, "type": "Stop", "name": "Stop )" << stop_index(generator) << R"("})";
+            break;
+        case Type::ROUTE:
+            out << R"(, "type": "Route", "from": "Stop )" << stop_index(generator) << R"(", "to": "Stop )"
+                << stop_index(generator) << R"("})";
+            break;
+        case Type::MAP:
+            out << R"(, "type": "Map"})";
+            break;
+        }
+    }
+    out << "]\n";
+    return out.str();
+}
+
+} // namespace city_generator
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Синтетический город для бенчмарков: остановки на сетке кварталов со случайным сдвигом,
+// некольцевые маршруты - случайные блуждания по соседним кварталам, кольцевые - обход
+// прямоугольника. Расстояния по дорогам - географические, умноженные на 1.1..1.5
+namespace city_generator {
+
+struct CitySettings {
+    size_t stop_count = 5000;
+    size_t bus_count = 500;
+    size_t min_route_length = 10;
+    size_t max_route_length = 40;
+    double round_trip_share = 0.5;
+    // Среднее число записей road_distances у остановки. Соседние остановки маршрутов
+    // получают расстояние всегда, остальное добирается расстояниями до соседних кварталов
+    double distance_density = 3.0;
+    uint32_t seed = 20;
+};
+
+struct WorkloadSettings {
+    size_t request_count = 2000;
+    // Доли запросов Bus и Stop; остальное - Route, кроме map_count запросов Map
+    double bus_share = 0.3;
+    double stop_share = 0.3;
+    size_t map_count = 2;
+    uint32_t seed = 21;
+};
+
+// Входной документ с base_requests, render_settings и routing_settings
+std::string GenerateBaseDocument(const CitySettings& settings);
+
+// Массив stat_requests по городу с такими настройками, запросы перемешаны
+std::string GenerateStatRequests(const CitySettings& city, const WorkloadSettings& workload);
+
+} // namespace city_generator
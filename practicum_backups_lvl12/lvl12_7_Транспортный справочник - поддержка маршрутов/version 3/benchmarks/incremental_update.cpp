@@ -0,0 +1,152 @@
+// Правка роутера на месте против полной перестройки графа: случайные изменения расстояний,
+// замена и удаление маршрутов, смена времени ожидания. После серии правок ответы сверяются
+// с роутером, построенным заново. Число остановок и маршрутов - первый и второй аргументы,
+// по умолчанию 5000 и 500.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/incremental_update.cpp transport_router.cpp
+//       transport_catalogue.cpp geo.cpp domain.cpp -o incremental_update
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using transport_catalogue::TransportCatalogue;
+
+template <typename Action>
+double Measure(Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<const transport_catalogue::Stop*> MakeBusStops(const TransportCatalogue& catalogue,
+                                                          std::mt19937& generator) {
+    std::uniform_int_distribution<size_t> stop_index(0, catalogue.GetAllStops().size() - 1);
+    std::vector<const transport_catalogue::Stop*> stops(15);
+    for (auto& stop : stops) {
+        stop = &catalogue.GetAllStops()[stop_index(generator)];
+    }
+    return stops;
+}
+
+void SetRandomDistances(TransportCatalogue& catalogue, const std::vector<const transport_catalogue::Stop*>& stops,
+                        std::mt19937& generator) {
+    std::uniform_int_distribution<int> distance(300, 3000);
+    for (size_t i = 1; i < stops.size(); ++i) {
+        catalogue.SetDistance(stops[i - 1], stops[i], distance(generator));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    const size_t bus_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    std::mt19937 generator(16);
+
+    TransportCatalogue catalogue;
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {55.5 + i % 100 * 0.005, 37.3 + i / 100 * 0.005});
+    }
+    for (size_t i = 0; i < bus_count; ++i) {
+        const auto stops = MakeBusStops(catalogue, generator);
+        SetRandomDistances(catalogue, stops, generator);
+        catalogue.AddBus("Bus " + std::to_string(i), stops, i % 2 == 0);
+    }
+
+    const transport::RouterSettings settings{6, 40.0};
+    transport::Router router(settings, catalogue);
+    std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+    const auto stop_name = [&catalogue](size_t index) -> const std::string& {
+        return catalogue.GetAllStops()[index].name;
+    };
+
+    // Заполняем кэш деревьев путей
+    for (size_t i = 0; i < settings.route_cache_capacity; ++i) {
+        router.GetRouteInfo(stop_name(i), stop_name(stop_index(generator)));
+    }
+
+    // Новое расстояние меняет время поездок всех маршрутов через остановку
+    const auto update_buses_at = [&](const transport_catalogue::Stop* stop) {
+        for (const auto* stop_bus : catalogue.GetBusesByStop(stop)) {
+            router.UpdateBusTimes(catalogue, stop_bus->name);
+        }
+    };
+
+    constexpr int UPDATE_COUNT = 200;
+    size_t next_bus = bus_count;
+    int bus_wait_time = settings.bus_wait_time;
+    double update_time = 0.0;
+    for (int update = 0; update < UPDATE_COUNT; ++update) {
+        const auto& buses = catalogue.GetAllBuses();
+        const std::string bus_name = buses[std::uniform_int_distribution<size_t>(0, buses.size() - 1)(generator)].name;
+        switch (update % 4) {
+        case 0: {
+            // Новое расстояние на перегоне существующего маршрута
+            const auto* bus = catalogue.FindBus(bus_name);
+            const auto* from = bus->stops[0];
+            catalogue.SetDistance(from, bus->stops[1], std::uniform_int_distribution<int>(100, 5000)(generator));
+            update_time += Measure([&] { update_buses_at(from); });
+            break;
+        }
+        case 1:
+            catalogue.RemoveBus(bus_name);
+            update_time += Measure([&] { router.RemoveBus(bus_name); });
+            break;
+        case 2: {
+            const auto stops = MakeBusStops(catalogue, generator);
+            SetRandomDistances(catalogue, stops, generator);
+            const std::string name = "Bus " + std::to_string(next_bus++);
+            catalogue.AddBus(name, stops, update % 8 == 2);
+            update_time += Measure([&] {
+                for (const auto* stop : stops) {
+                    update_buses_at(stop);
+                }
+            });
+            break;
+        }
+        default:
+            bus_wait_time = update % 8 == 3 ? 5 : 6;
+            update_time += Measure([&] { router.SetBusWaitTime(bus_wait_time); });
+            break;
+        }
+        update_time += Measure([&] { router.RefreshHeuristic(catalogue); });
+        // Запросы между правками держат в кэше деревья тех же остановок
+        for (int i = 0; i < 4; ++i) {
+            router.GetRouteInfo(stop_name(stop_index(generator) % settings.route_cache_capacity),
+                                stop_name(stop_index(generator)));
+        }
+    }
+    std::cout << "Incremental update: " << update_time / UPDATE_COUNT * 1e3 << " ms/update" << std::endl;
+
+    transport::RouterSettings rebuilt_settings = settings;
+    rebuilt_settings.bus_wait_time = bus_wait_time;
+    std::unique_ptr<transport::Router> rebuilt;
+    std::cout << "Full rebuild: " << Measure([&] {
+        rebuilt = std::make_unique<transport::Router>(rebuilt_settings, catalogue);
+    }) * 1e3 << " ms" << std::endl;
+
+    // Сверяем пути от остановок, деревья которых могли остаться в кэше, и случайные пары
+    size_t mismatches = 0;
+    for (size_t i = 0; i < 2000; ++i) {
+        const std::string& from = stop_name(i % 2 == 0 ? i / 2 % settings.route_cache_capacity : stop_index(generator));
+        const std::string& to = stop_name(stop_index(generator));
+        const auto expected = rebuilt->GetRouteInfo(from, to);
+        const auto actual = router.GetRouteInfo(from, to);
+        if (expected.has_value() != actual.has_value()
+            || (expected && std::abs(expected->total_time - actual->total_time) > 1e-9)) {
+            ++mismatches;
+        }
+    }
+    std::cout << "Mismatches: " << mismatches << std::endl;
+}
@@ -0,0 +1,137 @@
+// Время загрузки и уничтожения и пиковая память для json::Document и json::FlatDocument
+// на синтетическом base_requests. Размер входа в мегабайтах - первый аргумент, по умолчанию 50.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -I. benchmarks/json_flat.cpp json.cpp json_flat.cpp json_sax.cpp -o json_flat
+
+#include "json.h"
+#include "json_flat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+size_t current_bytes = 0;
+size_t peak_bytes = 0;
+
+// Перед каждым блоком хранится его размер, чтобы учитывать освобождение
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(size_t size) {
+    char* block = static_cast<char*>(std::malloc(size + HEADER_SIZE));
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    current_bytes += size;
+    peak_bytes = std::max(peak_bytes, current_bytes);
+    return block + HEADER_SIZE;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    char* block = static_cast<char*>(ptr) - HEADER_SIZE;
+    current_bytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace {
+
+std::string MakeBaseRequests(size_t target_size) {
+    std::string result = R"({"base_requests": [)";
+    size_t index = 0;
+    while (result.size() < target_size) {
+        result += R"({"type": "Stop", "name": "Stop number )" + std::to_string(index)
+            + R"(", "latitude": 55.611087, "longitude": 37.20829, "road_distances": {"Stop number )"
+            + std::to_string(index + 1) + R"(": 3900, "Stop number )" + std::to_string(index + 2) + R"(": 4100}},)";
+        if (++index % 20 == 0) {
+            result += R"({"type": "Bus", "name": "Bus )" + std::to_string(index)
+                + R"(", "stops": ["Stop number )" + std::to_string(index - 1) + R"(", "Stop number )"
+                + std::to_string(index - 2) + R"("], "is_roundtrip": false},)";
+        }
+    }
+    result.back() = ']';
+    result += '}';
+    return result;
+}
+
+template <typename Document, typename LoadFunction, typename ReadFunction>
+void Measure(std::string_view title, const std::string& input, LoadFunction load, ReadFunction read) {
+    using Clock = std::chrono::steady_clock;
+    const size_t bytes_before = current_bytes;
+    peak_bytes = current_bytes;
+
+    std::optional<Document> document;
+    const auto load_start = Clock::now();
+    document.emplace(load(input));
+    const std::chrono::duration<double> load_time = Clock::now() - load_start;
+
+    const auto read_start = Clock::now();
+    const size_t checksum = read(*document);
+    const std::chrono::duration<double> read_time = Clock::now() - read_start;
+
+    const auto destroy_start = Clock::now();
+    document.reset();
+    const std::chrono::duration<double> destroy_time = Clock::now() - destroy_start;
+
+    std::cout << title << ": load " << load_time.count() << " s, lookups " << read_time.count()
+              << " s, destroy " << destroy_time.count() << " s, peak "
+              << (peak_bytes - bytes_before) / (1 << 20) << " MB (checksum " << checksum << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t size_mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+    const std::string input = MakeBaseRequests(size_mb << 20);
+    std::cout << "Input: " << input.size() / (1 << 20) << " MB" << std::endl;
+
+    // Чтение как в JsonReader::LoadData: тип, имя и координаты каждого запроса
+    Measure<json::Document>("json::Document", input,
+        [](const std::string& text) {
+            return json::LoadJSON(text);
+        },
+        [](const json::Document& document) {
+            size_t checksum = 0;
+            for (const auto& request : document.GetRoot().AsMap().at("base_requests").AsArray()) {
+                const auto& request_map = request.AsMap();
+                checksum += request_map.at("name").AsString().size();
+                if (request_map.at("type").AsString() == "Stop") {
+                    checksum += static_cast<size_t>(request_map.at("latitude").AsDouble());
+                }
+            }
+            return checksum;
+        });
+
+    // Копия текста входит в замер: документ хранит его у себя
+    Measure<json::FlatDocument>("json::FlatDocument", input,
+        [](const std::string& text) {
+            return json::FlatDocument::Load(text);
+        },
+        [](const json::FlatDocument& document) {
+            size_t checksum = 0;
+            for (const auto request : document.GetRoot().AsMap().at("base_requests").AsArray()) {
+                const auto request_map = request.AsMap();
+                checksum += request_map.at("name").AsString().size();
+                if (request_map.at("type").AsString() == "Stop") {
+                    checksum += static_cast<size_t>(request_map.at("latitude").AsDouble());
+                }
+            }
+            return checksum;
+        });
+}
@@ -0,0 +1,106 @@
+// Скорость разбора большого base_requests: голый потоковый парсер, сборка дерева json::Node
+// и загрузка прямо в справочник через json_reader::StreamLoader.
+// Сборка из каталога version 3 (размер входа в мегабайтах - первый аргумент, по умолчанию 200):
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/json_parse.cpp json.cpp json_sax.cpp json_reader.cpp
+//       json_writer.cpp json_builder.cpp transport_catalogue.cpp transport_router.cpp raptor_router.cpp
+//       spatial_index.cpp map_renderer.cpp map_tiles.cpp svg.cpp request_stats.cpp geo.cpp domain.cpp
+//       -o json_parse
+
+#include "json.h"
+#include "json_reader.h"
+#include "json_sax.h"
+#include "transport_catalogue.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// Остановки с расстояниями до соседей и маршруты по ним, пока не наберётся target_size байт
+std::string MakeBaseRequests(size_t target_size) {
+    std::string result = R"({"base_requests": [)";
+    result.reserve(target_size + 1024);
+    size_t stop_index = 0;
+    while (result.size() < target_size) {
+        for (size_t i = 0; i < 100; ++i, ++stop_index) {
+            result += R"({"type": "Stop", "name": "Stop number )" + std::to_string(stop_index)
+                + R"(", "latitude": 55.)" + std::to_string(100000 + stop_index % 900000)
+                + R"(, "longitude": 37.)" + std::to_string(100000 + (stop_index * 7) % 900000)
+                + R"(, "road_distances": {"Stop number )" + std::to_string(stop_index + 1)
+                + R"(": )" + std::to_string(500 + stop_index % 1000) + R"(}},)";
+        }
+        result += R"({"type": "Bus", "name": "Bus )" + std::to_string(stop_index) + R"(", "stops": [)";
+        for (size_t i = stop_index - 100; i < stop_index; ++i) {
+            result += R"("Stop number )" + std::to_string(i) + R"(", )";
+        }
+        result += R"("Stop number )" + std::to_string(stop_index) + R"("], "is_roundtrip": false},)";
+    }
+    result.back() = ']';
+    result += R"(, "routing_settings": {"bus_wait_time": 6, "bus_velocity": 40}})";
+    return result;
+}
+
+// Обработчик, который только считает события
+class CountingHandler final : public json::Handler {
+public:
+    size_t events = 0;
+
+    void OnNull() override { ++events; }
+    void OnBool(bool) override { ++events; }
+    void OnInt(int) override { ++events; }
+    void OnDouble(double) override { ++events; }
+    void OnString(std::string_view) override { ++events; }
+    void OnStartDict() override { ++events; }
+    void OnKey(std::string_view) override { ++events; }
+    void OnEndDict() override { ++events; }
+    void OnStartArray() override { ++events; }
+    void OnEndArray() override { ++events; }
+};
+
+template <typename Action>
+void Measure(std::string_view title, size_t input_size, Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    std::cout << title << ": " << duration.count() << " s, "
+              << input_size / duration.count() / (1 << 20) << " MB/s" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t size_mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const std::string input = MakeBaseRequests(size_mb << 20);
+    std::cout << "Input: " << input.size() / (1 << 20) << " MB" << std::endl;
+
+    Measure("SAX, string", input.size(), [&] {
+        CountingHandler handler;
+        json::Parse(std::string_view(input), handler);
+        std::cout << "  events: " << handler.events << std::endl;
+    });
+
+    Measure("SAX, istream", input.size(), [&] {
+        std::istringstream stream(input);
+        CountingHandler handler;
+        json::Parse(stream, handler);
+    });
+
+    Measure("DOM, json::Load", input.size(), [&] {
+        std::istringstream stream(input);
+        const json::Document document = json::Load(stream);
+        std::cout << "  base_requests: " << document.GetRoot().AsMap().at("base_requests").AsArray().size() << std::endl;
+    });
+
+    Measure("StreamLoader into catalogue", input.size(), [&] {
+        std::istringstream stream(input);
+        transport_catalogue::TransportCatalogue catalogue;
+        json_reader::StreamLoader loader(catalogue);
+        json::Parse(stream, loader);
+        std::cout << "  stops: " << catalogue.GetAllStops().size()
+                  << ", buses: " << catalogue.GetAllBuses().size() << std::endl;
+    });
+}
@@ -0,0 +1,92 @@
+// Вывод ответов на stat_requests: сборка дерева через json::Builder с json::Print
+// против записи сразу в поток через json::Writer. Число ответов - первый аргумент, по умолчанию 200000.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -I. benchmarks/json_write.cpp json.cpp json_builder.cpp json_writer.cpp json_sax.cpp -o json_write
+
+#include "json.h"
+#include "json_builder.h"
+#include "json_writer.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// Ответы трёх видов по очереди, как в типичном stat_requests: Bus, Stop и Route
+template <typename Builder>
+void WriteResponses(Builder& builder, int count) {
+    builder.StartArray();
+    for (int id = 0; id < count; ++id) {
+        if (id % 3 == 0) {
+            builder.StartDict()
+                .Key("curvature").Value(1.2345678 + id)
+                .Key("request_id").Value(id)
+                .Key("route_length").Value(5950 + id)
+                .Key("stop_count").Value(6)
+                .Key("unique_stop_count").Value(5)
+                .EndDict();
+        } else if (id % 3 == 1) {
+            builder.StartDict()
+                .Key("buses").StartArray()
+                    .Value("14").Value("22k").Value("297")
+                .EndArray()
+                .Key("request_id").Value(id)
+                .EndDict();
+        } else {
+            builder.StartDict().Key("items").StartArray();
+            for (int i = 0; i < 4; ++i) {
+                builder.StartDict()
+                    .Key("stop_name").Value("Biryulyovo Zapadnoye")
+                    .Key("time").Value(6)
+                    .Key("type").Value("Wait")
+                    .EndDict();
+                builder.StartDict()
+                    .Key("bus").Value("297")
+                    .Key("span_count").Value(2)
+                    .Key("time").Value(5.235 + i)
+                    .Key("type").Value("Bus")
+                    .EndDict();
+            }
+            builder.EndArray()
+                .Key("request_id").Value(id)
+                .Key("total_time").Value(24.21)
+                .EndDict();
+        }
+    }
+    builder.EndArray();
+}
+
+template <typename Action>
+void Measure(std::string_view title, Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::string output = action();
+    const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    std::cout << title << ": " << duration.count() << " s, " << output.size() / (1 << 20) << " MB" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    Measure("json::Builder + json::Print", [count] {
+        json::Builder builder;
+        WriteResponses(builder, count);
+        std::ostringstream output;
+        json::Print(builder.Build(), output, 4);
+        return output.str();
+    });
+
+    Measure("json::Writer", [count] {
+        std::ostringstream output;
+        {
+            json::Writer writer(output, {true, 4, 6});
+            WriteResponses(writer, count);
+        }
+        return output.str();
+    });
+}
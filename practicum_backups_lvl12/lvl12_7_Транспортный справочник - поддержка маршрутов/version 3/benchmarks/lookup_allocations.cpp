@@ -0,0 +1,105 @@
+// Считает выделения памяти на один запрос Stop, Bus и Route к справочнику и роутеру.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/lookup_allocations.cpp transport_catalogue.cpp
+//       transport_router.cpp allocation_counter.cpp geo.cpp domain.cpp -o lookup_allocations
+
+#include "allocation_counter.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr size_t STOP_COUNT = 500;
+constexpr size_t BUS_COUNT = 50;
+constexpr size_t STOPS_PER_BUS = 20;
+constexpr size_t REQUEST_COUNT = 100000;
+
+// Имена длиннее буфера короткой строки, чтобы каждая временная std::string выделяла память
+std::string MakeStopName(size_t index) {
+    return "Stop with a rather long name number " + std::to_string(index);
+}
+
+std::string MakeBusName(size_t index) {
+    return "Bus with a rather long name number " + std::to_string(index);
+}
+
+void FillCatalogue(transport_catalogue::TransportCatalogue& catalogue) {
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop(MakeStopName(i), {55.0 + i * 0.001, 37.0 + (i % 17) * 0.001});
+    }
+    for (size_t bus = 0; bus < BUS_COUNT; ++bus) {
+        std::vector<const transport_catalogue::Stop*> stops;
+        for (size_t i = 0; i < STOPS_PER_BUS; ++i) {
+            stops.push_back(catalogue.FindStop(MakeStopName((bus * 7 + i * 13) % STOP_COUNT)));
+        }
+        for (size_t i = 1; i < stops.size(); ++i) {
+            catalogue.SetDistance(stops[i - 1], stops[i], 500 + static_cast<int>(i) * 10);
+        }
+        catalogue.AddBus(MakeBusName(bus), stops, bus % 2 == 0);
+    }
+}
+
+template <typename Request>
+void Measure(std::string_view title, size_t count, Request request) {
+    const uint64_t allocations_before = allocation_counter::GetThreadAllocationCount();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        request(i);
+    }
+    const auto duration = std::chrono::steady_clock::now() - start;
+    const uint64_t allocations = allocation_counter::GetThreadAllocationCount() - allocations_before;
+    std::cout << title << ": "
+              << static_cast<double>(allocations) / count << " allocations/request, "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / count << " ns/request"
+              << std::endl;
+}
+
+} // namespace
+
+int main() {
+    transport_catalogue::TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    const transport::Router router({6, 40.0}, catalogue);
+
+    // Имена запросов готовятся заранее, как если бы они уже лежали в разобранном JSON
+    std::vector<std::string> stop_names;
+    std::vector<std::string> bus_names;
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        stop_names.push_back(MakeStopName(i));
+    }
+    for (size_t i = 0; i < BUS_COUNT; ++i) {
+        bus_names.push_back(MakeBusName(i));
+    }
+    // Первый запрос строит отсортированные индексы справочника
+    catalogue.GetBusesByStop(stop_names.front());
+
+    size_t checksum = 0;
+    Measure("Stop", REQUEST_COUNT, [&](size_t i) {
+        for (const auto* bus : catalogue.GetBusesByStop(stop_names[i % STOP_COUNT])) {
+            checksum += bus->name.size();
+        }
+    });
+    Measure("Bus", REQUEST_COUNT, [&](size_t i) {
+        checksum += catalogue.GetBusInfo(bus_names[i % BUS_COUNT], static_cast<int>(i)).stop_count;
+    });
+
+    // Маршруты из нескольких остановок отправления, чтобы деревья путей были в кэше роутера
+    constexpr size_t ROUTE_SOURCES = 16;
+    for (size_t i = 0; i < ROUTE_SOURCES; ++i) {
+        router.GetRouteInfo(stop_names[i], stop_names[0]);
+    }
+    Measure("Route (cached source)", REQUEST_COUNT, [&](size_t i) {
+        if (const auto route = router.GetRouteInfo(stop_names[i % ROUTE_SOURCES], stop_names[i % STOP_COUNT])) {
+            checksum += route->items.size();
+        }
+    });
+
+    std::cout << "checksum: " << checksum << std::endl;
+}
@@ -0,0 +1,71 @@
+// Время отрисовки карты MapRenderer на синтетическом городе. Первый аргумент - число
+// остановок (по умолчанию 20000), маршрутов в десять раз меньше, по 30 остановок в каждом.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/map_render.cpp map_renderer.cpp svg.cpp
+//       transport_catalogue.cpp json.cpp json_sax.cpp geo.cpp domain.cpp -o map_render
+
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void FillCatalogue(transport_catalogue::TransportCatalogue& catalogue, size_t stop_count) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> latitude(55.5, 56.0);
+    std::uniform_real_distribution<double> longitude(37.3, 37.9);
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {latitude(generator), longitude(generator)});
+    }
+
+    std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+    std::vector<const transport_catalogue::Stop*> stops;
+    for (size_t i = 0; i < stop_count / 10; ++i) {
+        stops.clear();
+        for (size_t j = 0; j < 30; ++j) {
+            stops.push_back(catalogue.FindStop("Stop " + std::to_string(stop_index(generator))));
+        }
+        catalogue.AddBus("Bus " + std::to_string(i), stops, i % 2 == 0);
+    }
+}
+
+map_renderer::RenderSettings MakeSettings() {
+    map_renderer::RenderSettings settings;
+    settings.width = 1200;
+    settings.height = 1200;
+    settings.padding = 50;
+    settings.line_width = 14;
+    settings.stop_radius = 5;
+    settings.bus_label_font_size = 20;
+    settings.bus_label_offset = {7, 15};
+    settings.stop_label_font_size = 20;
+    settings.stop_label_offset = {7, -3};
+    settings.underlayer_color = svg::Rgba{255, 255, 255, 0.85};
+    settings.underlayer_width = 3;
+    settings.color_palette = {std::string("green"), svg::Rgb{255, 160, 0}, std::string("red")};
+    settings.render_stops = true;
+    return settings;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    transport_catalogue::TransportCatalogue catalogue;
+    FillCatalogue(catalogue, stop_count);
+    const map_renderer::MapRenderer renderer(catalogue, MakeSettings());
+
+    for (int i = 0; i < 3; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        const std::string svg = renderer.Render();
+        const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+        std::cout << "Render: " << duration.count() << " s, " << svg.size() / (1 << 10) << " KiB" << std::endl;
+    }
+}
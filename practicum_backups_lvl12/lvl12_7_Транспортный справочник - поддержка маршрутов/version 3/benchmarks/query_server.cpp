@@ -0,0 +1,136 @@
+// Пропускная способность режима serve: поток JSON-запросов Bus, Stop и Route по снимку
+// синтетического города обрабатывается QueryServer с одним потоком и с потоками по числу ядер.
+// Ответы обоих прогонов сверяются построчно. Число остановок и запросов - аргументы,
+// по умолчанию 2000 и 5000.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/query_server.cpp query_server.cpp json_reader.cpp
+//       json_writer.cpp json.cpp json_sax.cpp serialization.cpp map_renderer.cpp map_tiles.cpp
+//       spatial_index.cpp svg.cpp raptor_router.cpp transport_router.cpp transport_catalogue.cpp
+//       request_stats.cpp allocation_counter.cpp geo.cpp domain.cpp -o query_server
+
+#include "query_server.h"
+#include "serialization.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Action>
+double Measure(Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+map_renderer::RenderSettings MakeSettings() {
+    map_renderer::RenderSettings settings;
+    settings.width = 1200;
+    settings.height = 1200;
+    settings.padding = 50;
+    settings.line_width = 14;
+    settings.stop_radius = 5;
+    settings.bus_label_font_size = 20;
+    settings.bus_label_offset = {7, 15};
+    settings.stop_label_font_size = 20;
+    settings.stop_label_offset = {7, -3};
+    settings.underlayer_color = svg::Rgba{255, 255, 255, 0.85};
+    settings.underlayer_width = 3;
+    settings.color_palette = {std::string("green"), svg::Rgb{255, 160, 0}, std::string("red")};
+    settings.render_stops = true;
+    return settings;
+}
+
+void WriteSnapshot(const std::string& file, size_t stop_count) {
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+    std::uniform_int_distribution<int> distance(300, 3000);
+
+    transport_catalogue::TransportCatalogue catalogue;
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {55.5 + i % 100 * 0.005, 37.3 + i / 100 * 0.005});
+    }
+    for (size_t i = 0; i < stop_count / 10; ++i) {
+        std::vector<const transport_catalogue::Stop*> stops(30);
+        for (auto& stop : stops) {
+            stop = &catalogue.GetAllStops()[stop_index(generator)];
+        }
+        for (size_t j = 1; j < stops.size(); ++j) {
+            catalogue.SetDistance(stops[j - 1], stops[j], distance(generator));
+        }
+        catalogue.AddBus("Bus " + std::to_string(i), stops, i % 2 == 0);
+    }
+
+    const transport::Router router(transport::RouterSettings{6, 40.0}, catalogue);
+    std::ofstream out(file, std::ios::binary);
+    serialization::SaveSnapshot(out, catalogue, MakeSettings(), router);
+}
+
+std::string MakeRequests(size_t stop_count, size_t request_count) {
+    std::mt19937 generator(19);
+    std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+    std::uniform_int_distribution<size_t> bus_index(0, stop_count / 10 - 1);
+    std::ostringstream requests;
+    for (size_t i = 0; i < request_count; ++i) {
+        requests << "{\"id\": " << i;
+        switch (i % 4) {
+        case 0:
+            requests << ", \"type\": \"Bus\", \"name\": \"Bus " << bus_index(generator) << "\"}\n";
+            break;
+        case 1:
+            requests << ", \"type\": \"Stop\", \"name\": \"Stop " << stop_index(generator) << "\"}\n";
+            break;
+        default:
+            requests << ", \"type\": \"Route\", \"from\": \"Stop " << stop_index(generator)
+                     << "\", \"to\": \"Stop " << stop_index(generator) << "\"}\n";
+        }
+    }
+    return requests.str();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const size_t request_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000;
+    const std::string snapshot_file = "query_server_benchmark.bin";
+    WriteSnapshot(snapshot_file, stop_count);
+    const std::string requests = MakeRequests(stop_count, request_count);
+
+    std::vector<std::string> outputs;
+    for (const size_t thread_count : {size_t{1}, size_t{0}}) {
+        query_server::QueryServer server({snapshot_file, "", thread_count});
+        std::istringstream input(requests);
+        std::ostringstream output;
+        const double seconds = Measure([&] { server.Serve(input, output); });
+        std::cout << (thread_count == 0 ? std::thread::hardware_concurrency() : thread_count) << " thread(s): "
+                  << request_count / seconds << " requests/s" << std::endl;
+        outputs.push_back(output.str());
+    }
+    std::remove(snapshot_file.c_str());
+
+    std::istringstream single(outputs[0]);
+    std::istringstream parallel(outputs[1]);
+    size_t mismatches = 0;
+    size_t line_count = 0;
+    for (std::string lhs, rhs; std::getline(single, lhs);) {
+        ++line_count;
+        if (!std::getline(parallel, rhs) || lhs != rhs) {
+            ++mismatches;
+        }
+    }
+    if (line_count != request_count) {
+        mismatches += line_count > request_count ? line_count - request_count : request_count - line_count;
+    }
+    std::cout << "Mismatches: " << mismatches << std::endl;
+}
@@ -0,0 +1,97 @@
+// Поиск по раундам (RaptorRouter) против Дейкстры по графу Router без кэша деревьев путей.
+// Заодно сверяет время самого быстрого варианта с маршрутом Router. Число остановок, маршрутов
+// и остановок в маршруте - аргументы, по умолчанию 5000, 500 и 30.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/raptor_route.cpp raptor_router.cpp transport_router.cpp
+//       transport_catalogue.cpp geo.cpp domain.cpp -o raptor_route
+
+#include "raptor_router.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename Action>
+double Measure(Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    const size_t bus_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    const size_t bus_length = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 30;
+    std::mt19937 generator(17);
+    std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+    std::uniform_int_distribution<int> distance(300, 3000);
+
+    transport_catalogue::TransportCatalogue catalogue;
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {55.5 + i % 100 * 0.005, 37.3 + i / 100 * 0.005});
+    }
+    for (size_t i = 0; i < bus_count; ++i) {
+        std::vector<const transport_catalogue::Stop*> stops(bus_length);
+        for (auto& stop : stops) {
+            stop = &catalogue.GetAllStops()[stop_index(generator)];
+        }
+        for (size_t j = 1; j < stops.size(); ++j) {
+            catalogue.SetDistance(stops[j - 1], stops[j], distance(generator));
+        }
+        catalogue.AddBus("Bus " + std::to_string(i), stops, i % 2 == 0);
+    }
+
+    transport::RouterSettings settings{6, 40.0};
+    settings.route_cache_capacity = 0;
+    std::unique_ptr<transport::Router> router;
+    std::optional<transport::RaptorRouter> raptor;
+    std::cout << "Build graph: " << Measure([&] {
+        router = std::make_unique<transport::Router>(settings, catalogue);
+    }) * 1e3 << " ms" << std::endl;
+    std::cout << "Build RAPTOR: " << Measure([&] { raptor.emplace(settings, catalogue); }) * 1e3 << " ms" << std::endl;
+
+    constexpr int QUERY_COUNT = 200;
+    std::vector<std::pair<std::string, std::string>> queries;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        queries.emplace_back(catalogue.GetAllStops()[stop_index(generator)].name,
+                             catalogue.GetAllStops()[stop_index(generator)].name);
+    }
+
+    std::vector<std::optional<double>> graph_times(QUERY_COUNT);
+    std::cout << "Graph Dijkstra: " << Measure([&] {
+        for (int i = 0; i < QUERY_COUNT; ++i) {
+            if (const auto route = router->GetRouteInfo(queries[i].first, queries[i].second)) {
+                graph_times[i] = route->total_time;
+            }
+        }
+    }) / QUERY_COUNT * 1e3 << " ms/query" << std::endl;
+
+    size_t mismatches = 0;
+    size_t option_count = 0;
+    std::cout << "RAPTOR options: " << Measure([&] {
+        for (int i = 0; i < QUERY_COUNT; ++i) {
+            const auto options = raptor->FindRouteOptions(queries[i].first, queries[i].second);
+            option_count += options.size();
+            if (options.empty() != !graph_times[i]
+                || (!options.empty() && queries[i].first != queries[i].second
+                    && std::abs(options.back().route.total_time - *graph_times[i]) > 1e-9)) {
+                ++mismatches;
+            }
+        }
+    }) / QUERY_COUNT * 1e3 << " ms/query" << std::endl;
+
+    std::cout << "Options per query: " << static_cast<double>(option_count) / QUERY_COUNT << std::endl;
+    std::cout << "Mismatches: " << mismatches << std::endl;
+}
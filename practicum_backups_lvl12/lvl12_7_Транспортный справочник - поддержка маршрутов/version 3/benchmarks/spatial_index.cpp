@@ -0,0 +1,107 @@
+// Поиск ближайших остановок и остановок в прямоугольнике: StopSpatialIndex против полного
+// перебора. Заодно сверяет ответы. Число остановок - первый аргумент, по умолчанию 50000.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/spatial_index.cpp spatial_index.cpp
+//       transport_catalogue.cpp geo.cpp domain.cpp -o spatial_index
+
+#include "spatial_index.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<transport_catalogue::NearbyStop> FindNearestByScan(const transport_catalogue::TransportCatalogue& catalogue,
+                                                               geo::Coordinates point, size_t count) {
+    std::vector<transport_catalogue::NearbyStop> all;
+    for (const auto& stop : catalogue.GetAllStops()) {
+        all.push_back({&stop, geo::ComputeDistance(point, stop.coordinates)});
+    }
+    count = std::min(count, all.size());
+    std::partial_sort(all.begin(), all.begin() + count, all.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.distance < rhs.distance;
+    });
+    all.resize(count);
+    return all;
+}
+
+size_t CountInAreaByScan(const transport_catalogue::TransportCatalogue& catalogue, geo::Coordinates min,
+                         geo::Coordinates max) {
+    return std::count_if(catalogue.GetAllStops().begin(), catalogue.GetAllStops().end(), [&](const auto& stop) {
+        return stop.coordinates.lat >= min.lat && stop.coordinates.lat <= max.lat
+            && stop.coordinates.lng >= min.lng && stop.coordinates.lng <= max.lng;
+    });
+}
+
+template <typename Action>
+double Measure(Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> latitude(55.5, 56.0);
+    std::uniform_real_distribution<double> longitude(37.3, 37.9);
+
+    transport_catalogue::TransportCatalogue catalogue;
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {latitude(generator), longitude(generator)});
+    }
+
+    std::optional<transport_catalogue::StopSpatialIndex> index;
+    std::cout << "Build: " << Measure([&] { index.emplace(catalogue); }) << " s" << std::endl;
+
+    constexpr int QUERY_COUNT = 1000;
+    std::vector<geo::Coordinates> points;
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        points.push_back({latitude(generator), longitude(generator)});
+    }
+
+    size_t mismatches = 0;
+    std::vector<std::vector<transport_catalogue::NearbyStop>> answers(QUERY_COUNT);
+    std::cout << "Nearest 5, index: " << Measure([&] {
+        for (int i = 0; i < QUERY_COUNT; ++i) {
+            answers[i] = index->FindNearest(points[i], 5);
+        }
+    }) / QUERY_COUNT * 1e6 << " us/query" << std::endl;
+    std::cout << "Nearest 5, scan: " << Measure([&] {
+        for (int i = 0; i < QUERY_COUNT; ++i) {
+            const auto expected = FindNearestByScan(catalogue, points[i], 5);
+            for (size_t j = 0; j < expected.size(); ++j) {
+                mismatches += expected[j].distance != answers[i][j].distance;
+            }
+        }
+    }) / QUERY_COUNT * 1e6 << " us/query" << std::endl;
+
+    std::vector<size_t> area_sizes(QUERY_COUNT);
+    const auto area_of = [&points](int i) {
+        return std::pair{geo::Coordinates{points[i].lat - 0.01, points[i].lng - 0.01},
+                         geo::Coordinates{points[i].lat + 0.01, points[i].lng + 0.02}};
+    };
+    std::cout << "Area, index: " << Measure([&] {
+        for (int i = 0; i < QUERY_COUNT; ++i) {
+            const auto [min, max] = area_of(i);
+            area_sizes[i] = index->FindInArea(min, max).size();
+        }
+    }) / QUERY_COUNT * 1e6 << " us/query" << std::endl;
+    std::cout << "Area, scan: " << Measure([&] {
+        for (int i = 0; i < QUERY_COUNT; ++i) {
+            const auto [min, max] = area_of(i);
+            mismatches += CountInAreaByScan(catalogue, min, max) != area_sizes[i];
+        }
+    }) / QUERY_COUNT * 1e6 << " us/query" << std::endl;
+
+    std::cout << "Mismatches: " << mismatches << std::endl;
+}
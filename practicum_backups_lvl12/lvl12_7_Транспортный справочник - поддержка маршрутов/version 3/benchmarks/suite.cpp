@@ -0,0 +1,233 @@
+// Сквозной бенчмарк на синтетическом городе (city_generator): загрузка base_requests через
+// StreamLoader, построение графа роутера, смешанный поток stat_requests через JsonReader
+// (время по типам запросов - request_stats), отдельные запросы transport::Router, отрисовка
+// карты MapRenderer и пиковый объём памяти процесса. Отчёт - JSON в стандартный вывод.
+// Параметры - аргументы вида ключ=значение: stops, buses, min_length, max_length,
+// round_share, density, requests, route_queries, seed и thresholds - файл с порогами
+// {"max": {"метрика": значение}, "min": {...}}. При выходе метрики за порог код возврата 1.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/suite.cpp benchmarks/city_generator.cpp json.cpp
+//       json_sax.cpp json_reader.cpp json_writer.cpp json_builder.cpp transport_catalogue.cpp
+//       transport_router.cpp raptor_router.cpp spatial_index.cpp map_renderer.cpp map_tiles.cpp
+//       svg.cpp request_stats.cpp allocation_counter.cpp geo.cpp domain.cpp -o suite
+// Пример: ./suite thresholds=benchmarks/suite_thresholds.json
+// Пороги в suite_thresholds.json подобраны для города по умолчанию (5000 остановок, 500 маршрутов),
+// для других размеров их нужно задавать отдельно
+
+#include "city_generator.h"
+#include "json.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "map_renderer.h"
+#include "request_stats.h"
+#include "transport_catalogue.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+template <typename Action>
+double Measure(Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Пиковый резидентный объём процесса в мегабайтах, 0 - если неизвестен
+double GetPeakRssMb() {
+#if defined(__APPLE__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / double(1 << 20);  // Байты
+#elif defined(__unix__)
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / double(1 << 10);  // Килобайты
+#else
+    return 0.0;
+#endif
+}
+
+struct Options {
+    city_generator::CitySettings city;
+    city_generator::WorkloadSettings workload;
+    size_t route_queries = 500;
+    std::string thresholds_file;
+};
+
+Options ParseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view argument(argv[i]);
+        const size_t equals = argument.find('=');
+        if (equals == std::string_view::npos) {
+            throw std::invalid_argument("Expected key=value: " + std::string(argument));
+        }
+        const std::string_view key = argument.substr(0, equals);
+        const std::string value(argument.substr(equals + 1));
+        if (key == "stops") {
+            options.city.stop_count = std::stoul(value);
+        } else if (key == "buses") {
+            options.city.bus_count = std::stoul(value);
+        } else if (key == "min_length") {
+            options.city.min_route_length = std::stoul(value);
+        } else if (key == "max_length") {
+            options.city.max_route_length = std::stoul(value);
+        } else if (key == "round_share") {
+            options.city.round_trip_share = std::stod(value);
+        } else if (key == "density") {
+            options.city.distance_density = std::stod(value);
+        } else if (key == "requests") {
+            options.workload.request_count = std::stoul(value);
+        } else if (key == "route_queries") {
+            options.route_queries = std::stoul(value);
+        } else if (key == "seed") {
+            options.city.seed = static_cast<uint32_t>(std::stoul(value));
+            options.workload.seed = options.city.seed + 1;
+        } else if (key == "thresholds") {
+            options.thresholds_file = value;
+        } else {
+            throw std::invalid_argument("Unknown option: " + std::string(key));
+        }
+    }
+    if (options.city.stop_count < 2 || options.city.bus_count == 0 || options.city.min_route_length < 2
+        || options.city.max_route_length < options.city.min_route_length) {
+        throw std::invalid_argument("Need at least 2 stops, 1 bus and 2 <= min_length <= max_length");
+    }
+    return options;
+}
+
+// Метрики, вышедшие за пороги: "max" - верхние границы, "min" - нижние
+std::vector<std::string> FindRegressions(const std::map<std::string, double>& metrics, const json::Node& thresholds) {
+    std::vector<std::string> regressions;
+    for (const auto& [bound, is_upper] : {std::pair{"max", true}, std::pair{"min", false}}) {
+        const auto it = thresholds.AsMap().find(bound);
+        if (it == thresholds.AsMap().end()) {
+            continue;
+        }
+        for (const auto& [name, limit] : it->second.AsMap()) {
+            const auto metric = metrics.find(name);
+            if (metric == metrics.end()) {
+                regressions.push_back(name + ": no such metric");
+            } else if (is_upper ? metric->second > limit.AsDouble() : metric->second < limit.AsDouble()) {
+                regressions.push_back(name);
+            }
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+
+    const std::string base_document = city_generator::GenerateBaseDocument(options.city);
+    const json::Document stat_requests = json::LoadJSON(
+        city_generator::GenerateStatRequests(options.city, options.workload));
+    std::map<std::string, double> metrics;
+
+    transport_catalogue::TransportCatalogue catalogue;
+    json::Document input_data{json::Node{}};
+    metrics["load_ms"] = Measure([&] {
+        std::istringstream input(base_document);
+        json_reader::StreamLoader loader(catalogue);
+        json::Parse(input, loader);
+        input_data = loader.ExtractDocument();
+    }) * 1e3;
+    const auto& root = input_data.GetRoot().AsMap();
+
+    json_reader::JsonReader reader(catalogue);
+    reader.LoadRoutingSettings(root.at("routing_settings"));
+    metrics["graph_build_ms"] = Measure([&] { reader.GetRouter(); }) * 1e3;
+
+    const map_renderer::RenderSettings render_settings = map_renderer::ParseRenderSettings(root.at("render_settings"));
+    request_stats::RequestStats stats;
+    reader.SetRequestStats(&stats);
+    std::ostringstream responses;
+    const double stat_seconds = Measure([&] {
+        json::Writer writer(responses, {false, 0, 6});
+        reader.ProcessRequests(stat_requests.GetRoot(), render_settings, writer);
+    });
+    metrics["stat_requests_ms"] = stat_seconds * 1e3;
+    metrics["stat_requests_per_second"] = options.workload.request_count / stat_seconds;
+
+    // Отдельные запросы роутера между случайными остановками, с его обычным кэшем деревьев
+    std::mt19937 generator(options.workload.seed);
+    std::uniform_int_distribution<size_t> stop_index(0, catalogue.GetAllStops().size() - 1);
+    request_stats::LatencyHistogram route_latency;
+    size_t routes_found = 0;
+    for (size_t i = 0; i < options.route_queries; ++i) {
+        const auto& from = catalogue.GetAllStops()[stop_index(generator)].name;
+        const auto& to = catalogue.GetAllStops()[stop_index(generator)].name;
+        const auto start = std::chrono::steady_clock::now();
+        routes_found += reader.GetRouter().GetRouteInfo(from, to).has_value();
+        route_latency.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+    if (route_latency.GetCount() > 0) {
+        metrics["router_mean_us"] = route_latency.GetTotal() / 1e3 / route_latency.GetCount();
+        metrics["router_p50_us"] = route_latency.GetPercentile(0.5) / 1e3;
+        metrics["router_p99_us"] = route_latency.GetPercentile(0.99) / 1e3;
+    }
+
+    size_t svg_size = 0;
+    metrics["map_render_ms"] = Measure([&] {
+        svg_size = map_renderer::MapRenderer(catalogue, render_settings).Render().size();
+    }) * 1e3;
+    metrics["peak_rss_mb"] = GetPeakRssMb();
+
+    std::vector<std::string> regressions;
+    if (!options.thresholds_file.empty()) {
+        std::ifstream thresholds(options.thresholds_file);
+        if (!thresholds) {
+            std::cerr << "Cannot open thresholds file: " << options.thresholds_file << "\n";
+            return 2;
+        }
+        regressions = FindRegressions(metrics, json::Load(thresholds).GetRoot());
+    }
+
+    json::Writer writer(std::cout, {true, 0, 6});
+    writer.StartDict()
+        .Key("city").StartDict()
+            .Key("buses").Value(static_cast<int>(catalogue.GetAllBuses().size()))
+            .Key("input_mb").Value(base_document.size() / double(1 << 20))
+            .Key("road_distances").Value(static_cast<int>(catalogue.GetAllDistances().size()))
+            .Key("routes_found").Value(static_cast<int>(routes_found))
+            .Key("stops").Value(static_cast<int>(catalogue.GetAllStops().size()))
+            .Key("svg_kb").Value(svg_size / double(1 << 10))
+            .EndDict()
+        .Key("metrics").StartDict();
+    for (const auto& [name, value] : metrics) {
+        writer.Key(name).Value(value);
+    }
+    writer.EndDict().Key("regressions").StartArray();
+    for (const auto& regression : regressions) {
+        writer.Value(regression);
+    }
+    writer.EndArray().Key("stat_requests");
+    reader.WriteRequestStats(writer);
+    writer.EndDict();
+    writer.Flush();
+    std::cout << std::endl;
+    return regressions.empty() ? 0 : 1;
+}
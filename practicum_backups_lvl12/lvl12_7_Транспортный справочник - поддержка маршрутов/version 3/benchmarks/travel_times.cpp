@@ -0,0 +1,71 @@
+// Матрица времени в пути (Router::ComputeTravelTimes) в одном потоке и в нескольких, с проверкой,
+// что таблицы совпадают. Число остановок, маршрутов, источников и потоков - аргументы,
+// по умолчанию 5000, 500, 200 и число ядер.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. benchmarks/travel_times.cpp transport_router.cpp
+//       transport_catalogue.cpp geo.cpp domain.cpp -o travel_times
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Action>
+double Measure(Action action) {
+    const auto start = std::chrono::steady_clock::now();
+    action();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    const size_t bus_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    const size_t source_count = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+    const size_t thread_count = argc > 4 ? std::strtoul(argv[4], nullptr, 10)
+                                         : std::max(1u, std::thread::hardware_concurrency());
+    std::mt19937 generator(19);
+    std::uniform_int_distribution<size_t> stop_index(0, stop_count - 1);
+    std::uniform_int_distribution<int> distance(300, 3000);
+
+    transport_catalogue::TransportCatalogue catalogue;
+    for (size_t i = 0; i < stop_count; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {55.5 + i % 100 * 0.005, 37.3 + i / 100 * 0.005});
+    }
+    for (size_t i = 0; i < bus_count; ++i) {
+        std::vector<const transport_catalogue::Stop*> stops(30);
+        for (auto& stop : stops) {
+            stop = &catalogue.GetAllStops()[stop_index(generator)];
+        }
+        for (size_t j = 1; j < stops.size(); ++j) {
+            catalogue.SetDistance(stops[j - 1], stops[j], distance(generator));
+        }
+        catalogue.AddBus("Bus " + std::to_string(i), stops, i % 2 == 0);
+    }
+    const transport::Router router(transport::RouterSettings{6, 40.0}, catalogue);
+
+    std::vector<std::string_view> sources;
+    for (size_t i = 0; i < source_count; ++i) {
+        sources.push_back(catalogue.GetAllStops()[stop_index(generator)].name);
+    }
+
+    transport::TravelTimeTable single;
+    transport::TravelTimeTable parallel;
+    const double single_time = Measure([&] { single = router.ComputeTravelTimes(sources, 1); });
+    const double parallel_time = Measure([&] { parallel = router.ComputeTravelTimes(sources, thread_count); });
+    std::cout << "Threads 1: " << single_time * 1e3 << " ms" << std::endl;
+    std::cout << "Threads " << thread_count << ": " << parallel_time * 1e3 << " ms" << std::endl;
+    std::cout << "Speedup: " << single_time / parallel_time << std::endl;
+    std::cout << "Tables match: " << (single.times == parallel.times ? "yes" : "no") << std::endl;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Примитивы двоичной записи и чтения. Значения пишутся как есть, в порядке байт
+// текущей платформы: снимок переносим только между машинами одной архитектуры
+namespace binary_io {
+
+class FormatError : public std::runtime_error {
+public:
+    using runtime_error::runtime_error;
+};
+
+// Размер из повреждённых данных может быть огромным, поэтому массивы и строки растут
+// по мере чтения: такие данные заканчиваются FormatError, а не попыткой выделить терабайты
+inline constexpr size_t READ_CHUNK_BYTES = size_t{1} << 20;
+
+template <typename T>
+void WriteValue(std::ostream& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T ReadValue(std::istream& in) {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+    if constexpr (std::is_same_v<T, bool>) {
+        // Байт, отличный от 0 и 1, - не значение bool
+        const auto byte = ReadValue<uint8_t>(in);
+        if (byte > 1) {
+            throw FormatError("Invalid bool value");
+        }
+        return byte == 1;
+    } else {
+        T value{};
+        if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+            throw FormatError("Unexpected end of binary data");
+        }
+        return value;
+    }
+}
+
+inline void WriteSize(std::ostream& out, size_t size) {
+    WriteValue(out, static_cast<uint64_t>(size));
+}
+
+inline size_t ReadSize(std::istream& in) {
+    return static_cast<size_t>(ReadValue<uint64_t>(in));
+}
+
+inline void WriteString(std::ostream& out, const std::string& str) {
+    WriteSize(out, str.size());
+    out.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+inline std::string ReadString(std::istream& in) {
+    const size_t size = ReadSize(in);
+    std::string str;
+    while (str.size() < size) {
+        const size_t old_size = str.size();
+        str.resize(old_size + std::min(size - old_size, READ_CHUNK_BYTES));
+        if (!in.read(str.data() + old_size, static_cast<std::streamsize>(str.size() - old_size))) {
+            throw FormatError("Unexpected end of binary data");
+        }
+    }
+    return str;
+}
+
+template <typename T>
+void WriteVector(std::ostream& out, const std::vector<T>& values) {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+    WriteSize(out, values.size());
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+template <typename T>
+std::vector<T> ReadVector(std::istream& in) {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+    const size_t size = ReadSize(in);
+    std::vector<T> values;
+    while (values.size() < size) {
+        const size_t old_size = values.size();
+        values.resize(old_size + std::min(size - old_size, std::max<size_t>(1, READ_CHUNK_BYTES / sizeof(T))));
+        if (!in.read(reinterpret_cast<char*>(values.data() + old_size),
+                     static_cast<std::streamsize>((values.size() - old_size) * sizeof(T)))) {
+            throw FormatError("Unexpected end of binary data");
+        }
+    }
+    return values;
+}
+
+} // namespace binary_io
@@ -1,18 +1,25 @@
 #pragma once
 
+#include "binary_io.h"
 #include "ranges.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
 
 using VertexId = size_t;
 using EdgeId = size_t;
+// Идентификатор имени в таблице имён владельца графа (остановки, маршруты)
+using NameId = uint32_t;
 
 template <typename Weight>
 struct Edge {
-    std::string name;
+    NameId name_id;
     size_t span_count;
     VertexId from;
     VertexId to;
@@ -23,21 +30,54 @@ template <typename Weight>
 class DirectedWeightedGraph {
 private:
     using IncidenceList = std::vector<EdgeId>;
-    using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+    using IncidentEdgesRange = ranges::Range<const EdgeId*>;
 
 public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
 
+    // Переводит граф в компактное представление (CSR: смещения + упакованные массивы полей рёбер).
+    // Идентификаторы рёбер сохраняются
+    void Finalize();
+    bool IsFinalized() const;
+
+    // Правка графа на месте, в том числе финализированного: изменённый список рёбер вершины
+    // хранится отдельно от CSR. Удалённое ребро остаётся в массивах полей, идентификаторы
+    // остальных рёбер не меняются
+    VertexId AddVertex();
+    void RemoveEdge(EdgeId edge_id);
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
+
+    // Двоичная запись и чтение финализированного графа
+    void Serialize(std::ostream& out) const;
+    static DirectedWeightedGraph Deserialize(std::istream& in);
+
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+
+    static constexpr uint32_t NO_PATCH = std::numeric_limits<uint32_t>::max();
+
+    IncidenceList& GetPatchedIncidence(VertexId vertex);
+
+    bool finalized_ = false;
+    // Списки рёбер вершин, изменённых после Finalize: по вершине - индекс в patched_incidence_
+    // или NO_PATCH. Пока правок не было, patched_index_ пуст
+    std::vector<uint32_t> patched_index_;
+    std::vector<IncidenceList> patched_incidence_;
+    std::vector<size_t> offsets_;
+    std::vector<EdgeId> incidence_;
+    std::vector<uint32_t> edge_from_;
+    std::vector<uint32_t> edge_to_;
+    std::vector<uint32_t> edge_span_count_;
+    std::vector<NameId> edge_name_id_;
+    std::vector<Weight> edge_weight_;
 };
 
 template <typename Weight>
@@ -47,31 +87,234 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
-    edges_.push_back(edge);
-    const EdgeId id = edges_.size() - 1;
-    incidence_lists_.at(edge.from).push_back(id);
+    if (!finalized_) {
+        edges_.push_back(edge);
+        const EdgeId id = edges_.size() - 1;
+        incidence_lists_.at(edge.from).push_back(id);
+        return id;
+    }
+
+    constexpr size_t max_id = std::numeric_limits<uint32_t>::max();
+    if (edge.from >= GetVertexCount() || edge.to >= GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (edge.span_count > max_id) {
+        throw std::length_error("Edge span count is too large for a finalized graph");
+    }
+    const EdgeId id = edge_weight_.size();
+    edge_from_.push_back(static_cast<uint32_t>(edge.from));
+    edge_to_.push_back(static_cast<uint32_t>(edge.to));
+    edge_span_count_.push_back(static_cast<uint32_t>(edge.span_count));
+    edge_name_id_.push_back(edge.name_id);
+    edge_weight_.push_back(edge.weight);
+    GetPatchedIncidence(edge.from).push_back(id);
     return id;
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    if (!finalized_) {
+        incidence_lists_.emplace_back();
+        return incidence_lists_.size() - 1;
+    }
+    if (offsets_.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Too many vertices for a finalized graph");
+    }
+    // Пустой отрезок в конце CSR
+    offsets_.push_back(offsets_.back());
+    if (!patched_index_.empty()) {
+        patched_index_.push_back(NO_PATCH);
+    }
+    return offsets_.size() - 2;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    const VertexId from = GetEdge(edge_id).from;
+    IncidenceList& incidence_list = finalized_ ? GetPatchedIncidence(from) : incidence_lists_[from];
+    incidence_list.erase(std::remove(incidence_list.begin(), incidence_list.end(), edge_id), incidence_list.end());
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    if (!finalized_) {
+        edges_.at(edge_id).weight = weight;
+    } else if (edge_id < edge_weight_.size()) {
+        edge_weight_[edge_id] = weight;
+    } else {
+        throw std::out_of_range("Edge id is out of range");
+    }
+}
+
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidenceList&
+    DirectedWeightedGraph<Weight>::GetPatchedIncidence(VertexId vertex) {
+    if (patched_index_.empty()) {
+        patched_index_.assign(GetVertexCount(), NO_PATCH);
+    }
+    uint32_t& index = patched_index_.at(vertex);
+    if (index == NO_PATCH) {
+        // Первая правка вершины: её рёбра копируются из CSR
+        index = static_cast<uint32_t>(patched_incidence_.size());
+        patched_incidence_.emplace_back(incidence_.begin() + offsets_[vertex], incidence_.begin() + offsets_[vertex + 1]);
+    }
+    return patched_incidence_[index];
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Finalize() {
+    if (finalized_) {
+        return;
+    }
+    constexpr size_t max_id = std::numeric_limits<uint32_t>::max();
+    if (incidence_lists_.size() > max_id) {
+        throw std::length_error("Too many vertices for a finalized graph");
+    }
+
+    const size_t edge_count = edges_.size();
+    offsets_.reserve(incidence_lists_.size() + 1);
+    incidence_.reserve(edge_count);
+    offsets_.push_back(0);
+    for (const IncidenceList& incidence_list : incidence_lists_) {
+        incidence_.insert(incidence_.end(), incidence_list.begin(), incidence_list.end());
+        offsets_.push_back(incidence_.size());
+    }
+
+    edge_from_.reserve(edge_count);
+    edge_to_.reserve(edge_count);
+    edge_span_count_.reserve(edge_count);
+    edge_name_id_.reserve(edge_count);
+    edge_weight_.reserve(edge_count);
+    for (const Edge<Weight>& edge : edges_) {
+        if (edge.span_count > max_id) {
+            throw std::length_error("Edge span count is too large for a finalized graph");
+        }
+        edge_from_.push_back(static_cast<uint32_t>(edge.from));
+        edge_to_.push_back(static_cast<uint32_t>(edge.to));
+        edge_span_count_.push_back(static_cast<uint32_t>(edge.span_count));
+        edge_name_id_.push_back(edge.name_id);
+        edge_weight_.push_back(edge.weight);
+    }
+
+    // Освобождаем память представления для построения
+    std::vector<Edge<Weight>>().swap(edges_);
+    std::vector<IncidenceList>().swap(incidence_lists_);
+    finalized_ = true;
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFinalized() const {
+    return finalized_;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Serialize(std::ostream& out) const {
+    if (!finalized_) {
+        throw std::logic_error("Only a finalized graph can be serialized");
+    }
+    if (patched_index_.empty()) {
+        binary_io::WriteVector(out, offsets_);
+        binary_io::WriteVector(out, incidence_);
+    } else {
+        // Правки сливаются с CSR при записи
+        std::vector<size_t> offsets;
+        std::vector<EdgeId> incidence;
+        offsets.reserve(offsets_.size());
+        incidence.reserve(incidence_.size());
+        offsets.push_back(0);
+        for (VertexId vertex = 0; vertex + 1 < offsets_.size(); ++vertex) {
+            const auto edges = GetIncidentEdges(vertex);
+            incidence.insert(incidence.end(), edges.begin(), edges.end());
+            offsets.push_back(incidence.size());
+        }
+        binary_io::WriteVector(out, offsets);
+        binary_io::WriteVector(out, incidence);
+    }
+    binary_io::WriteVector(out, edge_from_);
+    binary_io::WriteVector(out, edge_to_);
+    binary_io::WriteVector(out, edge_span_count_);
+    binary_io::WriteVector(out, edge_name_id_);
+    binary_io::WriteVector(out, edge_weight_);
+}
+
+template <typename Weight>
+DirectedWeightedGraph<Weight> DirectedWeightedGraph<Weight>::Deserialize(std::istream& in) {
+    DirectedWeightedGraph graph;
+    graph.offsets_ = binary_io::ReadVector<size_t>(in);
+    graph.incidence_ = binary_io::ReadVector<EdgeId>(in);
+    graph.edge_from_ = binary_io::ReadVector<uint32_t>(in);
+    graph.edge_to_ = binary_io::ReadVector<uint32_t>(in);
+    graph.edge_span_count_ = binary_io::ReadVector<uint32_t>(in);
+    graph.edge_name_id_ = binary_io::ReadVector<NameId>(in);
+    graph.edge_weight_ = binary_io::ReadVector<Weight>(in);
+
+    const size_t edge_count = graph.edge_weight_.size();
+    // Удалённые рёбра остаются в массивах полей, но не входят в списки вершин
+    if (graph.offsets_.empty() || graph.offsets_.front() != 0 || graph.offsets_.back() != graph.incidence_.size()
+        || graph.offsets_.size() - 1 > std::numeric_limits<uint32_t>::max()
+        || graph.incidence_.size() > edge_count || graph.edge_from_.size() != edge_count
+        || graph.edge_to_.size() != edge_count || graph.edge_span_count_.size() != edge_count
+        || graph.edge_name_id_.size() != edge_count) {
+        throw binary_io::FormatError("Inconsistent graph data");
+    }
+    // Индексы из снимка используются без проверок, поэтому сверяем их все
+    const size_t vertex_count = graph.offsets_.size() - 1;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (graph.offsets_[vertex] > graph.offsets_[vertex + 1]) {
+            throw binary_io::FormatError("Graph offsets decrease");
+        }
+        for (size_t i = graph.offsets_[vertex]; i < graph.offsets_[vertex + 1]; ++i) {
+            if (graph.incidence_[i] >= edge_count || graph.edge_from_[graph.incidence_[i]] != vertex) {
+                throw binary_io::FormatError("Graph incidence list refers to a wrong edge");
+            }
+        }
+    }
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.edge_from_[edge_id] >= vertex_count || graph.edge_to_[edge_id] >= vertex_count) {
+            throw binary_io::FormatError("Graph edge vertex is out of range");
+        }
+    }
+    graph.finalized_ = true;
+    return graph;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return finalized_ ? offsets_.size() - 1 : incidence_lists_.size();
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return finalized_ ? edge_weight_.size() : edges_.size();
 }
 
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-    return edges_.at(edge_id);
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    if (!finalized_) {
+        return edges_.at(edge_id);
+    }
+    if (edge_id >= edge_weight_.size()) {
+        throw std::out_of_range("Edge id is out of range");
+    }
+    return {edge_name_id_[edge_id], edge_span_count_[edge_id],
+            edge_from_[edge_id], edge_to_[edge_id], edge_weight_[edge_id]};
 }
 
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-    return ranges::AsRange(incidence_lists_.at(vertex));
+    if (!finalized_) {
+        const IncidenceList& incidence_list = incidence_lists_.at(vertex);
+        return {incidence_list.data(), incidence_list.data() + incidence_list.size()};
+    }
+    if (vertex + 1 >= offsets_.size()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (!patched_index_.empty() && patched_index_[vertex] != NO_PATCH) {
+        const IncidenceList& incidence_list = patched_incidence_[patched_index_[vertex]];
+        return {incidence_list.data(), incidence_list.data() + incidence_list.size()};
+    }
+    return {incidence_.data() + offsets_[vertex], incidence_.data() + offsets_[vertex + 1]};
 }
 
 } // namespace graph
\ No newline at end of file
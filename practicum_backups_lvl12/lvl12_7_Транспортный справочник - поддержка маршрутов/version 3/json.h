@@ -24,14 +24,14 @@ public:
     using Value = std::variant<std::monostate, std::nullptr_t, Array, Dict, bool, int, double, std::string>;
 
     Node() : value_(std::monostate{}) {}  // Инициализация std::monostate
-    Node(Dict map) : value_(map) {}
+    Node(Dict map) : value_(std::move(map)) {}
     Node(int value) : value_(value) {}
     Node(double value) : value_(value) {}
     Node(bool value) : value_(value) {}
-    Node(const std::string& value) : value_(value) {}
+    Node(std::string value) : value_(std::move(value)) {}
     Node(const char* value) : value_(std::string(value)) {}
     Node(std::nullptr_t) : value_(nullptr) {}
-    Node(const Array& array) : value_(array) {}
+    Node(Array array) : value_(std::move(array)) {}
 
     // Конструктор копирования
     Node(const Node& other) : value_(other.value_) {}
@@ -133,6 +133,7 @@ private:
 };
 
 
+// Разбор идёт потоковым парсером из json_sax.h, дерево собирает json::DomBuilder
 Document LoadJSON(const std::string& json);
 Document Load(std::istream& input);
 
@@ -0,0 +1,304 @@
+#include "json_flat.h"
+#include "json_sax.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace json {
+
+using flat_detail::Record;
+using flat_detail::Type;
+
+static_assert(sizeof(Record) == 32, "Record is expected to stay compact");
+
+// Реализация FlatNode
+
+int FlatNode::AsInt() const {
+    if (IsInt()) return record_->int_value;
+    throw std::logic_error("Not an int");
+}
+
+bool FlatNode::AsBool() const {
+    if (IsBool()) return record_->bool_value;
+    throw std::logic_error("Not a bool");
+}
+
+double FlatNode::AsDouble() const {
+    if (IsPureDouble()) {
+        return record_->double_value;
+    }
+    if (IsInt()) {
+        return static_cast<double>(record_->int_value);
+    }
+    throw std::logic_error("Not a double");
+}
+
+std::string_view FlatNode::AsString() const {
+    if (IsString()) return {record_->string_data, record_->size};
+    throw std::logic_error("Not a string");
+}
+
+FlatNode::ArrayView FlatNode::AsArray() const {
+    if (IsArray()) return {record_->children, record_->size};
+    throw std::logic_error("Not an array");
+}
+
+FlatNode::DictView FlatNode::AsMap() const {
+    if (IsMap()) return {record_->children, record_->size};
+    throw std::logic_error("Not a map");
+}
+
+Node FlatNode::ToNode() const {
+    switch (record_->type) {
+        case Type::NULL_VALUE: return Node(nullptr);
+        case Type::BOOL: return Node(AsBool());
+        case Type::INT: return Node(AsInt());
+        case Type::DOUBLE: return Node(AsDouble());
+        case Type::STRING: return Node(std::string(AsString()));
+        case Type::ARRAY: {
+            Array array;
+            array.reserve(record_->size);
+            for (const FlatNode item : AsArray()) {
+                array.push_back(item.ToNode());
+            }
+            return Node(std::move(array));
+        }
+        case Type::DICT: {
+            Dict dict;
+            for (const auto [key, value] : AsMap()) {
+                // Ключи уже отсортированы, поэтому вставка в конец идёт за O(1)
+                dict.emplace_hint(dict.end(), std::string(key), value.ToNode());
+            }
+            return Node(std::move(dict));
+        }
+        case Type::NONE: break;
+    }
+    return Node();
+}
+
+FlatNode FlatNode::ArrayView::at(size_t index) const {
+    if (index >= size_) {
+        throw std::out_of_range("Array index is out of range");
+    }
+    return (*this)[index];
+}
+
+const Record* FlatNode::DictView::Find(std::string_view key) const {
+    const Record* last = first_ + size_;
+    const Record* it = std::lower_bound(first_, last, key, [](const Record& record, std::string_view key) {
+        return record.GetKey() < key;
+    });
+    return it != last && it->GetKey() == key ? it : nullptr;
+}
+
+FlatNode FlatNode::DictView::at(std::string_view key) const {
+    if (const Record* record = Find(key)) {
+        return FlatNode(record);
+    }
+    throw std::out_of_range("Key is not found: " + std::string(key));
+}
+
+FlatNode::DictView::Iterator FlatNode::DictView::find(std::string_view key) const {
+    const Record* record = Find(key);
+    return Iterator(record ? record : first_ + size_);
+}
+
+// Собирает узлы документа из событий парсера. Дети открытого контейнера копятся
+// в стеке pending_ и при закрытии контейнера переносятся в арену одним отрезком
+class FlatDocument::Loader final : public Handler {
+public:
+    explicit Loader(FlatDocument& document)
+        : document_(document) {
+        const std::string& text = *document.text_;
+        text_begin_ = text.data();
+        text_end_ = text.data() + text.size();
+    }
+
+    void OnNull() override {
+        Record record;
+        record.type = Type::NULL_VALUE;
+        AddValue(record);
+    }
+
+    void OnBool(bool value) override {
+        Record record;
+        record.type = Type::BOOL;
+        record.bool_value = value;
+        AddValue(record);
+    }
+
+    void OnInt(int value) override {
+        Record record;
+        record.type = Type::INT;
+        record.int_value = value;
+        AddValue(record);
+    }
+
+    void OnDouble(double value) override {
+        Record record;
+        record.type = Type::DOUBLE;
+        record.double_value = value;
+        AddValue(record);
+    }
+
+    void OnString(std::string_view value) override {
+        const std::string_view stored = StoreString(value);
+        Record record;
+        record.type = Type::STRING;
+        record.string_data = stored.data();
+        record.size = static_cast<uint32_t>(stored.size());
+        AddValue(record);
+    }
+
+    void OnStartDict() override {
+        frames_.push_back({pending_.size(), Type::DICT, key_});
+    }
+
+    void OnKey(std::string_view key) override {
+        key_ = StoreString(key);
+    }
+
+    void OnEndDict() override {
+        CloseContainer();
+    }
+
+    void OnStartArray() override {
+        frames_.push_back({pending_.size(), Type::ARRAY, key_});
+    }
+
+    void OnEndArray() override {
+        CloseContainer();
+    }
+
+    void Finish() {
+        if (!frames_.empty() || pending_.size() != 1) {
+            throw ParsingError("JSON value is not complete");
+        }
+        Record* root = AllocateRecords(1);
+        *root = pending_.back();
+        document_.root_ = root;
+    }
+
+private:
+    struct Frame {
+        size_t first_pending;
+        Type type;
+        std::string_view key;
+    };
+
+    void AddValue(Record record) {
+        if (!frames_.empty() && frames_.back().type == Type::DICT) {
+            record.key_data = key_.data();
+            record.key_size = static_cast<uint32_t>(key_.size());
+        }
+        pending_.push_back(record);
+    }
+
+    void CloseContainer() {
+        const Frame frame = frames_.back();
+        frames_.pop_back();
+
+        const size_t count = pending_.size() - frame.first_pending;
+        if (count > UINT32_MAX) {
+            throw ParsingError("JSON container is too large");
+        }
+        Record* children = AllocateRecords(count);
+        std::copy(pending_.begin() + frame.first_pending, pending_.end(), children);
+        pending_.resize(frame.first_pending);
+        if (frame.type == Type::DICT) {
+            // Устойчивая сортировка: при повторе ключа поиск найдёт первое значение, как в json::Dict
+            std::stable_sort(children, children + count, [](const Record& lhs, const Record& rhs) {
+                return lhs.GetKey() < rhs.GetKey();
+            });
+        }
+
+        Record record;
+        record.type = frame.type;
+        record.children = children;
+        record.size = static_cast<uint32_t>(count);
+        key_ = frame.key;
+        AddValue(record);
+    }
+
+    // Узлы выделяются из блоков и никогда не перемещаются, поэтому в памяти нет
+    // одновременно старой и новой копии растущего массива
+    Record* AllocateRecords(size_t count) {
+        if (count > records_free_) {
+            const size_t block_size = std::max(NODE_BLOCK_SIZE, count);
+            document_.node_blocks_.push_back(std::make_unique<Record[]>(block_size));
+            records_pos_ = document_.node_blocks_.back().get();
+            records_free_ = block_size;
+        }
+        Record* result = records_pos_;
+        records_pos_ += count;
+        records_free_ -= count;
+        return result;
+    }
+
+    // Строка из текста документа используется как есть, остальные копируются в арену
+    std::string_view StoreString(std::string_view value) {
+        if (value.size() > UINT32_MAX) {
+            throw ParsingError("JSON string is too long");
+        }
+        if (value.data() >= text_begin_ && value.data() + value.size() <= text_end_) {
+            return value;
+        }
+        if (value.size() > chars_free_) {
+            const size_t block_size = std::max(STRING_BLOCK_SIZE, value.size());
+            document_.string_blocks_.push_back(std::make_unique<char[]>(block_size));
+            chars_pos_ = document_.string_blocks_.back().get();
+            chars_free_ = block_size;
+        }
+        std::memcpy(chars_pos_, value.data(), value.size());
+        const std::string_view stored(chars_pos_, value.size());
+        chars_pos_ += value.size();
+        chars_free_ -= value.size();
+        return stored;
+    }
+
+    static constexpr size_t NODE_BLOCK_SIZE = 1 << 14;
+    static constexpr size_t STRING_BLOCK_SIZE = 1 << 16;
+
+    FlatDocument& document_;
+    const char* text_begin_ = nullptr;
+    const char* text_end_ = nullptr;
+    Record* records_pos_ = nullptr;
+    size_t records_free_ = 0;
+    char* chars_pos_ = nullptr;
+    size_t chars_free_ = 0;
+
+    std::vector<Frame> frames_;
+    std::vector<Record> pending_;
+    std::string_view key_;
+};
+
+// Реализация FlatDocument
+
+FlatDocument FlatDocument::Load(std::istream& input) {
+    std::string text;
+    // Для файлов размер известен заранее, и текст читается без перевыделений
+    const auto start = input.tellg();
+    if (start != std::istream::pos_type(-1) && input.seekg(0, std::ios::end)) {
+        const auto end = input.tellg();
+        input.seekg(start);
+        text.resize(static_cast<size_t>(end - start));
+        input.read(text.data(), static_cast<std::streamsize>(text.size()));
+        text.resize(static_cast<size_t>(input.gcount()));
+    } else {
+        input.clear();
+        text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    return Load(std::move(text));
+}
+
+FlatDocument FlatDocument::Load(std::string text) {
+    FlatDocument document;
+    document.text_ = std::make_unique<std::string>(std::move(text));
+    Loader loader(document);
+    Parse(std::string_view(*document.text_), loader);
+    loader.Finish();
+    return document;
+}
+
+}  // namespace json
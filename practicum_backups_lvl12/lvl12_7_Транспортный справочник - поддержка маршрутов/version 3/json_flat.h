@@ -0,0 +1,189 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Плоское представление документа JSON. Все узлы лежат в блоках арены документа,
+// дети каждого массива или словаря - непрерывным отрезком в одном блоке. Ключи и строки -
+// string_view на текст документа, который хранится вместе с узлами; в арену документа
+// копируются только строки с экранированием. Словари отсортированы по ключу, поиск двоичный.
+// Узлы только читаются и живут, пока жив FlatDocument
+namespace json {
+
+class FlatNode;
+
+namespace flat_detail {
+
+enum class Type : uint8_t { NONE, NULL_VALUE, BOOL, INT, DOUBLE, STRING, ARRAY, DICT };
+
+// 32 байта на узел: ключ в родительском словаре, длина, значение и тип
+struct Record {
+    const char* key_data = nullptr;
+    uint32_t key_size = 0;
+    uint32_t size = 0; // Длина строки или число детей
+    union {
+        bool bool_value;
+        int int_value;
+        double double_value;
+        const char* string_data;
+        const Record* children; // Дети лежат подряд в одном блоке арены
+    };
+    Type type = Type::NONE;
+
+    std::string_view GetKey() const {
+        return {key_data, key_size};
+    }
+};
+
+}  // namespace flat_detail
+
+class FlatNode {
+public:
+    class ArrayView;
+    class DictView;
+
+    bool IsNull() const { return record_->type == flat_detail::Type::NULL_VALUE; }
+    bool IsInt() const { return record_->type == flat_detail::Type::INT; }
+    bool IsDouble() const { return IsInt() || IsPureDouble(); }
+    bool IsPureDouble() const { return record_->type == flat_detail::Type::DOUBLE; }
+    bool IsBool() const { return record_->type == flat_detail::Type::BOOL; }
+    bool IsString() const { return record_->type == flat_detail::Type::STRING; }
+    bool IsArray() const { return record_->type == flat_detail::Type::ARRAY; }
+    bool IsMap() const { return record_->type == flat_detail::Type::DICT; }
+
+    int AsInt() const;
+    bool AsBool() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    ArrayView AsArray() const;
+    DictView AsMap() const;
+
+    // Копия узла в обычное дерево json::Node
+    Node ToNode() const;
+
+private:
+    friend class FlatDocument;
+
+    explicit FlatNode(const flat_detail::Record* record)
+        : record_(record) {
+    }
+
+    const flat_detail::Record* record_;
+};
+
+class FlatNode::ArrayView {
+public:
+    class Iterator {
+    public:
+        FlatNode operator*() const { return FlatNode(record_); }
+        Iterator& operator++() {
+            ++record_;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return record_ == other.record_; }
+        bool operator!=(const Iterator& other) const { return record_ != other.record_; }
+
+    private:
+        friend class ArrayView;
+
+        explicit Iterator(const flat_detail::Record* record)
+            : record_(record) {
+        }
+
+        const flat_detail::Record* record_;
+    };
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    FlatNode operator[](size_t index) const { return FlatNode(first_ + index); }
+    FlatNode at(size_t index) const;
+    Iterator begin() const { return Iterator(first_); }
+    Iterator end() const { return Iterator(first_ + size_); }
+
+private:
+    friend class FlatNode;
+
+    ArrayView(const flat_detail::Record* first, size_t size)
+        : first_(first)
+        , size_(size) {
+    }
+
+    const flat_detail::Record* first_;
+    size_t size_;
+};
+
+class FlatNode::DictView {
+public:
+    class Iterator {
+    public:
+        std::pair<std::string_view, FlatNode> operator*() const { return {record_->GetKey(), FlatNode(record_)}; }
+        Iterator& operator++() {
+            ++record_;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return record_ == other.record_; }
+        bool operator!=(const Iterator& other) const { return record_ != other.record_; }
+
+    private:
+        friend class DictView;
+
+        explicit Iterator(const flat_detail::Record* record)
+            : record_(record) {
+        }
+
+        const flat_detail::Record* record_;
+    };
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t count(std::string_view key) const { return Find(key) ? 1 : 0; }
+    // Бросает std::out_of_range, если ключа нет
+    FlatNode at(std::string_view key) const;
+    Iterator find(std::string_view key) const;
+    Iterator begin() const { return Iterator(first_); }
+    Iterator end() const { return Iterator(first_ + size_); }
+
+private:
+    friend class FlatNode;
+
+    DictView(const flat_detail::Record* first, size_t size)
+        : first_(first)
+        , size_(size) {
+    }
+
+    const flat_detail::Record* Find(std::string_view key) const;
+
+    const flat_detail::Record* first_;
+    size_t size_;
+};
+
+class FlatDocument {
+public:
+    // Бросают ParsingError, как и json::Load
+    static FlatDocument Load(std::istream& input);
+    static FlatDocument Load(std::string text);
+
+    FlatNode GetRoot() const { return FlatNode(root_); }
+
+private:
+    class Loader;
+
+    FlatDocument() = default;
+
+    // Текст хранится в unique_ptr, чтобы string_view на него переживали перемещение документа
+    std::unique_ptr<std::string> text_;
+    // Арена: блоки узлов и блоки строк, которых нет в тексте дословно (с экранированием)
+    std::vector<std::unique_ptr<flat_detail::Record[]>> node_blocks_;
+    std::vector<std::unique_ptr<char[]>> string_blocks_;
+    const flat_detail::Record* root_ = nullptr;
+};
+
+}  // namespace json
@@ -1,14 +1,86 @@
 #include "json_reader.h"
+#include "allocation_counter.h"
 #include "transport_router.h"
 #include "domain.h"
-#include "json_builder.h"
+#include "json_writer.h"
 #include <iostream>
 #include <algorithm>
-#include <set>
 #include <iomanip> // Для std::setprecision
+#include <chrono>
 
 namespace json_reader {
 
+namespace {
+
+// Добавляет остановку и расстояния от неё. Соседние остановки, которых ещё нет
+// в справочнике, создаются с нулевыми координатами и уточняются их собственным запросом
+void AddStopWithDistances(transport_catalogue::TransportCatalogue& catalogue,
+                          const std::string& stop_name,
+                          geo::Coordinates coordinates,
+                          const std::vector<std::pair<std::string_view, int>>& distances) {
+    catalogue.AddStop(stop_name, coordinates);
+    const auto* from_stop = catalogue.FindStop(stop_name);
+    for (const auto& [neighbor_stop_name, distance] : distances) {
+        const auto* to_stop = catalogue.FindStop(neighbor_stop_name);
+
+        // Если вторая остановка не найдена, добавляем её с нулевыми координатами
+        if (to_stop == nullptr) {
+            catalogue.AddStop(std::string(neighbor_stop_name), {0.0, 0.0});
+            to_stop = catalogue.FindStop(neighbor_stop_name);
+        }
+
+        if (from_stop && to_stop) {
+            catalogue.SetDistance(from_stop, to_stop, distance);
+        } else {
+            std::cerr << "Error: One or both stops not found\n";
+        }
+    }
+}
+
+// Добавляет маршрут, пропуская неизвестные остановки
+void AddBusByStopNames(transport_catalogue::TransportCatalogue& catalogue,
+                       const std::string& bus_name,
+                       const std::vector<std::string_view>& stop_names,
+                       bool is_roundtrip) {
+    std::vector<const transport_catalogue::Stop*> stops;
+    stops.reserve(stop_names.size());
+    for (const auto stop_name : stop_names) {
+        const auto* stop = catalogue.FindStop(stop_name);
+        if (stop) {
+            stops.push_back(stop);
+        } else {
+            std::cerr << "Error: Stop not found: " << stop_name << "\n";
+        }
+    }
+    catalogue.AddBus(bus_name, stops, is_roundtrip);
+}
+
+// Элементы маршрута в формате ответа на запрос Route
+void WriteRouteItems(json::Writer& builder, const transport::RouteInfo& route_info) {
+    builder.StartArray();
+    for (const auto& item : route_info.items) {
+        if (std::holds_alternative<transport::WaitItem>(item)) {
+            const auto& wait = std::get<transport::WaitItem>(item);
+            builder.StartDict()
+                .Key("stop_name").Value(wait.stop_name)
+                .Key("time").Value(wait.time)
+                .Key("type").Value("Wait")
+                .EndDict();
+        } else {
+            const auto& bus = std::get<transport::BusItem>(item);
+            builder.StartDict()
+                .Key("bus").Value(bus.bus)
+                .Key("span_count").Value(static_cast<int>(bus.span_count))
+                .Key("time").Value(bus.time)
+                .Key("type").Value("Bus")
+                .EndDict();
+        }
+    }
+    builder.EndArray();
+}
+
+} // namespace
+
 JsonReader::JsonReader(transport_catalogue::TransportCatalogue& catalogue) : catalogue_(catalogue) {}
 
 void JsonReader::LoadData(const json::Node& data) {
@@ -39,7 +111,7 @@ void JsonReader::LoadData(const json::Node& data) {
             continue;
         }
 
-        std::string type = request_map.at("type").AsString();
+        const std::string& type = request_map.at("type").AsString();
         if (type == "Stop") {
             ProcessStopRequest(request_map);
         }
@@ -59,7 +131,7 @@ void JsonReader::LoadData(const json::Node& data) {
             continue;
         }
 
-        std::string type = request_map.at("type").AsString();
+        const std::string& type = request_map.at("type").AsString();
         if (type == "Bus") {
             ProcessBusRequest(request_map);
         }
@@ -77,34 +149,19 @@ void JsonReader::ProcessStopRequest(const json::Dict& request_map) {
         return;
     }
 
-    std::string stop_name = request_map.at("name").AsString();
+    const std::string& stop_name = request_map.at("name").AsString();
     double lat = request_map.at("latitude").AsDouble();
     double lng = request_map.at("longitude").AsDouble();
-    catalogue_.AddStop(stop_name, {lat, lng});
 
-    const auto& road_distances = request_map.at("road_distances").AsMap();
-    for (const auto& [neighbor_stop_name, distance] : road_distances) {
+    std::vector<std::pair<std::string_view, int>> distances;
+    for (const auto& [neighbor_stop_name, distance] : request_map.at("road_distances").AsMap()) {
         if (!distance.IsInt()) {
             std::cerr << "Error: Distance is not an integer\n";
             continue;
         }
-
-        int dist = distance.AsInt();
-        const auto* from_stop = catalogue_.FindStop(stop_name);
-        const auto* to_stop = catalogue_.FindStop(neighbor_stop_name);
-
-        // Если вторая остановка не найдена, добавляем её с нулевыми координатами
-        if (to_stop == nullptr) {
-            catalogue_.AddStop(neighbor_stop_name, {0.0, 0.0});
-            to_stop = catalogue_.FindStop(neighbor_stop_name);
-        }
-
-        if (from_stop && to_stop) {
-            catalogue_.SetDistance(from_stop, to_stop, dist);
-        } else {
-            std::cerr << "Error: One or both stops not found\n";
-        }
+        distances.emplace_back(neighbor_stop_name, distance.AsInt());
     }
+    AddStopWithDistances(catalogue_, stop_name, {lat, lng}, distances);
 }
 
 void JsonReader::ProcessBusRequest(const json::Dict& request_map) {
@@ -115,42 +172,28 @@ void JsonReader::ProcessBusRequest(const json::Dict& request_map) {
         return;
     }
 
-    std::string bus_name = request_map.at("name").AsString();
+    const std::string& bus_name = request_map.at("name").AsString();
     bool is_roundtrip = request_map.at("is_roundtrip").AsBool();
     const auto& stops_array = request_map.at("stops").AsArray();
 
-    std::vector<const transport_catalogue::Stop*> stops;
-    for (size_t j = 0; j < stops_array.size(); ++j) {
-        if (!stops_array[j].IsString()) {
+    std::vector<std::string_view> stop_names;
+    stop_names.reserve(stops_array.size());
+    for (const auto& stop_node : stops_array) {
+        if (!stop_node.IsString()) {
             std::cerr << "Error: Stop name is not a string\n";
             continue;
         }
-
-        const auto* stop = catalogue_.FindStop(stops_array[j].AsString());
-        if (stop) {
-            stops.push_back(stop);
-        } else {
-            std::cerr << "Error: Stop not found: " << stops_array[j].AsString() << "\n";
-        }
+        stop_names.push_back(stop_node.AsString());
     }
-
-    catalogue_.AddBus(bus_name, stops, is_roundtrip);
+    AddBusByStopNames(catalogue_, bus_name, stop_names, is_roundtrip);
 }
 
-json::Node JsonReader::ProcessRequests(const json::Node& requests, const json::Node& render_settings) {
-    json::Builder builder;
-    builder.StartArray();  // Начинаем массив ответов
-
-    if (!requests.IsArray()) {
-        std::cerr << "Error: Requests data is not an array\n";
-        return builder.Build();
+void JsonReader::ApplyUpdates(const json::Node& update_requests) {
+    if (!update_requests.IsArray()) {
+        std::cerr << "Error: update_requests is not an array\n";
+        return;
     }
-
-    const auto& requests_array = requests.AsArray();
-
-    // Обрабатываем запросы "Stop", "Bus", "Map" и "Route"
-    for (size_t i = 0; i < requests_array.size(); ++i) {
-        const auto& request = requests_array[i];
+    for (const auto& request : update_requests.AsArray()) {
         if (!request.IsMap()) {
             std::cerr << "Error: Request is not a map\n";
             continue;
@@ -162,87 +205,323 @@ json::Node JsonReader::ProcessRequests(const json::Node& requests, const json::N
             continue;
         }
 
-        std::string type = request_map.at("type").AsString();
-        int id = request_map.at("id").AsInt();
-
+        const std::string& type = request_map.at("type").AsString();
         if (type == "Stop") {
-            ProcessStopResponse(builder, request_map, id);
+            ProcessStopUpdate(request_map);
         } else if (type == "Bus") {
-            ProcessBusResponse(builder, request_map, id);
-        } else if (type == "Map") {
-            ProcessMapResponse(builder, id, render_settings);
-        } else if (type == "Route") {
-            ProcessRouteResponse(builder, request_map, id);
+            ProcessBusUpdate(request_map);
+        } else if (type == "RemoveBus") {
+            ProcessRemoveBusUpdate(request_map);
+        } else if (type == "Distance") {
+            ProcessDistanceUpdate(request_map);
+        } else if (type == "RoutingSettings") {
+            ProcessRoutingSettingsUpdate(request_map);
+        } else {
+            std::cerr << "Error: Unknown update type: " << type << "\n";
         }
     }
+    // Оценку A* пересчитываем один раз на всю пачку правок
+    if (cached_router_) {
+        cached_router_->RefreshHeuristic(catalogue_);
+    }
+}
+
+void JsonReader::ProcessStopUpdate(const json::Dict& request_map) {
+    ProcessStopRequest(request_map);
+    const auto name_it = request_map.find("name");
+    const auto distances_it = request_map.find("road_distances");
+    if (name_it == request_map.end() || distances_it == request_map.end() || !cached_router_) {
+        return;
+    }
+    const auto* stop = catalogue_.FindStop(name_it->second.AsString());
+    if (!stop) {
+        return;
+    }
+    cached_router_->AddStop(*stop);
+    // Соседи, которых не было в справочнике, создаются вместе с расстояниями до них
+    for (const auto& [neighbor_stop_name, distance] : distances_it->second.AsMap()) {
+        if (const auto* neighbor_stop = catalogue_.FindStop(neighbor_stop_name)) {
+            cached_router_->AddStop(*neighbor_stop);
+        }
+    }
+    RefreshRouterBusesAtStop(stop);
+}
+
+void JsonReader::ProcessBusUpdate(const json::Dict& request_map) {
+    const auto name_it = request_map.find("name");
+    if (name_it == request_map.end()) {
+        std::cerr << "Error: Missing required fields in Bus request\n";
+        return;
+    }
+    const std::string& bus_name = name_it->second.AsString();
+    // Маршрут с тем же именем заменяется целиком
+    catalogue_.RemoveBus(bus_name);
+    ProcessBusRequest(request_map);
+    if (!cached_router_) {
+        return;
+    }
+    if (catalogue_.FindBus(bus_name)) {
+        cached_router_->AddBus(catalogue_, bus_name);
+    } else {
+        cached_router_->RemoveBus(bus_name);
+    }
+}
+
+void JsonReader::ProcessRemoveBusUpdate(const json::Dict& request_map) {
+    const auto name_it = request_map.find("name");
+    if (name_it == request_map.end()) {
+        std::cerr << "Error: Missing required fields in RemoveBus request\n";
+        return;
+    }
+    const std::string& bus_name = name_it->second.AsString();
+    if (!catalogue_.RemoveBus(bus_name)) {
+        std::cerr << "Error: Bus not found: " << bus_name << "\n";
+        return;
+    }
+    if (cached_router_) {
+        cached_router_->RemoveBus(bus_name);
+    }
+}
+
+void JsonReader::ProcessDistanceUpdate(const json::Dict& request_map) {
+    if (request_map.find("from") == request_map.end() ||
+        request_map.find("to") == request_map.end() ||
+        request_map.find("distance") == request_map.end()) {
+        std::cerr << "Error: Missing required fields in Distance request\n";
+        return;
+    }
+    const auto* from_stop = catalogue_.FindStop(request_map.at("from").AsString());
+    const auto* to_stop = catalogue_.FindStop(request_map.at("to").AsString());
+    if (!from_stop || !to_stop) {
+        std::cerr << "Error: One or both stops not found\n";
+        return;
+    }
+    catalogue_.SetDistance(from_stop, to_stop, request_map.at("distance").AsInt());
+    // Перегон from -> to (и обратный, если для него нет своего расстояния) есть
+    // только у маршрутов, проходящих через from
+    RefreshRouterBusesAtStop(from_stop);
+}
+
+void JsonReader::ProcessRoutingSettingsUpdate(const json::Dict& request_map) {
+    transport_catalogue::RoutingSettings settings = catalogue_.GetRoutingSettings();
+    if (const auto it = request_map.find("bus_wait_time"); it != request_map.end()) {
+        settings.bus_wait_time = it->second.AsInt();
+    }
+    if (const auto it = request_map.find("bus_velocity"); it != request_map.end()) {
+        settings.bus_velocity = it->second.AsDouble();
+    }
+    if (const auto it = request_map.find("use_geo_heuristic"); it != request_map.end()) {
+        settings.use_geo_heuristic = it->second.AsBool();
+    }
+    const transport_catalogue::RoutingSettings old_settings = catalogue_.GetRoutingSettings();
+    catalogue_.SetRoutingSettings(settings);
+    // Настройки не меняют версию справочника
+    cached_raptor_router_.reset();
+    if (!cached_router_) {
+        return;
+    }
+    if (settings.bus_velocity != old_settings.bus_velocity
+        || settings.use_geo_heuristic != old_settings.use_geo_heuristic) {
+        // Меняется вес каждого ребра поездки или способ поиска: дешевле построить граф заново
+        cached_router_.reset();
+    } else if (settings.bus_wait_time != old_settings.bus_wait_time) {
+        cached_router_->SetBusWaitTime(settings.bus_wait_time);
+    }
+}
+
+void JsonReader::RefreshRouterBusesAtStop(const transport_catalogue::Stop* stop) {
+    if (!cached_router_) {
+        return;
+    }
+    for (const auto* bus : catalogue_.GetBusesByStop(stop)) {
+        cached_router_->UpdateBusTimes(catalogue_, bus->name);
+    }
+}
+
+void JsonReader::ProcessRequests(const json::Node& requests, const json::Node& render_settings, json::Writer& builder) {
+    ProcessRequests(requests, map_renderer::ParseRenderSettings(render_settings), builder);
+}
+
+void JsonReader::ProcessRequests(const json::Node& requests, const map_renderer::RenderSettings& render_settings,
+                                 json::Writer& builder) {
+    builder.StartArray();  // Начинаем массив ответов
+
+    if (!requests.IsArray()) {
+        std::cerr << "Error: Requests data is not an array\n";
+        builder.EndArray();
+        return;
+    }
+
+    for (const auto& request : requests.AsArray()) {
+        ProcessRequest(request, render_settings, builder);
+    }
 
     builder.EndArray();  // Завершаем массив ответов
-    return builder.Build();  // Возвращаем построенный JSON
 }
 
-void JsonReader::ProcessStopResponse(json::Builder& builder, const json::Dict& request_map, int id) {
-    std::string stop_name = request_map.at("name").AsString();
+bool JsonReader::ProcessRequest(const json::Node& request, const map_renderer::RenderSettings& render_settings,
+                                json::Writer& builder) {
+    if (!request.IsMap()) {
+        std::cerr << "Error: Request is not a map\n";
+        return false;
+    }
+
+    const auto& request_map = request.AsMap();
+    const auto type_it = request_map.find("type");
+    if (type_it == request_map.end() || !type_it->second.IsString()) {
+        std::cerr << "Error: 'type' key not found in request\n";
+        return false;
+    }
+    const auto id_it = request_map.find("id");
+    if (id_it == request_map.end() || !id_it->second.IsInt()) {
+        std::cerr << "Error: 'id' key not found in request\n";
+        return false;
+    }
+
+    const std::string& type = type_it->second.AsString();
+    int id = id_it->second.AsInt();
+
+    if (!request_stats_) {
+        return DispatchRequest(type, request_map, id, render_settings, builder);
+    }
+    const uint64_t allocations = allocation_counter::GetThreadAllocationCount();
+    const auto start = std::chrono::steady_clock::now();
+    if (!DispatchRequest(type, request_map, id, render_settings, builder)) {
+        return false;
+    }
+    request_stats_->Record(type, std::chrono::steady_clock::now() - start,
+                           allocation_counter::GetThreadAllocationCount() - allocations);
+    return true;
+}
+
+bool JsonReader::DispatchRequest(std::string_view type, const json::Dict& request_map, int id,
+                                 const map_renderer::RenderSettings& render_settings, json::Writer& builder) {
+    if (type == "Stop") {
+        ProcessStopResponse(builder, request_map, id);
+    } else if (type == "Bus") {
+        ProcessBusResponse(builder, request_map, id);
+    } else if (type == "Map") {
+        ProcessMapResponse(builder, id, render_settings);
+    } else if (type == "MapTile") {
+        ProcessMapTileResponse(builder, request_map, id, render_settings);
+    } else if (type == "Route") {
+        ProcessRouteResponse(builder, request_map, id);
+    } else if (type == "RouteOptions") {
+        ProcessRouteOptionsResponse(builder, request_map, id);
+    } else if (type == "NearestStops") {
+        ProcessNearestStopsResponse(builder, request_map, id);
+    } else if (type == "StopsInArea") {
+        ProcessStopsInAreaResponse(builder, request_map, id);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void JsonReader::ProcessStopResponse(json::Writer& builder, const json::Dict& request_map, int id) {
+    const std::string& stop_name = request_map.at("name").AsString();
     const auto* stop = catalogue_.FindStop(stop_name);
 
     if (!stop) {
         builder.StartDict()
-            .Key("request_id").Value(id)
             .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
             .EndDict();
     } else {
-        const auto& buses = catalogue_.GetBusesByStop(stop_name);
-        std::set<std::string> bus_names; // Используем set для автоматической сортировки
-
-        for (const transport_catalogue::Bus* bus : buses) {
-            bus_names.insert(bus->name); // Добавляем имена автобусов в set
-        }
-
+        // Справочник отдаёт маршруты уже отсортированными по имени
         builder.StartDict()
-            .Key("request_id").Value(id)
             .Key("buses").StartArray();
-        for (const std::string& name : bus_names) {
-            builder.Value(name);
+        for (const transport_catalogue::Bus* bus : catalogue_.GetBusesByStop(stop)) {
+            builder.Value(bus->name);
         }
-        builder.EndArray().EndDict();
+        builder.EndArray()
+            .Key("request_id").Value(id)
+            .EndDict();
     }
 }
 
-void JsonReader::ProcessBusResponse(json::Builder& builder, const json::Dict& request_map, int id) {
-    std::string bus_name = request_map.at("name").AsString();
+void JsonReader::ProcessBusResponse(json::Writer& builder, const json::Dict& request_map, int id) {
+    const std::string& bus_name = request_map.at("name").AsString();
     const auto* bus = catalogue_.FindBus(bus_name);
 
     if (!bus) {
         builder.StartDict()
-            .Key("request_id").Value(id)
             .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
             .EndDict();
     } else {
-        auto bus_info = catalogue_.GetBusInfo(bus_name, id);
+        auto bus_info = catalogue_.GetBusInfo(bus->name, id);
 
         builder.StartDict()
+            .Key("curvature").Value(bus_info.curvature)
             .Key("request_id").Value(bus_info.request_id)
+            .Key("route_length").Value(bus_info.route_length)
             .Key("stop_count").Value(bus_info.stop_count)
             .Key("unique_stop_count").Value(bus_info.unique_stop_count)
-            .Key("route_length").Value(bus_info.route_length)
-            .Key("curvature").Value(bus_info.curvature)
             .EndDict();
     }
 }
 
-void JsonReader::ProcessMapResponse(json::Builder& builder, int id, const json::Node& render_settings) {
+void JsonReader::ProcessMapResponse(json::Writer& builder, int id, const map_renderer::RenderSettings& render_settings) {
+    const auto svg = GetMapSvg(render_settings);
+
+    // Формирование ответа: строка карты пишется без копирования
+    builder.StartDict()
+        .Key("map").Value(std::string_view(*svg))
+        .Key("request_id").Value(id)
+        .EndDict();
+}
+
+std::shared_ptr<const std::string> JsonReader::GetMapSvg(const map_renderer::RenderSettings& render_settings) {
+    std::lock_guard guard(cache_mutex_);
+    if (cached_map_ && cached_map_->catalogue_version == catalogue_.GetVersion()
+        && cached_map_->render_settings == render_settings) {
+        return cached_map_->svg;
+    }
+
     // Генерация SVG-изображения
-    std::ostringstream svg_stream;
-    map_renderer::MapRenderer renderer(catalogue_, map_renderer::ParseRenderSettings(render_settings));
-    renderer.Render(svg_stream);
-    std::string svg_content = svg_stream.str();
+    map_renderer::MapRenderer renderer(catalogue_, render_settings);
+    auto svg = std::make_shared<const std::string>(renderer.Render());
+
+    cached_map_ = MapCache{catalogue_.GetVersion(), render_settings, svg};
+    return svg;
+}
+
+void JsonReader::ProcessMapTileResponse(json::Writer& builder, const json::Dict& request_map, int id,
+                                        const map_renderer::RenderSettings& render_settings) {
+    const map_renderer::TileId tile{request_map.at("zoom").AsInt(), request_map.at("x").AsInt(),
+                                    request_map.at("y").AsInt()};
+    std::string svg;
+    try {
+        svg = GetTileRenderer(render_settings)->RenderTile(tile);
+    } catch (const std::out_of_range&) {
+        builder.StartDict()
+            .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
+            .EndDict();
+        return;
+    }
 
-    // Формирование ответа
     builder.StartDict()
+        .Key("map").Value(svg)
         .Key("request_id").Value(id)
-        .Key("map").Value(svg_content)
         .EndDict();
 }
 
+std::shared_ptr<const map_renderer::TileRenderer> JsonReader::GetTileRenderer(
+    const map_renderer::RenderSettings& render_settings) {
+    std::lock_guard guard(cache_mutex_);
+    if (cached_tile_renderer_ && cached_tile_renderer_->catalogue_version == catalogue_.GetVersion()
+        && cached_tile_renderer_->render_settings == render_settings) {
+        return cached_tile_renderer_->renderer;
+    }
+
+    auto renderer = std::make_shared<const map_renderer::TileRenderer>(catalogue_, render_settings,
+                                                                       map_renderer::TileSettings{});
+    cached_tile_renderer_ = TileRendererCache{catalogue_.GetVersion(), render_settings, renderer};
+    return renderer;
+}
+
 StatReader::StatReader(const transport_catalogue::TransportCatalogue& catalogue) : catalogue_(catalogue) {}
 
 void StatReader::ProcessQuery(const json::Node& query) const {
@@ -250,8 +529,15 @@ void StatReader::ProcessQuery(const json::Node& query) const {
     const std::string& type = query_map.at("type").AsString();
     int request_id = query_map.at("id").AsInt();
 
-    json::Builder builder;
+    {
+        json::Writer builder(std::cout, {true, 0, 6});
+        ProcessQuery(builder, type, query_map, request_id);
+    }
+    std::cout << "\n";
+}
 
+void StatReader::ProcessQuery(json::Writer& builder, std::string_view type, const json::Dict& query_map,
+                              int request_id) const {
     if (type == "Bus") {
         ProcessBusQuery(builder, query_map, request_id);
     } else if (type == "Stop") {
@@ -260,30 +546,27 @@ void StatReader::ProcessQuery(const json::Node& query) const {
         ProcessMapQuery(builder, request_id);
     } else {
         builder.StartDict()
-            .Key("request_id").Value(request_id)
             .Key("error_message").Value("invalid query type")
+            .Key("request_id").Value(request_id)
             .EndDict();
     }
-
-    json::Print(builder.Build(), std::cout, 0);
-    std::cout << "\n";
 }
 
-void StatReader::ProcessBusQuery(json::Builder& builder, const json::Dict& query_map, int request_id) const {
+void StatReader::ProcessBusQuery(json::Writer& builder, const json::Dict& query_map, int request_id) const {
     const std::string& bus_name = query_map.at("name").AsString();
     const transport_catalogue::Bus* bus = catalogue_.FindBus(bus_name);
 
     if (!bus) {
         builder.StartDict()
-            .Key("request_id").Value(request_id)
             .Key("error_message").Value("not found")
+            .Key("request_id").Value(request_id)
             .EndDict();
     } else {
         transport_catalogue::BusInfo bus_info = catalogue_.GetBusInfo(bus_name, request_id);
 
         builder.StartDict()
-            .Key("request_id").Value(bus_info.request_id)
             .Key("curvature").Value(bus_info.curvature)
+            .Key("request_id").Value(bus_info.request_id)
             .Key("route_length").Value(bus_info.route_length)
             .Key("stop_count").Value(bus_info.stop_count)
             .Key("unique_stop_count").Value(bus_info.unique_stop_count)
@@ -291,89 +574,177 @@ void StatReader::ProcessBusQuery(json::Builder& builder, const json::Dict& query
     }
 }
 
-void StatReader::ProcessStopQuery(json::Builder& builder, const json::Dict& query_map, int request_id) const {
+void StatReader::ProcessStopQuery(json::Writer& builder, const json::Dict& query_map, int request_id) const {
     const std::string& stop_name = query_map.at("name").AsString();
     const transport_catalogue::Stop* stop = catalogue_.FindStop(stop_name);
 
     if (!stop) {
         builder.StartDict()
-            .Key("request_id").Value(request_id)
             .Key("error_message").Value("not found")
+            .Key("request_id").Value(request_id)
             .EndDict();
     } else {
-        const auto& buses = catalogue_.GetBusesByStop(stop_name);
         builder.StartDict()
-            .Key("request_id").Value(request_id)
             .Key("buses").StartArray();
-        for (const transport_catalogue::Bus* bus : buses) {
+        for (const transport_catalogue::Bus* bus : catalogue_.GetBusesByStop(stop)) {
             builder.Value(bus->name);
         }
-        builder.EndArray().EndDict();
+        builder.EndArray()
+            .Key("request_id").Value(request_id)
+            .EndDict();
     }
 }
 
-void StatReader::ProcessMapQuery(json::Builder& builder, int request_id) const {
+void StatReader::ProcessMapQuery(json::Writer& builder, int request_id) const {
     builder.StartDict()
-        .Key("request_id").Value(request_id)
         .Key("error_message").Value("map rendering not implemented")
+        .Key("request_id").Value(request_id)
         .EndDict();
 }
 
-void JsonReader::ProcessRouteResponse(json::Builder& builder, const json::Dict& request_map, int id) {
-    std::string stop_from = request_map.at("from").AsString();
-    std::string stop_to = request_map.at("to").AsString();
+void JsonReader::ProcessRouteResponse(json::Writer& builder, const json::Dict& request_map, int id) {
+    const std::string& stop_from = request_map.at("from").AsString();
+    const std::string& stop_to = request_map.at("to").AsString();
 
     if (stop_from == stop_to) {
         builder.StartDict()
+            .Key("items").StartArray().EndArray()
             .Key("request_id").Value(id)
             .Key("total_time").Value(0)
-            .Key("items").StartArray().EndArray()
             .EndDict();
         return;
     }
 
+    auto route_info = GetRouter().GetRouteInfo(stop_from, stop_to);
+
+    if (!route_info) {
+        builder.StartDict()
+            .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
+            .EndDict();
+    } else {
+        builder.StartDict().Key("items");
+        WriteRouteItems(builder, *route_info);
+        builder.Key("request_id").Value(id)
+            .Key("total_time").Value(route_info->total_time)
+            .EndDict();
+    }
+}
+
+void JsonReader::ProcessRouteOptionsResponse(json::Writer& builder, const json::Dict& request_map, int id) {
+    const std::string& stop_from = request_map.at("from").AsString();
+    const std::string& stop_to = request_map.at("to").AsString();
+    const size_t max_transfers = request_map.count("max_transfers")
+        ? static_cast<size_t>(std::max(request_map.at("max_transfers").AsInt(), 0))
+        : transport::RaptorRouter::NO_TRANSFER_LIMIT;
+
+    const auto options = GetRaptorRouter().FindRouteOptions(stop_from, stop_to, max_transfers);
+    if (options.empty()) {
+        builder.StartDict()
+            .Key("error_message").Value("not found")
+            .Key("request_id").Value(id)
+            .EndDict();
+        return;
+    }
+
+    builder.StartDict().Key("options").StartArray();
+    for (const auto& option : options) {
+        builder.StartDict().Key("items");
+        WriteRouteItems(builder, option.route);
+        builder.Key("total_time").Value(option.route.total_time)
+            .Key("transfer_count").Value(static_cast<int>(option.transfer_count))
+            .EndDict();
+    }
+    builder.EndArray()
+        .Key("request_id").Value(id)
+        .EndDict();
+}
+
+void JsonReader::ProcessNearestStopsResponse(json::Writer& builder, const json::Dict& request_map, int id) {
+    const geo::Coordinates point{request_map.at("latitude").AsDouble(), request_map.at("longitude").AsDouble()};
+    const int count = request_map.count("count") ? request_map.at("count").AsInt() : 1;
+
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .Key("stops").StartArray();
+    for (const auto& [stop, distance] : GetStopIndex().FindNearest(point, static_cast<size_t>(std::max(count, 0)))) {
+        builder.StartDict()
+            .Key("distance").Value(distance)
+            .Key("name").Value(stop->name)
+            .EndDict();
+    }
+    builder.EndArray().EndDict();
+}
+
+void JsonReader::ProcessStopsInAreaResponse(json::Writer& builder, const json::Dict& request_map, int id) {
+    const geo::Coordinates min{request_map.at("min_latitude").AsDouble(), request_map.at("min_longitude").AsDouble()};
+    const geo::Coordinates max{request_map.at("max_latitude").AsDouble(), request_map.at("max_longitude").AsDouble()};
+
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .Key("stops").StartArray();
+    for (const auto* stop : GetStopIndex().FindInArea(min, max)) {
+        builder.Value(stop->name);
+    }
+    builder.EndArray().EndDict();
+}
+
+const transport_catalogue::StopSpatialIndex& JsonReader::GetStopIndex() {
+    std::lock_guard guard(cache_mutex_);
+    if (!cached_stop_index_ || stop_index_version_ != catalogue_.GetVersion()) {
+        cached_stop_index_.emplace(catalogue_);
+        stop_index_version_ = catalogue_.GetVersion();
+    }
+    return *cached_stop_index_;
+}
+
+const transport::RaptorRouter& JsonReader::GetRaptorRouter() {
+    std::lock_guard guard(cache_mutex_);
+    if (!cached_raptor_router_ || raptor_router_version_ != catalogue_.GetVersion()) {
+        const auto& routing_settings = catalogue_.GetRoutingSettings();
+        cached_raptor_router_.emplace(transport::RouterSettings{routing_settings.bus_wait_time,
+                                                                routing_settings.bus_velocity},
+                                      catalogue_);
+        raptor_router_version_ = catalogue_.GetVersion();
+    }
+    return *cached_raptor_router_;
+}
+
+const transport::Router& JsonReader::GetRouter() {
+    std::lock_guard guard(cache_mutex_);
     // Инициализация роутера при первом вызове
     if (!cached_router_) {
         transport::RouterSettings settings{
             catalogue_.GetRoutingSettings().bus_wait_time,
-            catalogue_.GetRoutingSettings().bus_velocity
+            catalogue_.GetRoutingSettings().bus_velocity,
+            catalogue_.GetRoutingSettings().use_geo_heuristic
         };
         cached_router_ = std::make_unique<transport::Router>(settings, catalogue_);
     }
+    return *cached_router_;
+}
 
-    auto route_info = cached_router_->GetRouteInfo(stop_from, stop_to);
+void JsonReader::SetRouter(std::unique_ptr<transport::Router> router) {
+    std::lock_guard guard(cache_mutex_);
+    cached_router_ = std::move(router);
+}
 
-    if (!route_info) {
-        builder.StartDict()
-            .Key("request_id").Value(id)
-            .Key("error_message").Value("not found")
-            .EndDict();
-    } else {
-        builder.StartDict()
-            .Key("request_id").Value(id)
-            .Key("total_time").Value(route_info->total_time)
-            .Key("items").StartArray();
-
-        for (const auto& item : route_info->items) {
-            if (std::holds_alternative<transport::WaitItem>(item)) {
-                const auto& wait = std::get<transport::WaitItem>(item);
-                builder.StartDict()
-                    .Key("type").Value("Wait")
-                    .Key("stop_name").Value(wait.stop_name)
-                    .Key("time").Value(wait.time)
-                    .EndDict();
-            } else {
-                const auto& bus = std::get<transport::BusItem>(item);
-                builder.StartDict()
-                    .Key("type").Value("Bus")
-                    .Key("bus").Value(bus.bus)
-                    .Key("span_count").Value(static_cast<int>(bus.span_count))
-                    .Key("time").Value(bus.time)
-                    .EndDict();
-            }
-        }
+void JsonReader::SetRequestStats(request_stats::RequestStats* stats) {
+    request_stats_ = stats;
+}
 
-        builder.EndArray().EndDict();
+void JsonReader::WriteRequestStats(json::Writer& writer) {
+    std::optional<graph::Router<double>::CacheStats> route_cache;
+    {
+        std::lock_guard guard(cache_mutex_);
+        if (cached_router_) {
+            route_cache = cached_router_->GetCacheStats();
+        }
+    }
+    if (request_stats_) {
+        request_stats_->Write(writer, route_cache);
+    } else {
+        request_stats::RequestStats().Write(writer, route_cache);
     }
 }
 
@@ -394,6 +765,9 @@ void JsonReader::LoadRoutingSettings(const json::Node& settings_node) {
     transport_catalogue::RoutingSettings settings;
     settings.bus_wait_time = settings_map.at("bus_wait_time").AsInt();
     settings.bus_velocity = settings_map.at("bus_velocity").AsDouble();
+    if (const auto it = settings_map.find("use_geo_heuristic"); it != settings_map.end()) {
+        settings.use_geo_heuristic = it->second.AsBool();
+    }
 
     catalogue_.SetRoutingSettings(settings);
 }
@@ -405,4 +779,167 @@ void JsonReader::SetDefaultRoutingSettings() {
     catalogue_.SetRoutingSettings(settings);
 }
 
+StreamLoader::StreamLoader(transport_catalogue::TransportCatalogue& catalogue)
+    : catalogue_(catalogue) {
+}
+
+void StreamLoader::OnNull() {
+    if (!in_base_requests_) {
+        dom_.OnNull();
+    }
+}
+
+void StreamLoader::OnBool(bool value) {
+    if (!in_base_requests_) {
+        dom_.OnBool(value);
+    } else if (depth_ == REQUEST_DEPTH && key_ == "is_roundtrip") {
+        bus_.is_roundtrip = value;
+        fields_ |= IS_ROUNDTRIP;
+    }
+}
+
+void StreamLoader::OnInt(int value) {
+    if (!in_base_requests_) {
+        dom_.OnInt(value);
+    } else if (depth_ == REQUEST_DEPTH + 1 && key_ == "road_distances") {
+        distances_.emplace_back(neighbor_names_.size() - 1, value);
+    } else {
+        OnNumber(value);
+    }
+}
+
+void StreamLoader::OnDouble(double value) {
+    if (!in_base_requests_) {
+        dom_.OnDouble(value);
+    } else if (depth_ == REQUEST_DEPTH + 1 && key_ == "road_distances") {
+        std::cerr << "Error: Distance is not an integer\n";
+    } else {
+        OnNumber(value);
+    }
+}
+
+void StreamLoader::OnString(std::string_view value) {
+    if (!in_base_requests_) {
+        dom_.OnString(value);
+    } else if (depth_ == REQUEST_DEPTH) {
+        if (key_ == "type") {
+            type_.assign(value);
+        } else if (key_ == "name") {
+            name_.assign(value);
+            fields_ |= NAME;
+        }
+    } else if (depth_ == REQUEST_DEPTH + 1 && key_ == "stops") {
+        bus_.stops.emplace_back(value);
+    }
+}
+
+void StreamLoader::OnStartDict() {
+    ++depth_;
+    if (!in_base_requests_) {
+        dom_.OnStartDict();
+    } else if (depth_ == REQUEST_DEPTH) {
+        // Начало очередного запроса: буферы очищаются, но сохраняют выделенную память
+        type_.clear();
+        name_.clear();
+        fields_ = 0;
+        distances_.clear();
+        neighbor_names_.clear();
+        bus_.stops.clear();
+        bus_.is_roundtrip = false;
+    } else if (depth_ == REQUEST_DEPTH + 1 && key_ == "road_distances") {
+        fields_ |= ROAD_DISTANCES;
+    }
+}
+
+void StreamLoader::OnKey(std::string_view key) {
+    if (!in_base_requests_) {
+        if (depth_ == 1 && key == "base_requests") {
+            in_base_requests_ = true;
+        }
+        dom_.OnKey(key);
+    } else if (depth_ == REQUEST_DEPTH) {
+        key_.assign(key);
+    } else if (depth_ == REQUEST_DEPTH + 1 && key_ == "road_distances") {
+        // Имена соседей хранятся до конца запроса: расстояния ссылаются на них по индексу
+        neighbor_names_.emplace_back(key);
+    }
+}
+
+void StreamLoader::OnEndDict() {
+    if (!in_base_requests_) {
+        dom_.OnEndDict();
+    } else if (depth_ == REQUEST_DEPTH) {
+        FinishRequest();
+    }
+    --depth_;
+}
+
+void StreamLoader::OnStartArray() {
+    ++depth_;
+    if (!in_base_requests_) {
+        dom_.OnStartArray();
+    } else if (depth_ == REQUEST_DEPTH + 1 && key_ == "stops") {
+        fields_ |= STOPS;
+    }
+}
+
+void StreamLoader::OnEndArray() {
+    if (in_base_requests_ && depth_ == BASE_REQUESTS_DEPTH) {
+        // Маршруты добавляются после всех остановок, как и при разборе через LoadData
+        for (const auto& bus : pending_buses_) {
+            AddBusByStopNames(catalogue_, bus.name,
+                              std::vector<std::string_view>(bus.stops.begin(), bus.stops.end()),
+                              bus.is_roundtrip);
+        }
+        pending_buses_.clear();
+        in_base_requests_ = false;
+        // В дереве остаётся пустой массив base_requests
+        dom_.OnStartArray();
+        dom_.OnEndArray();
+    } else if (!in_base_requests_) {
+        dom_.OnEndArray();
+    }
+    --depth_;
+}
+
+json::Document StreamLoader::ExtractDocument() {
+    return json::Document(dom_.ExtractRoot());
+}
+
+void StreamLoader::OnNumber(double value) {
+    if (depth_ != REQUEST_DEPTH) {
+        return; // Неизвестные поля запросов пропускаются
+    }
+    if (key_ == "latitude") {
+        coordinates_.lat = value;
+        fields_ |= LATITUDE;
+    } else if (key_ == "longitude") {
+        coordinates_.lng = value;
+        fields_ |= LONGITUDE;
+    }
+}
+
+void StreamLoader::FinishRequest() {
+    if (type_ == "Stop") {
+        if ((fields_ & (NAME | LATITUDE | LONGITUDE | ROAD_DISTANCES)) != (NAME | LATITUDE | LONGITUDE | ROAD_DISTANCES)) {
+            std::cerr << "Error: Missing required fields in Stop request\n";
+            return;
+        }
+        distance_views_.clear();
+        for (const auto& [neighbor_index, distance] : distances_) {
+            distance_views_.emplace_back(neighbor_names_[neighbor_index], distance);
+        }
+        AddStopWithDistances(catalogue_, name_, coordinates_, distance_views_);
+    } else if (type_ == "Bus") {
+        if ((fields_ & (NAME | IS_ROUNDTRIP | STOPS)) != (NAME | IS_ROUNDTRIP | STOPS)) {
+            std::cerr << "Error: Missing required fields in Bus request\n";
+            return;
+        }
+        bus_.name = name_;
+        pending_buses_.push_back(bus_);
+    } else if (type_.empty()) {
+        std::cerr << "Error: 'type' key not found in request\n";
+    }
+}
+
 } // namespace json_reader
\ No newline at end of file
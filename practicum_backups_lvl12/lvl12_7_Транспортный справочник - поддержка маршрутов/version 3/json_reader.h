@@ -2,9 +2,17 @@
 
 #include "transport_catalogue.h"
 #include "map_renderer.h"
+#include "map_tiles.h"
+#include "raptor_router.h"
+#include "request_stats.h"
+#include "spatial_index.h"
 #include "json.h"
-#include "json_builder.h"
+#include "json_sax.h"
+#include "json_writer.h"
 #include "transport_router.h"
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -17,21 +25,91 @@ public:
     JsonReader(transport_catalogue::TransportCatalogue& catalogue);
 
     void LoadData(const json::Node& data);
-    json::Node ProcessRequests(const json::Node& requests, const json::Node& render_settings);
+    // Правки уже загруженной базы (update_requests), по порядку: Stop и Bus добавляют или
+    // заменяют объект, RemoveBus удаляет маршрут, Distance меняет одно расстояние,
+    // RoutingSettings - время ожидания, скорость и use_geo_heuristic. Построенный роутер
+    // не перестраивается, а правится на месте; только смена скорости или use_geo_heuristic
+    // требует построить его заново
+    void ApplyUpdates(const json::Node& update_requests);
+    // Ответы пишутся сразу в writer, массивом в порядке запросов
+    void ProcessRequests(const json::Node& requests, const json::Node& render_settings, json::Writer& writer);
+    void ProcessRequests(const json::Node& requests, const map_renderer::RenderSettings& render_settings,
+                         json::Writer& writer);
+    // Ответ на один запрос. Пока справочник не меняется, запросы можно обрабатывать
+    // одновременно из нескольких потоков: ленивые кэши ниже защищены мьютексом.
+    // Возвращает false для запроса без ответа (не словарь, нет строки type или целого id,
+    // неизвестный тип)
+    bool ProcessRequest(const json::Node& request, const map_renderer::RenderSettings& render_settings,
+                        json::Writer& writer);
     void LoadRoutingSettings(const json::Node& settings_node);
     void SetDefaultRoutingSettings();
 
+    // Роутер строится при первом обращении, либо подставляется готовый (из снимка базы)
+    const transport::Router& GetRouter();
+    void SetRouter(std::unique_ptr<transport::Router> router);
+
+    // SVG карты отрисовывается один раз и отдаётся всем запросам Map, пока не изменились
+    // справочник или настройки отрисовки
+    std::shared_ptr<const std::string> GetMapSvg(const map_renderer::RenderSettings& render_settings);
+    // Нарезчик тайлов с уже спроецированными остановками, пересоздаётся так же, как SVG карты
+    std::shared_ptr<const map_renderer::TileRenderer> GetTileRenderer(const map_renderer::RenderSettings& render_settings);
+    // Пространственный индекс остановок, строится при первом запросе после изменения справочника
+    const transport_catalogue::StopSpatialIndex& GetStopIndex();
+    // Поиск вариантов маршрута по раундам, пересоздаётся так же, как пространственный индекс
+    const transport::RaptorRouter& GetRaptorRouter();
+
+    // Включает учёт времени и выделений памяти по типам запросов (nullptr - выключает).
+    // Статистика не принадлежит читателю и должна жить дольше него
+    void SetRequestStats(request_stats::RequestStats* stats);
+    // Накопленная статистика вместе с попаданиями в кэш роутера, если он уже построен
+    void WriteRequestStats(json::Writer& writer);
+
 private:
+    struct MapCache {
+        uint64_t catalogue_version;
+        map_renderer::RenderSettings render_settings;
+        std::shared_ptr<const std::string> svg;
+    };
+
+    struct TileRendererCache {
+        uint64_t catalogue_version;
+        map_renderer::RenderSettings render_settings;
+        std::shared_ptr<const map_renderer::TileRenderer> renderer;
+    };
+
     transport_catalogue::TransportCatalogue& catalogue_;
+    // Защищает ленивое построение роутеров, индексов и кэшей карты
+    std::mutex cache_mutex_;
     std::optional<graph::DirectedWeightedGraph<double>> cached_graph_;
     std::unique_ptr<transport::Router> cached_router_;
+    std::optional<MapCache> cached_map_;
+    std::optional<TileRendererCache> cached_tile_renderer_;
+    std::optional<transport_catalogue::StopSpatialIndex> cached_stop_index_;
+    uint64_t stop_index_version_ = 0;
+    std::optional<transport::RaptorRouter> cached_raptor_router_;
+    uint64_t raptor_router_version_ = 0;
+    request_stats::RequestStats* request_stats_ = nullptr;
 
+    bool DispatchRequest(std::string_view type, const json::Dict& request_map, int id,
+                         const map_renderer::RenderSettings& render_settings, json::Writer& builder);
     void ProcessStopRequest(const json::Dict& request_map);
     void ProcessBusRequest(const json::Dict& request_map);
-    void ProcessStopResponse(json::Builder& builder, const json::Dict& request_map, int id);
-    void ProcessBusResponse(json::Builder& builder, const json::Dict& request_map, int id);
-    void ProcessMapResponse(json::Builder& builder, int id, const json::Node& render_settings);
-    void ProcessRouteResponse(json::Builder& builder, const json::Dict& request_map, int id);
+    void ProcessStopUpdate(const json::Dict& request_map);
+    void ProcessBusUpdate(const json::Dict& request_map);
+    void ProcessRemoveBusUpdate(const json::Dict& request_map);
+    void ProcessDistanceUpdate(const json::Dict& request_map);
+    void ProcessRoutingSettingsUpdate(const json::Dict& request_map);
+    // Пересчитывает в роутере время поездок маршрутов через остановку
+    void RefreshRouterBusesAtStop(const transport_catalogue::Stop* stop);
+    void ProcessStopResponse(json::Writer& builder, const json::Dict& request_map, int id);
+    void ProcessBusResponse(json::Writer& builder, const json::Dict& request_map, int id);
+    void ProcessMapResponse(json::Writer& builder, int id, const map_renderer::RenderSettings& render_settings);
+    void ProcessMapTileResponse(json::Writer& builder, const json::Dict& request_map, int id,
+                                const map_renderer::RenderSettings& render_settings);
+    void ProcessRouteResponse(json::Writer& builder, const json::Dict& request_map, int id);
+    void ProcessRouteOptionsResponse(json::Writer& builder, const json::Dict& request_map, int id);
+    void ProcessNearestStopsResponse(json::Writer& builder, const json::Dict& request_map, int id);
+    void ProcessStopsInAreaResponse(json::Writer& builder, const json::Dict& request_map, int id);
 };
 
 class StatReader {
@@ -42,9 +120,75 @@ public:
 private:
     const transport_catalogue::TransportCatalogue& catalogue_;
 
-    void ProcessBusQuery(json::Builder& builder, const json::Dict& query_map, int request_id) const;
-    void ProcessStopQuery(json::Builder& builder, const json::Dict& query_map, int request_id) const;
-    void ProcessMapQuery(json::Builder& builder, int request_id) const;
+    void ProcessQuery(json::Writer& builder, std::string_view type, const json::Dict& query_map, int request_id) const;
+    void ProcessBusQuery(json::Writer& builder, const json::Dict& query_map, int request_id) const;
+    void ProcessStopQuery(json::Writer& builder, const json::Dict& query_map, int request_id) const;
+    void ProcessMapQuery(json::Writer& builder, int request_id) const;
+};
+
+// Загружает входной документ за один проход потокового парсера: запросы base_requests
+// сразу попадают в справочник, не превращаясь в json::Node, а остальные разделы
+// собираются в обычное дерево (base_requests в нём остаётся пустым массивом)
+class StreamLoader final : public json::Handler {
+public:
+    explicit StreamLoader(transport_catalogue::TransportCatalogue& catalogue);
+
+    void OnNull() override;
+    void OnBool(bool value) override;
+    void OnInt(int value) override;
+    void OnDouble(double value) override;
+    void OnString(std::string_view value) override;
+
+    void OnStartDict() override;
+    void OnKey(std::string_view key) override;
+    void OnEndDict() override;
+
+    void OnStartArray() override;
+    void OnEndArray() override;
+
+    json::Document ExtractDocument();
+
+private:
+    // Глубина: 1 - корневой словарь, 2 - массив base_requests, 3 - словарь запроса
+    static constexpr int BASE_REQUESTS_DEPTH = 2;
+    static constexpr int REQUEST_DEPTH = 3;
+
+    enum Field : unsigned {
+        NAME = 1,
+        LATITUDE = 2,
+        LONGITUDE = 4,
+        ROAD_DISTANCES = 8,
+        IS_ROUNDTRIP = 16,
+        STOPS = 32,
+    };
+
+    struct BusRequest {
+        std::string name;
+        std::vector<std::string> stops;
+        bool is_roundtrip = false;
+    };
+
+    void OnNumber(double value);
+    void FinishRequest();
+
+    transport_catalogue::TransportCatalogue& catalogue_;
+    json::DomBuilder dom_;
+    int depth_ = 0;
+    bool in_base_requests_ = false;
+
+    // Поля текущего запроса
+    std::string key_;
+    std::string type_;
+    std::string name_;
+    unsigned fields_ = 0;
+    geo::Coordinates coordinates_;
+    std::vector<std::string> neighbor_names_;
+    std::vector<std::pair<size_t, int>> distances_; // Индекс в neighbor_names_ и расстояние
+    std::vector<std::pair<std::string_view, int>> distance_views_;
+    BusRequest bus_;
+
+    // Маршруты могут ссылаться на остановки, описанные позже, поэтому добавляются в конце
+    std::vector<BusRequest> pending_buses_;
 };
 
 } // namespace json_reader
\ No newline at end of file
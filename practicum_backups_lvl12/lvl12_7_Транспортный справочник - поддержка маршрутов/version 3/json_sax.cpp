@@ -0,0 +1,358 @@
+#include "json_sax.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace json {
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 1 << 16;
+
+// Источник символов: либо блоки из потока, либо готовая строка целиком
+class Reader {
+public:
+    explicit Reader(std::istream& input)
+        : input_(&input)
+        , buffer_(BUFFER_SIZE) {
+    }
+
+    explicit Reader(std::string_view input)
+        : pos_(input.data())
+        , end_(input.data() + input.size()) {
+    }
+
+    // Текущий символ или -1 в конце входа
+    int Peek() {
+        if (pos_ == end_ && !Refill()) {
+            return -1;
+        }
+        return static_cast<unsigned char>(*pos_);
+    }
+
+    void Advance() {
+        ++pos_;
+    }
+
+    int SkipSpaces() {
+        while (true) {
+            while (pos_ != end_) {
+                const char c = *pos_;
+                if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+                    return static_cast<unsigned char>(c);
+                }
+                ++pos_;
+            }
+            if (!Refill()) {
+                return -1;
+            }
+        }
+    }
+
+    // Непрочитанная часть текущего блока
+    const char* Position() const {
+        return pos_;
+    }
+    const char* End() const {
+        return end_;
+    }
+    void SetPosition(const char* pos) {
+        pos_ = pos;
+    }
+
+private:
+    bool Refill() {
+        if (!input_ || !*input_) {
+            return false;
+        }
+        input_->read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        const size_t count = static_cast<size_t>(input_->gcount());
+        pos_ = buffer_.data();
+        end_ = pos_ + count;
+        return count > 0;
+    }
+
+    std::istream* input_ = nullptr;
+    std::vector<char> buffer_;
+    const char* pos_ = nullptr;
+    const char* end_ = nullptr;
+};
+
+class Parser {
+public:
+    Parser(Reader& reader, Handler& handler)
+        : reader_(reader)
+        , handler_(handler) {
+    }
+
+    void ParseValue() {
+        const int c = reader_.SkipSpaces();
+        switch (c) {
+            case '{': ParseDict(); break;
+            case '[': ParseArray(); break;
+            case '"': handler_.OnString(ParseString()); break;
+            case 't': case 'f': case 'n': ParseLiteral(); break;
+            case -1: throw ParsingError("Unexpected end of input");
+            default: ParseNumber(); break;
+        }
+    }
+
+private:
+    void Expect(char expected) {
+        if (NextStructural() != expected) {
+            throw ParsingError(std::string("Expected '") + expected + "'");
+        }
+    }
+
+    // Пропускает пробелы и забирает следующий символ разметки
+    int NextStructural() {
+        const int c = reader_.SkipSpaces();
+        if (c == -1) {
+            throw ParsingError("Unexpected end of input");
+        }
+        reader_.Advance();
+        return c;
+    }
+
+    void ParseDict() {
+        reader_.Advance();
+        handler_.OnStartDict();
+        if (reader_.SkipSpaces() == '}') {
+            reader_.Advance();
+            handler_.OnEndDict();
+            return;
+        }
+        while (true) {
+            if (reader_.SkipSpaces() != '"') {
+                throw ParsingError("Expected '\"' at the start of a key in dictionary");
+            }
+            handler_.OnKey(ParseString());
+            Expect(':');
+            ParseValue();
+
+            const int c = NextStructural();
+            if (c == '}') {
+                break;
+            }
+            if (c != ',') {
+                throw ParsingError("Expected ',' or '}' in dictionary");
+            }
+        }
+        handler_.OnEndDict();
+    }
+
+    void ParseArray() {
+        reader_.Advance();
+        handler_.OnStartArray();
+        if (reader_.SkipSpaces() == ']') {
+            reader_.Advance();
+            handler_.OnEndArray();
+            return;
+        }
+        while (true) {
+            ParseValue();
+
+            const int c = NextStructural();
+            if (c == ']') {
+                break;
+            }
+            if (c != ',') {
+                throw ParsingError("Expected ',' or ']' in array");
+            }
+        }
+        handler_.OnEndArray();
+    }
+
+    // Текущий символ - открывающая кавычка
+    std::string_view ParseString() {
+        reader_.Advance();
+
+        // Строка без экранирования целиком внутри блока отдаётся без копирования
+        const char* begin = reader_.Position();
+        const char* end = reader_.End();
+        for (const char* it = begin; it != end; ++it) {
+            if (*it == '"') {
+                reader_.SetPosition(it + 1);
+                return {begin, static_cast<size_t>(it - begin)};
+            }
+            if (*it == '\\') {
+                break;
+            }
+        }
+
+        scratch_.clear();
+        while (true) {
+            const int c = reader_.Peek();
+            if (c == -1) {
+                throw ParsingError("Unexpected end of input in string: \"" + scratch_);
+            }
+            reader_.Advance();
+            if (c == '"') {
+                return scratch_;
+            }
+            if (c != '\\') {
+                scratch_ += static_cast<char>(c);
+                continue;
+            }
+            const int escaped = reader_.Peek();
+            if (escaped == -1) {
+                throw ParsingError("Unexpected end of input in string: \"" + scratch_);
+            }
+            reader_.Advance();
+            switch (escaped) {
+                case 'n': scratch_ += '\n'; break;
+                case 'r': scratch_ += '\r'; break;
+                case 't': scratch_ += '\t'; break;
+                case '"': scratch_ += '"'; break;
+                case '\\': scratch_ += '\\'; break;
+                case '/': scratch_ += '/'; break;
+                default:
+                    throw ParsingError("Invalid escape sequence in string: \"" + scratch_ + "\"");
+            }
+        }
+    }
+
+    void ParseLiteral() {
+        scratch_.clear();
+        for (int c = reader_.Peek(); c >= 'a' && c <= 'z'; c = reader_.Peek()) {
+            scratch_ += static_cast<char>(c);
+            reader_.Advance();
+        }
+        if (scratch_ == "true") {
+            handler_.OnBool(true);
+        } else if (scratch_ == "false") {
+            handler_.OnBool(false);
+        } else if (scratch_ == "null" || scratch_ == "nullptr") {
+            handler_.OnNull();
+        } else {
+            throw ParsingError("Invalid value: expected 'true', 'false', 'null', or 'nullptr', but got: " + scratch_);
+        }
+    }
+
+    static bool IsNumberChar(int c) {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    void ParseNumber() {
+        scratch_.clear();
+        bool is_double = false;
+        for (int c = reader_.Peek(); IsNumberChar(c); c = reader_.Peek()) {
+            is_double = is_double || c == '.' || c == 'e' || c == 'E';
+            scratch_ += static_cast<char>(c);
+            reader_.Advance();
+        }
+
+        const char* first = scratch_.data();
+        const char* last = first + scratch_.size();
+        if (is_double) {
+            double value = 0.0;
+            CheckNumber(std::from_chars(first, last, value), last);
+            handler_.OnDouble(value);
+        } else {
+            int value = 0;
+            CheckNumber(std::from_chars(first, last, value), last);
+            handler_.OnInt(value);
+        }
+    }
+
+    void CheckNumber(std::from_chars_result result, const char* last) const {
+        if (result.ec == std::errc::result_out_of_range) {
+            throw ParsingError("Number out of range");
+        }
+        if (result.ec != std::errc{} || result.ptr != last) {
+            throw ParsingError("Invalid number format");
+        }
+    }
+
+    Reader& reader_;
+    Handler& handler_;
+    // Буфер для строк, пересекающих границу блока или содержащих экранирование
+    std::string scratch_;
+};
+
+}  // namespace
+
+void Parse(std::istream& input, Handler& handler) {
+    Reader reader(input);
+    Parser(reader, handler).ParseValue();
+}
+
+void Parse(std::string_view input, Handler& handler) {
+    Reader reader(input);
+    Parser(reader, handler).ParseValue();
+}
+
+// Реализация DomBuilder
+
+void DomBuilder::OnNull() {
+    AddValue(Node(nullptr));
+}
+
+void DomBuilder::OnBool(bool value) {
+    AddValue(Node(value));
+}
+
+void DomBuilder::OnInt(int value) {
+    AddValue(Node(value));
+}
+
+void DomBuilder::OnDouble(double value) {
+    AddValue(Node(value));
+}
+
+void DomBuilder::OnString(std::string_view value) {
+    AddValue(Node(std::string(value)));
+}
+
+void DomBuilder::OnStartDict() {
+    stack_.emplace_back().is_dict = true;
+}
+
+void DomBuilder::OnKey(std::string_view key) {
+    stack_.back().key.assign(key);
+}
+
+void DomBuilder::OnEndDict() {
+    Dict dict = std::move(stack_.back().dict);
+    stack_.pop_back();
+    AddValue(Node(std::move(dict)));
+}
+
+void DomBuilder::OnStartArray() {
+    stack_.emplace_back();
+}
+
+void DomBuilder::OnEndArray() {
+    Array array = std::move(stack_.back().array);
+    stack_.pop_back();
+    AddValue(Node(std::move(array)));
+}
+
+bool DomBuilder::IsComplete() const {
+    return complete_;
+}
+
+Node DomBuilder::ExtractRoot() {
+    if (!complete_) {
+        throw std::logic_error("JSON value is not complete");
+    }
+    complete_ = false;
+    return std::move(root_);
+}
+
+void DomBuilder::AddValue(Node value) {
+    if (stack_.empty()) {
+        root_ = std::move(value);
+        complete_ = true;
+        return;
+    }
+    Frame& frame = stack_.back();
+    if (frame.is_dict) {
+        // Как и раньше, при повторе ключа остаётся первое значение
+        frame.dict.emplace(std::move(frame.key), std::move(value));
+    } else {
+        frame.array.push_back(std::move(value));
+    }
+}
+
+}  // namespace json
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "json.h"
+
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Потоковый (SAX) разбор JSON: парсер читает вход блоками и сообщает обработчику о каждом
+// элементе, не строя дерево. Строки и ключи передаются как string_view на внутренний буфер
+// парсера и действительны только до возврата из обработчика
+namespace json {
+
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    virtual void OnNull() = 0;
+    virtual void OnBool(bool value) = 0;
+    virtual void OnInt(int value) = 0;
+    virtual void OnDouble(double value) = 0;
+    virtual void OnString(std::string_view value) = 0;
+
+    virtual void OnStartDict() = 0;
+    virtual void OnKey(std::string_view key) = 0;
+    virtual void OnEndDict() = 0;
+
+    virtual void OnStartArray() = 0;
+    virtual void OnEndArray() = 0;
+};
+
+// Разбирает одно значение JSON из input. Вход читается блоками, поэтому поток может быть
+// прочитан дальше конца значения. Бросает ParsingError при ошибке синтаксиса
+void Parse(std::istream& input, Handler& handler);
+void Parse(std::string_view input, Handler& handler);
+
+// Собирает из событий дерево json::Node
+class DomBuilder final : public Handler {
+public:
+    void OnNull() override;
+    void OnBool(bool value) override;
+    void OnInt(int value) override;
+    void OnDouble(double value) override;
+    void OnString(std::string_view value) override;
+
+    void OnStartDict() override;
+    void OnKey(std::string_view key) override;
+    void OnEndDict() override;
+
+    void OnStartArray() override;
+    void OnEndArray() override;
+
+    // Готов ли корень: пришло законченное значение верхнего уровня
+    bool IsComplete() const;
+    Node ExtractRoot();
+
+private:
+    struct Frame {
+        bool is_dict = false;
+        Dict dict;
+        Array array;
+        std::string key;
+    };
+
+    void AddValue(Node value);
+
+    std::vector<Frame> stack_;
+    Node root_;
+    bool complete_ = false;
+};
+
+}  // namespace json
@@ -0,0 +1,264 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+
+namespace json {
+
+Writer::Writer(std::ostream& output, WriterSettings settings)
+    : output_(output)
+    , settings_(settings) {
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+Writer::DictItemContext Writer::StartDict() {
+    StartContainer(true, '{');
+    return DictItemContext(*this);
+}
+
+Writer::ArrayItemContext Writer::StartArray() {
+    StartContainer(false, '[');
+    return ArrayItemContext(*this);
+}
+
+Writer::KeyContext Writer::Key(std::string_view key) {
+    if (stack_.empty() || !stack_.back().is_dict) {
+        throw std::logic_error("Key() called outside of a dictionary");
+    }
+    Frame& frame = stack_.back();
+    if (frame.key_is_entered) {
+        throw std::logic_error("Key() called after Key() without a value");
+    }
+    if (frame.has_items) {
+        Write(settings_.pretty ? ",\n" : ",");
+    }
+    if (settings_.pretty) {
+        WriteIndent(stack_.size());
+    }
+    WriteString(key);
+    Write(settings_.pretty ? ": " : ":");
+    frame.has_items = true;
+    frame.key_is_entered = true;
+    return KeyContext(*this);
+}
+
+Writer& Writer::EndDict() {
+    EndContainer(true, '}');
+    return *this;
+}
+
+Writer& Writer::EndArray() {
+    EndContainer(false, ']');
+    return *this;
+}
+
+Writer& Writer::Value(std::nullptr_t) {
+    BeginValue();
+    Write("null");
+    return *this;
+}
+
+Writer& Writer::Value(bool value) {
+    BeginValue();
+    Write(value ? "true" : "false");
+    return *this;
+}
+
+Writer& Writer::Value(int value) {
+    BeginValue();
+    char digits[16];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+    Write(std::string_view(digits, result.ptr - digits));
+    return *this;
+}
+
+Writer& Writer::Value(double value) {
+    BeginValue();
+    char digits[64];
+    const auto result = settings_.double_precision
+        ? std::to_chars(std::begin(digits), std::end(digits), value, std::chars_format::general, *settings_.double_precision)
+        : std::to_chars(std::begin(digits), std::end(digits), value);
+    Write(std::string_view(digits, result.ptr - digits));
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    BeginValue();
+    WriteString(value);
+    return *this;
+}
+
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const std::string& value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const Node& node) {
+    if (node.IsNull()) {
+        Value(nullptr);
+    } else if (node.IsInt()) {
+        Value(node.AsInt());
+    } else if (node.IsPureDouble()) {
+        Value(node.AsDouble());
+    } else if (node.IsBool()) {
+        Value(node.AsBool());
+    } else if (node.IsString()) {
+        Value(node.AsString());
+    } else if (node.IsArray()) {
+        StartArray();
+        for (const Node& item : node.AsArray()) {
+            Value(item);
+        }
+        EndArray();
+    } else if (node.IsMap()) {
+        StartDict();
+        for (const auto& [key, value] : node.AsMap()) {
+            Key(key);
+            Value(value);
+        }
+        EndDict();
+    }
+    return *this;
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+void Writer::BeginValue() {
+    if (stack_.empty()) {
+        if (has_root_) {
+            throw std::logic_error("Value() called after the root value is complete");
+        }
+        has_root_ = true;
+        return;
+    }
+    Frame& frame = stack_.back();
+    if (frame.is_dict) {
+        if (!frame.key_is_entered) {
+            throw std::logic_error("Value() called in a dictionary without a key");
+        }
+        frame.key_is_entered = false;
+        return;
+    }
+    if (frame.has_items) {
+        Write(settings_.pretty ? ",\n" : ",");
+    }
+    if (settings_.pretty) {
+        WriteIndent(stack_.size());
+    }
+    frame.has_items = true;
+}
+
+void Writer::StartContainer(bool is_dict, char bracket) {
+    BeginValue();
+    Write(bracket);
+    if (settings_.pretty) {
+        Write('\n');
+    }
+    stack_.push_back({is_dict});
+}
+
+void Writer::EndContainer(bool is_dict, char bracket) {
+    if (stack_.empty() || stack_.back().is_dict != is_dict) {
+        throw std::logic_error(is_dict ? "EndDict() called outside of a dictionary"
+                                       : "EndArray() called outside of an array");
+    }
+    if (stack_.back().key_is_entered) {
+        throw std::logic_error("EndDict() called after Key() without a value");
+    }
+    stack_.pop_back();
+    if (settings_.pretty) {
+        // Как у json::Print: перевод строки и отступ даже у пустого контейнера
+        Write('\n');
+        WriteIndent(stack_.size());
+    }
+    Write(bracket);
+}
+
+void Writer::WriteIndent(size_t depth) {
+    buffer_.append(settings_.indent + depth * 4, ' ');
+    if (buffer_.size() >= BUFFER_SIZE) {
+        Flush();
+    }
+}
+
+void Writer::WriteString(std::string_view value) {
+    Write('"');
+    size_t plain_begin = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        std::string_view escaped;
+        switch (value[i]) {
+            case '"': escaped = "\\\""; break;
+            case '\\': escaped = "\\\\"; break;
+            case '\n': escaped = "\\n"; break;
+            case '\r': escaped = "\\r"; break;
+            case '\t': escaped = "\\t"; break;
+            default: continue;
+        }
+        Write(value.substr(plain_begin, i - plain_begin));
+        Write(escaped);
+        plain_begin = i + 1;
+    }
+    Write(value.substr(plain_begin));
+    Write('"');
+}
+
+void Writer::Write(std::string_view text) {
+    if (buffer_.size() + text.size() > BUFFER_SIZE) {
+        Flush();
+        if (text.size() > BUFFER_SIZE) {
+            output_.write(text.data(), static_cast<std::streamsize>(text.size()));
+            return;
+        }
+    }
+    buffer_.append(text);
+}
+
+void Writer::Write(char c) {
+    if (buffer_.size() >= BUFFER_SIZE) {
+        Flush();
+    }
+    buffer_.push_back(c);
+}
+
+// Реализация методов вспомогательных классов
+
+Writer::KeyContext Writer::DictItemContext::Key(std::string_view key) {
+    return writer_.Key(key);
+}
+
+Writer& Writer::DictItemContext::EndDict() {
+    return writer_.EndDict();
+}
+
+Writer::DictItemContext Writer::ArrayItemContext::StartDict() {
+    return writer_.StartDict();
+}
+
+Writer::ArrayItemContext Writer::ArrayItemContext::StartArray() {
+    return writer_.StartArray();
+}
+
+Writer& Writer::ArrayItemContext::EndArray() {
+    return writer_.EndArray();
+}
+
+Writer::DictItemContext Writer::KeyContext::StartDict() {
+    return writer_.StartDict();
+}
+
+Writer::ArrayItemContext Writer::KeyContext::StartArray() {
+    return writer_.StartArray();
+}
+
+}  // namespace json
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "json.h"
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+struct WriterSettings {
+    // Форматирование как у json::Print с отступом indent; иначе вывод без пробелов и переводов строк
+    bool pretty = true;
+    int indent = 0;
+    // Число значащих цифр для double (как у std::ostream). Без значения выводится
+    // кратчайшая запись, которая читается обратно в то же число
+    std::optional<int> double_precision;
+};
+
+// Пишет JSON сразу в поток, не строя дерево Node. Интерфейс повторяет json::Builder,
+// но ключи словаря выводятся в порядке вызовов, а не по алфавиту. Вывод буферизуется,
+// память - O(глубины вложенности). Буфер сбрасывается в Flush и в деструкторе
+class Writer {
+public:
+    class BaseContext {
+    public:
+        BaseContext(Writer& writer) : writer_(writer) {}
+
+    protected:
+        Writer& writer_;
+    };
+
+    class KeyContext;
+    class ArrayItemContext;
+
+    class DictItemContext : public BaseContext {
+    public:
+        using BaseContext::BaseContext;
+
+        KeyContext Key(std::string_view key);
+        Writer& EndDict();
+    };
+
+    class ArrayItemContext : public BaseContext {
+    public:
+        using BaseContext::BaseContext;
+
+        template <typename T>
+        ArrayItemContext Value(const T& value) {
+            writer_.Value(value);
+            return *this;
+        }
+        DictItemContext StartDict();
+        ArrayItemContext StartArray();
+        Writer& EndArray();
+    };
+
+    class KeyContext : public BaseContext {
+    public:
+        using BaseContext::BaseContext;
+
+        template <typename T>
+        DictItemContext Value(const T& value) {
+            writer_.Value(value);
+            return DictItemContext(writer_);
+        }
+        DictItemContext StartDict();
+        ArrayItemContext StartArray();
+    };
+
+    explicit Writer(std::ostream& output, WriterSettings settings = {});
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    DictItemContext StartDict();
+    ArrayItemContext StartArray();
+    KeyContext Key(std::string_view key);
+    Writer& EndDict();
+    Writer& EndArray();
+
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    Writer& Value(const char* value);
+    Writer& Value(const std::string& value);
+    // Готовое дерево выводится целиком
+    Writer& Value(const Node& node);
+
+    // Отдаёт накопленный вывод в поток
+    void Flush();
+
+private:
+    struct Frame {
+        bool is_dict;
+        bool has_items = false;
+        bool key_is_entered = false;
+    };
+
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+    void BeginValue();
+    void StartContainer(bool is_dict, char bracket);
+    void EndContainer(bool is_dict, char bracket);
+    void WriteIndent(size_t depth);
+    void WriteString(std::string_view value);
+    void Write(std::string_view text);
+    void Write(char c);
+
+    std::ostream& output_;
+    WriterSettings settings_;
+    std::string buffer_;
+    std::vector<Frame> stack_;
+    bool has_root_ = false;
+};
+
+}  // namespace json
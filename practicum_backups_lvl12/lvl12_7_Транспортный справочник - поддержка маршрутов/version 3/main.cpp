@@ -4,52 +4,202 @@
 #include "json_reader.h"
 #include "json.h"
 #include "map_renderer.h"
+#include "map_tiles.h"
 #include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
 #include "svg.h"
+#include "binary_io.h"
+#include "serialization.h"
+#include "query_server.h"
+#include "request_stats.h"
 
-std::string LoadDocumentFromStream(std::istream& input) {
-    std::string input_json;
-    int brace_count = 0; // Счетчик фигурных скобок
-    char ch;
-
-    // Пропускаем все символы, пока не встретим '{'
-    while (input.get(ch)) {
-        if (ch == '{') {
-            input_json += ch; // Добавляем '{' в строку
-            brace_count++; // Увеличиваем счетчик
-            break; // Выходим из цикла, когда нашли '{'
-        }
+using namespace std::literals;
+
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue [make_base|process_requests|render_tiles|serve]\n"sv;
+}
+
+// Путь к файлу снимка из "serialization_settings": {"file": "..."}
+std::string GetSnapshotPath(const json::Node& root) {
+    return root.AsMap().at("serialization_settings").AsMap().at("file").AsString();
+}
+
+// Статистика запросов по "stats_settings": {"file": "..."}; без "file" - в стандартный поток ошибок
+template <typename StatsSource>
+void WriteRequestStats(const json::Node& stats_settings, StatsSource& source) {
+    const auto& settings = stats_settings.AsMap();
+    std::ofstream file;
+    if (const auto file_it = settings.find("file"); file_it != settings.end()) {
+        file.open(file_it->second.AsString());
+    }
+    std::ostream& out = file.is_open() ? file : std::cerr;
+    {
+        json::Writer writer(out, {true, 0, 6});
+        source.WriteRequestStats(writer);
     }
+    out << '\n';
+}
 
-    // Считываем оставшуюся часть JSON
-    while (input.get(ch)) {
-        input_json += ch;
+// Загружает базу из base_requests, строит роутер и сохраняет всё в двоичный снимок
+int MakeBase(std::istream& input) {
+    transport_catalogue::TransportCatalogue catalogue;
+    json_reader::JsonReader json_reader(catalogue);
+    // base_requests попадают в справочник прямо во время разбора
+    json_reader::StreamLoader loader(catalogue);
+    json::Parse(input, loader);
+    const json::Document input_data = loader.ExtractDocument();
+    const auto& root = input_data.GetRoot().AsMap();
 
-        if (ch == '{') {
-            brace_count++;
-        } else if (ch == '}') {
-            brace_count--;
-        }
+    if (root.count("routing_settings")) {
+        json_reader.LoadRoutingSettings(root.at("routing_settings"));
+    } else {
+        std::cerr << "Warning: 'routing_settings' key not found in JSON data. Using default settings.\n";
+    }
+
+    std::ofstream out(GetSnapshotPath(input_data.GetRoot()), std::ios::binary);
+    if (!out) {
+        std::cerr << "Error: cannot open snapshot file for writing\n";
+        return 1;
+    }
+    serialization::SaveSnapshot(out, catalogue,
+                                map_renderer::ParseRenderSettings(root.at("render_settings")),
+                                json_reader.GetRouter());
+    return 0;
+}
+
+// Отвечает на stat_requests по ранее сохранённому снимку, без разбора базы и построения графа
+int ProcessRequests(std::istream& input) {
+    const json::Document input_data = json::Load(input);
+    std::ifstream in(GetSnapshotPath(input_data.GetRoot()), std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: cannot open snapshot file\n";
+        return 1;
+    }
+    transport_catalogue::TransportCatalogue catalogue;
+    auto snapshot = serialization::LoadSnapshot(in, catalogue);
+
+    json_reader::JsonReader json_reader(catalogue);
+    json_reader.SetRouter(std::move(snapshot.router));
+    const auto& root = input_data.GetRoot().AsMap();
+    if (root.count("update_requests")) {
+        json_reader.ApplyUpdates(root.at("update_requests"));
+    }
+    request_stats::RequestStats stats;
+    if (root.count("stats_settings")) {
+        json_reader.SetRequestStats(&stats);
+    }
+
+    {
+        json::Writer writer(std::cout, {true, 4, 6});
+        json_reader.ProcessRequests(root.at("stat_requests"), snapshot.render_settings, writer);
+    }
+    if (root.count("stats_settings")) {
+        WriteRequestStats(root.at("stats_settings"), json_reader);
+    }
+    return 0;
+}
+
+// Нарезает карту из снимка на тайлы в каталог "tile_settings": {"directory": "..."}.
+// Перезаписываются только изменившиеся тайлы
+int RenderTiles(std::istream& input) {
+    const json::Document input_data = json::Load(input);
+    std::ifstream in(GetSnapshotPath(input_data.GetRoot()), std::ios::binary);
+    if (!in) {
+        std::cerr << "Error: cannot open snapshot file\n";
+        return 1;
+    }
+    transport_catalogue::TransportCatalogue catalogue;
+    const auto snapshot = serialization::LoadSnapshot(in, catalogue);
+
+    const auto& tile_settings = input_data.GetRoot().AsMap().at("tile_settings");
+    map_renderer::TileSettings parsed_tile_settings;
+    try {
+        parsed_tile_settings = map_renderer::ParseTileSettings(tile_settings);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: invalid tile_settings: " << e.what() << "\n";
+        return 1;
+    }
+    const map_renderer::TileRenderer renderer(catalogue, snapshot.render_settings, parsed_tile_settings);
+    const auto stats = renderer.WriteTiles(tile_settings.AsMap().at("directory").AsString());
+    std::cout << "Tiles written: " << stats.written << ", unchanged: " << stats.unchanged
+              << ", removed: " << stats.removed << "\n";
+    return 0;
+}
 
-        // Если число открытых и закрытых скобок совпало, завершаем чтение
-        if (brace_count == 0) {
-            break;
+// Долгоживущий режим по снимку. Первая строка ввода - настройки: "serialization_settings"
+// и необязательные "server_settings": {"socket": "...", "threads": N}. Без сокета остальные
+// строки ввода - запросы, по одному JSON на строку; после них, если заданы "stats_settings",
+// выводится статистика запросов
+int Serve(std::istream& input) {
+    std::string config_line;
+    if (!std::getline(input, config_line)) {
+        PrintUsage();
+        return 1;
+    }
+    const json::Document config = json::LoadJSON(config_line);
+    query_server::ServerSettings settings;
+    settings.snapshot_file = GetSnapshotPath(config.GetRoot());
+    if (const auto& root = config.GetRoot().AsMap(); root.count("server_settings")) {
+        const auto& server_settings = root.at("server_settings").AsMap();
+        if (server_settings.count("socket")) {
+            settings.socket_path = server_settings.at("socket").AsString();
+        }
+        if (server_settings.count("threads")) {
+            settings.thread_count = static_cast<size_t>(server_settings.at("threads").AsInt());
         }
     }
 
-    return input_json;
+    query_server::QueryServer server(settings);
+    if (!settings.socket_path.empty()) {
+        server.ServeSocket();
+        return 0;
+    }
+    server.Serve(input, std::cout);
+    if (config.GetRoot().AsMap().count("stats_settings")) {
+        WriteRequestStats(config.GetRoot().AsMap().at("stats_settings"), server);
+    }
+    return 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc == 2) {
+        const std::string_view mode(argv[1]);
+        // Повреждённый или устаревший снимок - ошибка ввода, а не повод аварийно завершаться
+        try {
+            if (mode == "make_base"sv) {
+                return MakeBase(std::cin);
+            }
+            if (mode == "process_requests"sv) {
+                return ProcessRequests(std::cin);
+            }
+            if (mode == "render_tiles"sv) {
+                return RenderTiles(std::cin);
+            }
+            if (mode == "serve"sv) {
+                std::ios::sync_with_stdio(false);
+                return Serve(std::cin);
+            }
+        } catch (const binary_io::FormatError& e) {
+            std::cerr << "Error: invalid snapshot file: " << e.what() << "\n";
+            return 1;
+        }
+        PrintUsage();
+        return 1;
+    }
+    if (argc > 2) {
+        PrintUsage();
+        return 1;
+    }
+
     transport_catalogue::TransportCatalogue catalogue;
     json_reader::JsonReader json_reader(catalogue);
 
-    // Загружаем JSON-документ из стандартного ввода
-    std::string input_json = LoadDocumentFromStream(std::cin);
-    json::Document input_data = json::LoadJSON(input_json);
-
-    // Загрузка данных в каталог
-    json_reader.LoadData(input_data.GetRoot());
+    // Загружаем JSON-документ из стандартного ввода, данные base_requests сразу попадают в каталог
+    json_reader::StreamLoader loader(catalogue);
+    json::Parse(std::cin, loader);
+    json::Document input_data = loader.ExtractDocument();
 
     // Получаем настройки визуализации
     const auto& render_settings = input_data.GetRoot().AsMap().at("render_settings");
@@ -62,12 +212,28 @@ int main() {
         std::cerr << "Warning: 'routing_settings' key not found in JSON data. Using default settings.\n";
     }
 
+    // Правки базы применяются до ответов на запросы
+    if (input_data.GetRoot().AsMap().count("update_requests")) {
+        json_reader.ApplyUpdates(input_data.GetRoot().AsMap().at("update_requests"));
+    }
+
+    // С "stats_settings" запросы замеряются по типам, статистика выводится после ответов
+    request_stats::RequestStats stats;
+    if (input_data.GetRoot().AsMap().count("stats_settings")) {
+        json_reader.SetRequestStats(&stats);
+    }
+
     // Обработка запросов и формирование ответа
     const auto& stat_requests = input_data.GetRoot().AsMap().at("stat_requests").AsArray();
-    json::Node responses = json_reader.ProcessRequests(stat_requests, render_settings);
-
-    // Вывод ответа в формате JSON
-    Print(responses, std::cout, 4);
+    {
+        // Ответы пишутся в стандартный вывод по мере обработки, без промежуточного дерева JSON.
+        // Шесть значащих цифр у double - как у прежнего вывода через json::Print
+        json::Writer writer(std::cout, {true, 4, 6});
+        json_reader.ProcessRequests(stat_requests, render_settings, writer);
+    }
+    if (input_data.GetRoot().AsMap().count("stats_settings")) {
+        WriteRequestStats(input_data.GetRoot().AsMap().at("stats_settings"), json_reader);
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <iterator>
+#include <atomic>
+#include <thread>
 
 namespace map_renderer {
 
@@ -39,310 +41,247 @@ svg::Point SphereProjector::operator()(geo::Coordinates coords) const {
     return {x, y};
 }
 
-// Реализация MapRenderer
-MapRenderer::MapRenderer(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings)
-    : catalogue_(catalogue), settings_(settings) {}
-
-// Реализация MapRenderer
-void MapRenderer::Render(std::ostream& out) const {
-    svg::Document doc;
-
-    // Получаем все маршруты из каталога
-    const auto& all_buses = catalogue_.GetAllBuses();
-
-    // Если маршрутов нет, ничего не рисуем
-    if (all_buses.empty()) {
-        doc.Render(out); // Выводим пустой SVG-документ
-        return;
-    }
-
-    // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
-    for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
-        }
-    }
+StopProjection ProjectStops(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings) {
+    StopProjection projection;
 
     // Собираем координаты только тех остановок, которые принадлежат маршрутам
-    std::vector<geo::Coordinates> all_coordinates;
-    for (const auto& stop : catalogue_.GetAllStops()) {
-        if (stops_in_routes.find(stop.name) != stops_in_routes.end()) {
-            all_coordinates.push_back(stop.coordinates);
+    std::vector<geo::Coordinates> coordinates;
+    for (const auto* stop : catalogue.GetSortedAllStops()) {
+        const auto buses = catalogue.GetBusesByStop(stop);
+        if (buses.begin() != buses.end()) {
+            projection.stops.push_back(stop);
+            coordinates.push_back(stop->coordinates);
         }
     }
 
     // Создаем проектор для преобразования координат
-    SphereProjector projector(all_coordinates, settings_.width, settings_.height, settings_.padding);
-
-    // Отрисовываем ломаные линии маршрутов
-    DrawRoutes(doc, projector);
+    SphereProjector projector(coordinates, settings.width, settings.height, settings.padding);
 
-    // Отрисовываем названия маршрутов
-    DrawRouteLabels(doc, projector);
-
-    // Отрисовываем круги остановок
-    DrawStopCircles(doc, projector);
-
-    // Отрисовываем названия остановок
-    DrawStopLabels(doc, projector);
-
-    // Выводим SVG-документ
-    doc.Render(out);
+    projection.points.resize(catalogue.GetAllStops().size());
+    for (const auto* stop : projection.stops) {
+        projection.points[stop->id] = projector(stop->coordinates);
+    }
+    return projection;
 }
 
-// Отрисовка всех маршрутов
-void MapRenderer::DrawRoutes(svg::Document& doc, const SphereProjector& projector) const {
-    auto buses = catalogue_.GetAllBuses();
-    std::sort(buses.begin(), buses.end(), [](const auto& lhs, const auto& rhs) {
-        return lhs.name < rhs.name; // Сортировка по названию маршрута
-    });
-
-    size_t color_index = 0;
-    for (const auto& bus : buses) {
-        if (!bus.stops.empty()) {
-            DrawRoute(doc, bus, projector, GetRouteColor(color_index));
-            ++color_index;
-        } else {
-            // Если у маршрута нет остановок, следующий маршрут использует тот же индекс цвета
-            continue;
-        }
+Color GetRouteColor(const RenderSettings& settings, size_t index) {
+    if (settings.color_palette.empty()) {
+        return "black";
     }
+    return settings.color_palette[index % settings.color_palette.size()];
 }
 
-// Отрисовка одного маршрута
-void MapRenderer::DrawRoute(svg::Document& doc, const transport_catalogue::Bus& bus, const SphereProjector& projector, const Color& color) const {
-    svg::Polyline polyline;
-    for (const auto& stop : bus.stops) {
-        auto point = projector(stop->coordinates);
-        polyline.AddPoint(point);
-    }
-    if (!bus.is_round_trip) {
-        // Для некольцевых маршрутов добавляем точки в обратном порядке, кроме последней остановки
-        for (auto it = std::next(bus.stops.rbegin()); it != bus.stops.rend(); ++it) {
-            auto point = projector((*it)->coordinates);
-            polyline.AddPoint(point);
-        }
-    }
-    polyline.SetFillColor("none");
-    polyline.SetStrokeColor(ConvertColor(color));
-    polyline.SetStrokeWidth(settings_.line_width);
-    polyline.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-    polyline.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-    doc.Add(polyline);
+MapStyles::MapStyles(const RenderSettings& settings) {
+    route_line.SetFillColor("none");
+    route_line.SetStrokeWidth(settings.line_width);
+    route_line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+    route_line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+    // Подложка названия маршрута
+    bus_label_underlayer.SetOffset({settings.bus_label_offset[0], settings.bus_label_offset[1]});
+    bus_label_underlayer.SetFontSize(settings.bus_label_font_size);
+    bus_label_underlayer.SetFontFamily("Verdana");
+    bus_label_underlayer.SetFontWeight("bold");
+    bus_label_underlayer.SetFillColor(ConvertColor(settings.underlayer_color));
+    bus_label_underlayer.SetStrokeColor(ConvertColor(settings.underlayer_color));
+    bus_label_underlayer.SetStrokeWidth(settings.underlayer_width);
+    bus_label_underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+    bus_label_underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+    // Название маршрута
+    bus_label.SetOffset({settings.bus_label_offset[0], settings.bus_label_offset[1]});
+    bus_label.SetFontSize(settings.bus_label_font_size);
+    bus_label.SetFontFamily("Verdana");
+    bus_label.SetFontWeight("bold");
+
+    stop_circle.SetRadius(settings.stop_radius);
+    stop_circle.SetFillColor("white");
+
+    // Подложка названия остановки
+    stop_label_underlayer.SetOffset({settings.stop_label_offset[0], settings.stop_label_offset[1]});
+    stop_label_underlayer.SetFontSize(settings.stop_label_font_size);
+    stop_label_underlayer.SetFontFamily("Verdana");
+    stop_label_underlayer.SetFillColor(ConvertColor(settings.underlayer_color));
+    stop_label_underlayer.SetStrokeColor(ConvertColor(settings.underlayer_color));
+    stop_label_underlayer.SetStrokeWidth(settings.underlayer_width);
+    stop_label_underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
+    stop_label_underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+
+    // Название остановки
+    stop_label.SetOffset({settings.stop_label_offset[0], settings.stop_label_offset[1]});
+    stop_label.SetFontSize(settings.stop_label_font_size);
+    stop_label.SetFontFamily("Verdana");
+    stop_label.SetFillColor("black");
 }
 
-Color MapRenderer::GetRouteColor(size_t index) const {
-    if (settings_.color_palette.empty()) {
-        return "black";
+// Реализация MapRenderer
+MapRenderer::MapRenderer(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings)
+    : catalogue_(catalogue), settings_(settings), styles_(settings) {}
+
+void MapRenderer::Render(std::ostream& out) const {
+    out << svg::DOCUMENT_PROLOG;
+    for (const std::string& layer : RenderLayers()) {
+        out.write(layer.data(), static_cast<std::streamsize>(layer.size()));
     }
-    return settings_.color_palette[index % settings_.color_palette.size()];
+    out << svg::DOCUMENT_EPILOG;
 }
 
-// Отрисовка всех остановок
-void MapRenderer::DrawStops(svg::Document& doc, const SphereProjector& projector) const {
-    if (!settings_.render_stops) {
-        return; // Если остановки не нужно рисовать, выходим из метода
+std::string MapRenderer::Render() const {
+    const auto layers = RenderLayers();
+    size_t size = svg::DOCUMENT_PROLOG.size() + svg::DOCUMENT_EPILOG.size();
+    for (const std::string& layer : layers) {
+        size += layer.size();
     }
 
-    // Получаем все остановки из каталога
-    const auto& all_stops = catalogue_.GetAllStops();
+    std::string result;
+    result.reserve(size);
+    result += svg::DOCUMENT_PROLOG;
+    for (const std::string& layer : layers) {
+        result += layer;
+    }
+    result += svg::DOCUMENT_EPILOG;
+    return result;
+}
 
-    // Получаем все маршруты из каталога
-    const auto& all_buses = catalogue_.GetAllBuses();
+std::array<std::string, MapRenderer::LAYER_COUNT> MapRenderer::RenderLayers() const {
+    std::array<std::string, LAYER_COUNT> layers;
 
-    // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
-    for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
-        }
+    // Если маршрутов нет, ничего не рисуем
+    if (catalogue_.GetAllBuses().empty()) {
+        return layers;
     }
 
-    for (const auto& stop : all_stops) {
-        // Проверяем, существует ли остановка и принадлежит ли она хотя бы одному маршруту
-        if (stops_in_routes.find(stop.name) == stops_in_routes.end()) {
-            continue; // Если остановка не принадлежит ни одному маршруту, пропускаем её
+    // Отсортированные индексы строятся здесь, а не одновременно в нескольких потоках
+    const StopProjection projection = ProjectStops(catalogue_, settings_);
+
+    // Каждый поток берёт очередной слой и пишет только в свою строку
+    const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), LAYER_COUNT);
+    std::atomic<size_t> next_layer = 0;
+    const auto worker = [&] {
+        for (size_t layer = next_layer++; layer < LAYER_COUNT; layer = next_layer++) {
+            DrawLayer(layer, projection, layers[layer]);
         }
+    };
 
-        auto point = projector(stop.coordinates);
-        svg::Circle circle;
-        circle.SetCenter(point);
-        circle.SetRadius(settings_.stop_radius);
-        circle.SetFillColor("white");
-        doc.Add(circle);
-
-        // Добавляем текстовую метку для остановки
-        svg::Text label;
-        label.SetPosition(point);
-
-        // Преобразуем std::array<double, 2> в svg::Point
-        svg::Point offset{settings_.stop_label_offset[0], settings_.stop_label_offset[1]};
-        label.SetOffset(offset);
-
-        label.SetFontSize(settings_.stop_label_font_size);
-        label.SetFontFamily("Verdana");
-        label.SetData(stop.name);
-        label.SetFillColor("black");
-        doc.Add(label);
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
     }
-}
 
-// Отрисовка одной остановки
-void MapRenderer::DrawStop(svg::Document& doc, const transport_catalogue::Stop& stop, const SphereProjector& projector) const {
-    auto point = projector(stop.coordinates);
-    svg::Circle circle;
-    circle.SetCenter(point);
-    circle.SetRadius(settings_.stop_radius);
-    circle.SetFillColor("white");
-    doc.Add(circle);
+    return layers;
 }
 
-void MapRenderer::DrawStopCircles(svg::Document& doc, const SphereProjector& projector) const {
-    // Получаем все маршруты из каталога
-    const auto& all_buses = catalogue_.GetAllBuses();
-
-    // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
-    for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
-        }
+void MapRenderer::DrawLayer(size_t layer, const StopProjection& projection, std::string& buffer) const {
+    svg::BufferWriter out(buffer);
+    switch (layer) {
+        case 0:
+            // Отрисовываем ломаные линии маршрутов
+            DrawRoutes(out, projection);
+            break;
+        case 1:
+            // Отрисовываем названия маршрутов
+            DrawRouteLabels(out, projection);
+            break;
+        case 2:
+            // Отрисовываем круги остановок
+            DrawStopCircles(out, projection);
+            break;
+        case 3:
+            // Отрисовываем названия остановок
+            DrawStopLabels(out, projection);
+            break;
     }
+}
 
-    // Получаем все остановки из каталога
-    auto stops = catalogue_.GetAllStops();
-    std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
-        return lhs.name < rhs.name; // Сортировка по названию остановки
-    });
+// Отрисовка всех маршрутов
+void MapRenderer::DrawRoutes(svg::BufferWriter& out, const StopProjection& projection) const {
+    // Одна ломаная на все маршруты: память под точки выделяется один раз
+    svg::Polyline polyline = styles_.route_line;
 
-    for (const auto& stop : stops) {
-        // Проверяем, принадлежит ли остановка хотя бы одному маршруту
-        if (stops_in_routes.find(stop.name) == stops_in_routes.end()) {
-            continue; // Если остановка не принадлежит ни одному маршруту, пропускаем её
+    size_t color_index = 0;
+    for (const auto* bus : catalogue_.GetSortedAllBuses()) { // Маршруты отсортированы по названию
+        if (bus->stops.empty()) {
+            // Если у маршрута нет остановок, следующий маршрут использует тот же индекс цвета
+            continue;
         }
 
-        auto point = projector(stop.coordinates);
-        svg::Circle circle;
-        circle.SetCenter(point);
-        circle.SetRadius(settings_.stop_radius);
-        circle.SetFillColor("white");
-        doc.Add(circle);
+        polyline.ClearPoints();
+        ForEachRouteStop(*bus, [&](const transport_catalogue::Stop* stop) {
+            polyline.AddPoint(projection.points[stop->id]);
+        });
+        polyline.SetStrokeColor(ConvertColor(GetRouteColor(settings_, color_index)));
+        polyline.Render(out);
+        ++color_index;
     }
 }
 
-void MapRenderer::DrawStopLabels(svg::Document& doc, const SphereProjector& projector) const {
-    // Получаем все маршруты из каталога
-    const auto& all_buses = catalogue_.GetAllBuses();
+void MapRenderer::DrawStopCircles(svg::BufferWriter& out, const StopProjection& projection) const {
+    svg::Circle circle = styles_.stop_circle;
 
-    // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
-    for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
-        }
+    // Остановки на маршрутах, отсортированные по названию
+    for (const auto* stop : projection.stops) {
+        circle.SetCenter(projection.points[stop->id]);
+        circle.Render(out);
     }
+}
 
-    // Получаем все остановки из каталога
-    auto stops = catalogue_.GetAllStops();
-    std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
-        return lhs.name < rhs.name; // Сортировка по названию остановки
-    });
-
-    for (const auto& stop : stops) {
-        // Проверяем, принадлежит ли остановка хотя бы одному маршруту
-        if (stops_in_routes.find(stop.name) == stops_in_routes.end()) {
-            continue; // Если остановка не принадлежит ни одному маршруту, пропускаем её
-        }
+void MapRenderer::DrawStopLabels(svg::BufferWriter& out, const StopProjection& projection) const {
+    svg::Text underlayer = styles_.stop_label_underlayer;
+    svg::Text label = styles_.stop_label;
 
-        auto point = projector(stop.coordinates);
-
-        // Подложка
-        svg::Text underlayer;
-        underlayer.SetPosition(point);
-        underlayer.SetOffset({settings_.stop_label_offset[0], settings_.stop_label_offset[1]});
-        underlayer.SetFontSize(settings_.stop_label_font_size);
-        underlayer.SetFontFamily("Verdana");
-        underlayer.SetData(stop.name);
-        underlayer.SetFillColor(ConvertColor(settings_.underlayer_color));
-        underlayer.SetStrokeColor(ConvertColor(settings_.underlayer_color));
-        underlayer.SetStrokeWidth(settings_.underlayer_width);
-        underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-        doc.Add(underlayer);
-
-        // Надпись
-        svg::Text label;
-        label.SetPosition(point);
-        label.SetOffset({settings_.stop_label_offset[0], settings_.stop_label_offset[1]});
-        label.SetFontSize(settings_.stop_label_font_size);
-        label.SetFontFamily("Verdana");
-        label.SetData(stop.name);
-        label.SetFillColor("black");
-        doc.Add(label);
+    // Остановки на маршрутах, отсортированные по названию
+    for (const auto* stop : projection.stops) {
+        const svg::Point point = projection.points[stop->id];
+        underlayer.SetPosition(point).SetData(stop->name).Render(out);
+        label.SetPosition(point).SetData(stop->name).Render(out);
     }
 }
 
-void MapRenderer::DrawRouteLabel(svg::Document& doc, const SphereProjector& projector, geo::Coordinates coords, const std::string& name, const Color& color) const {
-    auto point = projector(coords);
-
-    // Подложка
-    svg::Text underlayer;
-    underlayer.SetPosition(point);
-    underlayer.SetOffset({settings_.bus_label_offset[0], settings_.bus_label_offset[1]});
-    underlayer.SetFontSize(settings_.bus_label_font_size);
-    underlayer.SetFontFamily("Verdana");
-    underlayer.SetFontWeight("bold");
-    underlayer.SetData(name);
-    underlayer.SetFillColor(ConvertColor(settings_.underlayer_color));
-    underlayer.SetStrokeColor(ConvertColor(settings_.underlayer_color));
-    underlayer.SetStrokeWidth(settings_.underlayer_width);
-    underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-    underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-    doc.Add(underlayer);
-
-    // Надпись
-    svg::Text label;
-    label.SetPosition(point);
-    label.SetOffset({settings_.bus_label_offset[0], settings_.bus_label_offset[1]});
-    label.SetFontSize(settings_.bus_label_font_size);
-    label.SetFontFamily("Verdana");
-    label.SetFontWeight("bold");
-    label.SetData(name);
-    label.SetFillColor(ConvertColor(color));
-    doc.Add(label);
-}
+void MapRenderer::DrawRouteLabels(svg::BufferWriter& out, const StopProjection& projection) const {
+    svg::Text underlayer = styles_.bus_label_underlayer;
+    svg::Text label = styles_.bus_label;
 
-void MapRenderer::DrawRouteLabels(svg::Document& doc, const SphereProjector& projector) const {
-    auto buses = catalogue_.GetAllBuses();
-    std::sort(buses.begin(), buses.end(), [](const auto& lhs, const auto& rhs) {
-        return lhs.name < rhs.name; // Сортировка по названию маршрута
-    });
+    const auto draw_label = [&](const transport_catalogue::Stop* stop) {
+        const svg::Point point = projection.points[stop->id];
+        underlayer.SetPosition(point).Render(out);
+        label.SetPosition(point).Render(out);
+    };
 
-    for (const auto& bus : buses) {
+    const auto& buses = catalogue_.GetSortedAllBuses(); // Маршруты отсортированы по названию
+    for (size_t bus_index = 0; bus_index < buses.size(); ++bus_index) {
+        const auto& bus = *buses[bus_index];
         if (bus.stops.empty()) {
             continue; // Если у маршрута нет остановок, пропускаем
         }
 
-        // Получаем цвет маршрута
-        auto color = GetRouteColor(std::distance(buses.begin(), std::find(buses.begin(), buses.end(), bus)));
-
-        // Если маршрут некольцевой и первая и последняя остановки совпадают, выводим имя только один раз
-        if (!bus.is_round_trip && bus.stops.front()->name == bus.stops.back()->name) {
-            DrawRouteLabel(doc, projector, bus.stops.front()->coordinates, bus.name, color);
-            } 
-        else {
-            // Отрисовываем название маршрута у первой конечной остановки
-            DrawRouteLabel(doc, projector, bus.stops.front()->coordinates, bus.name, color);
-
-            // Если маршрут некольцевой, отрисовываем название у второй конечной остановки
-            if (!bus.is_round_trip) {
-                DrawRouteLabel(doc, projector, bus.stops.back()->coordinates, bus.name, color);
-            }
+        // Цвет надписи определяется позицией маршрута в отсортированном списке
+        underlayer.SetData(bus.name);
+        label.SetData(bus.name);
+        label.SetFillColor(ConvertColor(GetRouteColor(settings_, bus_index)));
+
+        // Название выводится у первой конечной остановки, а у некольцевого маршрута -
+        // ещё и у второй, если она отличается от первой
+        draw_label(bus.stops.front());
+        if (!bus.is_round_trip && bus.stops.front() != bus.stops.back()) {
+            draw_label(bus.stops.back());
         }
     }
 }
 
+bool operator==(const RenderSettings& lhs, const RenderSettings& rhs) {
+    return lhs.width == rhs.width && lhs.height == rhs.height && lhs.padding == rhs.padding
+        && lhs.line_width == rhs.line_width && lhs.stop_radius == rhs.stop_radius
+        && lhs.bus_label_font_size == rhs.bus_label_font_size && lhs.bus_label_offset == rhs.bus_label_offset
+        && lhs.stop_label_font_size == rhs.stop_label_font_size && lhs.stop_label_offset == rhs.stop_label_offset
+        && lhs.underlayer_color == rhs.underlayer_color && lhs.underlayer_width == rhs.underlayer_width
+        && lhs.color_palette == rhs.color_palette && lhs.render_stops == rhs.render_stops;
+}
+
 // Парсинг настроек визуализации из JSON
     RenderSettings ParseRenderSettings(const json::Node& render_settings_node) {
     RenderSettings settings;
@@ -13,7 +13,6 @@
 #include <algorithm>
 #include "svg.h"
 #include "geo.h"
-#include "json_reader.h"
 #include "json.h"
 #include "transport_catalogue.h"
 
@@ -45,6 +44,8 @@ struct RenderSettings {
     bool render_stops; // Флаг для отрисовки остановок
 };
 
+bool operator==(const RenderSettings& lhs, const RenderSettings& rhs);
+
 // Класс для проекции географических координат на плоскость
 class SphereProjector {
 public:
@@ -61,27 +62,69 @@ private:
     double zoom_coef_;
 };
 
-// Основной класс для отрисовки карты
+// Остановки на маршрутах в порядке названий и их точки на карте по id остановки
+struct StopProjection {
+    std::vector<const transport_catalogue::Stop*> stops;
+    std::vector<svg::Point> points;
+};
+
+// Проецирует остановки, через которые проходит хотя бы один маршрут, на плоскость карты
+StopProjection ProjectStops(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings);
+
+// Цвет маршрута с номером index из палитры
+Color GetRouteColor(const RenderSettings& settings, size_t index);
+
+// Заготовки элементов карты с оформлением из настроек. При отрисовке
+// у копии заготовки меняются только координаты, текст и цвет маршрута
+struct MapStyles {
+    explicit MapStyles(const RenderSettings& settings);
+
+    svg::Polyline route_line;
+    svg::Text bus_label_underlayer;
+    svg::Text bus_label;
+    svg::Circle stop_circle;
+    svg::Text stop_label_underlayer;
+    svg::Text stop_label;
+};
+
+// Вызывает action для остановок ломаной маршрута: у некольцевого маршрута
+// после конечной следуют остановки в обратном порядке
+template <typename Action>
+void ForEachRouteStop(const transport_catalogue::Bus& bus, Action action) {
+    for (const auto* stop : bus.stops) {
+        action(stop);
+    }
+    if (!bus.is_round_trip && !bus.stops.empty()) {
+        for (auto it = std::next(bus.stops.rbegin()); it != bus.stops.rend(); ++it) {
+            action(*it);
+        }
+    }
+}
+
+// Основной класс для отрисовки карты. Координаты остановок проецируются один раз,
+// слои карты (линии маршрутов, их названия, круги и названия остановок) пишутся
+// в отдельные строки параллельно и затем выводятся друг за другом
 class MapRenderer {
 public:
+    static constexpr size_t LAYER_COUNT = 4;
+
     MapRenderer(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings);
 
     void Render(std::ostream& out) const;
+    std::string Render() const;
 
 private:
     const transport_catalogue::TransportCatalogue& catalogue_;
     RenderSettings settings_;
+    MapStyles styles_;
 
-    void DrawRoutes(svg::Document& doc, const SphereProjector& projector) const;
-    void DrawRoute(svg::Document& doc, const transport_catalogue::Bus& bus, const SphereProjector& projector, const Color& color) const;
-    void DrawStops(svg::Document& doc, const SphereProjector& projector) const;
-    void DrawStop(svg::Document& doc, const transport_catalogue::Stop& stop, const SphereProjector& projector) const;
-    void DrawStopCircles(svg::Document& doc, const SphereProjector& projector) const;
-    void DrawStopLabels(svg::Document& doc, const SphereProjector& projector) const;
-    void DrawRouteLabels(svg::Document& doc, const SphereProjector& projector) const;
-    void DrawRouteLabel(svg::Document& doc, const SphereProjector& projector, geo::Coordinates coords, const std::string& name, const Color& color) const;
+    std::array<std::string, LAYER_COUNT> RenderLayers() const;
+    void DrawLayer(size_t layer, const StopProjection& projection, std::string& buffer) const;
 
-    Color GetRouteColor(size_t index) const;
+    void DrawRoutes(svg::BufferWriter& out, const StopProjection& projection) const;
+    void DrawRouteLabels(svg::BufferWriter& out, const StopProjection& projection) const;
+    void DrawStopCircles(svg::BufferWriter& out, const StopProjection& projection) const;
+    void DrawStopLabels(svg::BufferWriter& out, const StopProjection& projection) const;
 };
 
 // Функция для парсинга настроек визуализации из JSON
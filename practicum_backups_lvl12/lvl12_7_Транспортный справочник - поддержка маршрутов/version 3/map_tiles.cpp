@@ -0,0 +1,340 @@
+#include "map_tiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+namespace map_renderer {
+
+namespace {
+
+int ParseZoom(const json::Dict& settings_map, const std::string& key, int default_zoom) {
+    if (!settings_map.count(key)) {
+        return default_zoom;
+    }
+    const int zoom = settings_map.at(key).AsInt();
+    if (zoom < 0 || zoom > MAX_TILE_ZOOM) {
+        throw std::invalid_argument(key + " must be in 0.." + std::to_string(MAX_TILE_ZOOM));
+    }
+    return zoom;
+}
+
+bool SamePoint(svg::Point lhs, svg::Point rhs) {
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+// Отсекает отрезок квадратом [min, max] x [min, max] (алгоритм Лианга-Барски).
+// Концы, лежащие внутри, возвращаются без пересчёта, чтобы соседние отрезки ломаной стыковались точно
+std::optional<std::pair<svg::Point, svg::Point>> ClipSegment(svg::Point from, svg::Point to, double min, double max) {
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    const double directions[4] = {-dx, dx, -dy, dy};
+    const double distances[4] = {from.x - min, max - from.x, from.y - min, max - from.y};
+
+    double t_from = 0.0;
+    double t_to = 1.0;
+    for (int i = 0; i < 4; ++i) {
+        if (directions[i] == 0.0) {
+            // Отрезок параллелен границе: либо целиком снаружи, либо граница его не режет
+            if (distances[i] < 0.0) {
+                return std::nullopt;
+            }
+            continue;
+        }
+        const double t = distances[i] / directions[i];
+        if (directions[i] < 0.0) {
+            if (t > t_to) {
+                return std::nullopt;
+            }
+            t_from = std::max(t_from, t);
+        } else {
+            if (t < t_from) {
+                return std::nullopt;
+            }
+            t_to = std::min(t_to, t);
+        }
+    }
+
+    const svg::Point clipped_from = t_from == 0.0 ? from : svg::Point{from.x + t_from * dx, from.y + t_from * dy};
+    const svg::Point clipped_to = t_to == 1.0 ? to : svg::Point{from.x + t_to * dx, from.y + t_to * dy};
+    return std::pair{clipped_from, clipped_to};
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+}  // namespace
+
+TileRenderer::TileRenderer(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings,
+                           const TileSettings& tile_settings)
+    : catalogue_(catalogue)
+    , settings_(settings)
+    , tile_settings_(tile_settings)
+    , styles_(settings)
+    , projection_(ProjectStops(catalogue, settings))
+    , world_size_(std::max(settings.width, settings.height)) {
+}
+
+std::string TileRenderer::RenderTile(TileId tile) const {
+    if (tile.zoom < 0 || tile.zoom > MAX_TILE_ZOOM) {
+        throw std::out_of_range("Tile zoom is out of range");
+    }
+    const int tiles_per_side = 1 << tile.zoom;
+    if (tile.x < 0 || tile.x >= tiles_per_side || tile.y < 0 || tile.y >= tiles_per_side) {
+        throw std::out_of_range("Tile is outside of the map");
+    }
+
+    const Tiles tiles = RenderTiles({tile.zoom, tile.x, tile.x, tile.y, tile.y});
+    const auto it = tiles.find({tile.x, tile.y});
+    return MakeDocument(it != tiles.end() ? it->second : TileLayers{});
+}
+
+TileWriteStats TileRenderer::WriteTiles(const std::filesystem::path& directory) const {
+    TileWriteStats stats;
+    for (int zoom = 0; zoom <= tile_settings_.max_zoom; ++zoom) {
+        const int tiles_per_side = 1 << zoom;
+        const Tiles tiles = RenderTiles({zoom, 0, tiles_per_side - 1, 0, tiles_per_side - 1});
+        const std::filesystem::path zoom_directory = directory / std::to_string(zoom);
+
+        std::set<std::filesystem::path> tile_paths;
+        for (const auto& [position, layers] : tiles) {
+            const auto path = zoom_directory / std::to_string(position.first) / (std::to_string(position.second) + ".svg");
+            tile_paths.insert(path);
+
+            const std::string document = MakeDocument(layers);
+            std::error_code error;
+            if (std::filesystem::file_size(path, error) == document.size() && !error && ReadFile(path) == document) {
+                ++stats.unchanged;
+                continue;
+            }
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(document.data(), static_cast<std::streamsize>(document.size()));
+            if (!out) {
+                throw std::runtime_error("Cannot write tile " + path.string());
+            }
+            ++stats.written;
+        }
+
+        // Тайлы уровня, на которых после изменения справочника ничего не осталось
+        if (!std::filesystem::exists(zoom_directory)) {
+            continue;
+        }
+        std::vector<std::filesystem::path> stale_paths;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(zoom_directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".svg" && !tile_paths.count(entry.path())) {
+                stale_paths.push_back(entry.path());
+            }
+        }
+        for (const auto& path : stale_paths) {
+            std::filesystem::remove(path);
+            ++stats.removed;
+        }
+    }
+    return stats;
+}
+
+TileRenderer::Tiles TileRenderer::RenderTiles(const TileRange& range) const {
+    Tiles tiles;
+    if (catalogue_.GetAllBuses().empty()) {
+        return tiles;
+    }
+
+    // Слои в том же порядке, что и у MapRenderer; уровень детализации зависит от масштаба
+    DrawRoutes(tiles, range);
+    if (range.zoom >= tile_settings_.bus_labels_min_zoom) {
+        DrawRouteLabels(tiles, range);
+    }
+    if (range.zoom >= tile_settings_.stop_circles_min_zoom) {
+        DrawStopCircles(tiles, range);
+    }
+    if (range.zoom >= tile_settings_.stop_labels_min_zoom) {
+        DrawStopLabels(tiles, range);
+    }
+    return tiles;
+}
+
+template <typename Action>
+void TileRenderer::ForEachTileNear(svg::Point point, double margin, const TileRange& range, Action action) const {
+    const double tile_world_size = world_size_ / (1 << range.zoom);
+    const double scale = tile_settings_.tile_size / tile_world_size;
+    const double world_margin = margin / scale;
+
+    const int x_from = std::max(range.x_from, static_cast<int>(std::floor((point.x - world_margin) / tile_world_size)));
+    const int x_to = std::min(range.x_to, static_cast<int>(std::floor((point.x + world_margin) / tile_world_size)));
+    const int y_from = std::max(range.y_from, static_cast<int>(std::floor((point.y - world_margin) / tile_world_size)));
+    const int y_to = std::min(range.y_to, static_cast<int>(std::floor((point.y + world_margin) / tile_world_size)));
+    for (int x = x_from; x <= x_to; ++x) {
+        for (int y = y_from; y <= y_to; ++y) {
+            action(x, y, svg::Point{(point.x - x * tile_world_size) * scale, (point.y - y * tile_world_size) * scale});
+        }
+    }
+}
+
+void TileRenderer::DrawRoutes(Tiles& tiles, const TileRange& range) const {
+    const double tile_world_size = world_size_ / (1 << range.zoom);
+    const double scale = tile_settings_.tile_size / tile_world_size;
+    // Линия не должна обрываться у края тайла, поэтому ломаная режется с запасом на её толщину
+    const double margin = settings_.line_width;
+    const double world_margin = margin / scale;
+
+    svg::Polyline polyline = styles_.route_line;
+    std::vector<svg::Point> route_points;
+    // Куски ломаной текущего маршрута по тайлам
+    std::map<std::pair<int, int>, std::vector<std::vector<svg::Point>>> pieces;
+
+    const auto add_segment = [&](svg::Point from, svg::Point to) {
+        const int x_from = std::max(range.x_from, static_cast<int>(std::floor((std::min(from.x, to.x) - world_margin) / tile_world_size)));
+        const int x_to = std::min(range.x_to, static_cast<int>(std::floor((std::max(from.x, to.x) + world_margin) / tile_world_size)));
+        const int y_from = std::max(range.y_from, static_cast<int>(std::floor((std::min(from.y, to.y) - world_margin) / tile_world_size)));
+        const int y_to = std::min(range.y_to, static_cast<int>(std::floor((std::max(from.y, to.y) + world_margin) / tile_world_size)));
+        for (int x = x_from; x <= x_to; ++x) {
+            for (int y = y_from; y <= y_to; ++y) {
+                const svg::Point origin{x * tile_world_size, y * tile_world_size};
+                const auto clipped = ClipSegment({(from.x - origin.x) * scale, (from.y - origin.y) * scale},
+                                                 {(to.x - origin.x) * scale, (to.y - origin.y) * scale},
+                                                 -margin, tile_settings_.tile_size + margin);
+                if (!clipped) {
+                    continue;
+                }
+                // Отрезок продолжает последний кусок в этом тайле или начинает новый
+                auto& tile_pieces = pieces[{x, y}];
+                if (tile_pieces.empty() || !SamePoint(tile_pieces.back().back(), clipped->first)) {
+                    tile_pieces.push_back({clipped->first});
+                }
+                tile_pieces.back().push_back(clipped->second);
+            }
+        }
+    };
+
+    size_t color_index = 0;
+    for (const auto* bus : catalogue_.GetSortedAllBuses()) { // Маршруты отсортированы по названию
+        if (bus->stops.empty()) {
+            // Если у маршрута нет остановок, следующий маршрут использует тот же индекс цвета
+            continue;
+        }
+
+        route_points.clear();
+        ForEachRouteStop(*bus, [&](const transport_catalogue::Stop* stop) {
+            route_points.push_back(projection_.points[stop->id]);
+        });
+        pieces.clear();
+        if (route_points.size() == 1) {
+            add_segment(route_points.front(), route_points.front());
+        }
+        for (size_t i = 1; i < route_points.size(); ++i) {
+            add_segment(route_points[i - 1], route_points[i]);
+        }
+
+        polyline.SetStrokeColor(ConvertColor(GetRouteColor(settings_, color_index)));
+        for (const auto& [position, tile_pieces] : pieces) {
+            svg::BufferWriter out(tiles[position][0]);
+            for (const auto& piece : tile_pieces) {
+                polyline.ClearPoints();
+                for (const svg::Point point : piece) {
+                    polyline.AddPoint(point);
+                }
+                polyline.Render(out);
+            }
+        }
+        ++color_index;
+    }
+}
+
+void TileRenderer::DrawRouteLabels(Tiles& tiles, const TileRange& range) const {
+    svg::Text underlayer = styles_.bus_label_underlayer;
+    svg::Text label = styles_.bus_label;
+
+    const auto draw_label = [&](const transport_catalogue::Stop* stop) {
+        ForEachTileNear(projection_.points[stop->id], tile_settings_.label_margin, range,
+            [&](int x, int y, svg::Point point) {
+                svg::BufferWriter out(tiles[{x, y}][1]);
+                underlayer.SetPosition(point).Render(out);
+                label.SetPosition(point).Render(out);
+            });
+    };
+
+    const auto& buses = catalogue_.GetSortedAllBuses(); // Маршруты отсортированы по названию
+    for (size_t bus_index = 0; bus_index < buses.size(); ++bus_index) {
+        const auto& bus = *buses[bus_index];
+        if (bus.stops.empty()) {
+            continue;
+        }
+
+        // Цвет надписи определяется позицией маршрута в отсортированном списке, как у MapRenderer
+        underlayer.SetData(bus.name);
+        label.SetData(bus.name);
+        label.SetFillColor(ConvertColor(GetRouteColor(settings_, bus_index)));
+
+        draw_label(bus.stops.front());
+        if (!bus.is_round_trip && bus.stops.front() != bus.stops.back()) {
+            draw_label(bus.stops.back());
+        }
+    }
+}
+
+void TileRenderer::DrawStopCircles(Tiles& tiles, const TileRange& range) const {
+    svg::Circle circle = styles_.stop_circle;
+    for (const auto* stop : projection_.stops) {
+        ForEachTileNear(projection_.points[stop->id], settings_.stop_radius, range,
+            [&](int x, int y, svg::Point point) {
+                svg::BufferWriter out(tiles[{x, y}][2]);
+                circle.SetCenter(point).Render(out);
+            });
+    }
+}
+
+void TileRenderer::DrawStopLabels(Tiles& tiles, const TileRange& range) const {
+    svg::Text underlayer = styles_.stop_label_underlayer;
+    svg::Text label = styles_.stop_label;
+    for (const auto* stop : projection_.stops) {
+        underlayer.SetData(stop->name);
+        label.SetData(stop->name);
+        ForEachTileNear(projection_.points[stop->id], tile_settings_.label_margin, range,
+            [&](int x, int y, svg::Point point) {
+                svg::BufferWriter out(tiles[{x, y}][3]);
+                underlayer.SetPosition(point).Render(out);
+                label.SetPosition(point).Render(out);
+            });
+    }
+}
+
+std::string TileRenderer::MakeDocument(const TileLayers& layers) {
+    std::string document(svg::DOCUMENT_PROLOG);
+    for (const std::string& layer : layers) {
+        document += layer;
+    }
+    document += svg::DOCUMENT_EPILOG;
+    return document;
+}
+
+TileSettings ParseTileSettings(const json::Node& tile_settings_node) {
+    TileSettings settings;
+    const auto& settings_map = tile_settings_node.AsMap();
+    if (settings_map.count("tile_size")) {
+        settings.tile_size = settings_map.at("tile_size").AsDouble();
+        // Отрицательный или нулевой размер даёт вырожденный масштаб, NaN не проходит сравнение
+        if (!(settings.tile_size > 0) || !std::isfinite(settings.tile_size)) {
+            throw std::invalid_argument("tile_size must be positive");
+        }
+    }
+    // WriteTiles обходит уровни до max_zoom, вычисляя 1 << zoom, поэтому уровни проверяются
+    // здесь по тому же пределу, что и в RenderTile
+    settings.max_zoom = ParseZoom(settings_map, "max_zoom", settings.max_zoom);
+    settings.bus_labels_min_zoom = ParseZoom(settings_map, "bus_labels_min_zoom", settings.bus_labels_min_zoom);
+    settings.stop_circles_min_zoom = ParseZoom(settings_map, "stop_circles_min_zoom", settings.stop_circles_min_zoom);
+    settings.stop_labels_min_zoom = ParseZoom(settings_map, "stop_labels_min_zoom", settings.stop_labels_min_zoom);
+    if (settings_map.count("label_margin")) {
+        settings.label_margin = settings_map.at("label_margin").AsDouble();
+    }
+    return settings;
+}
+
+}  // namespace map_renderer
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "json.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+#include <array>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace map_renderer {
+
+// Настройки нарезки карты на тайлы. Размеры - в пикселях тайла
+struct TileSettings {
+    double tile_size = 256;
+    int max_zoom = 4;                 // WriteTiles пишет уровни 0..max_zoom
+    int bus_labels_min_zoom = 1;      // Названия маршрутов - начиная с этого уровня
+    int stop_circles_min_zoom = 0;    // Круги остановок - начиная с этого уровня
+    int stop_labels_min_zoom = 3;     // Названия остановок - начиная с этого уровня
+    double label_margin = 128;        // Надпись попадает во все тайлы ближе этого расстояния
+};
+
+// Наибольший уровень: номер тайла 2^z - 1 должен помещаться в int
+inline constexpr int MAX_TILE_ZOOM = 30;
+
+// Тайл z/x/y: на уровне z плоскость карты делится на 2^z x 2^z квадратов
+struct TileId {
+    int zoom = 0;
+    int x = 0;
+    int y = 0;
+};
+
+struct TileWriteStats {
+    size_t written = 0;    // Новые и изменившиеся тайлы
+    size_t unchanged = 0;  // Файл уже содержит тот же SVG
+    size_t removed = 0;    // Тайлы, на которых больше ничего нет
+};
+
+// Нарезает карту MapRenderer на тайлы. Квадрат со стороной max(width, height) на плоскости
+// SphereProjector делится на тайлы; ломаные маршрутов обрезаются по границам тайла
+// (с запасом на толщину линии), а надписи отбрасываются на мелких уровнях.
+// Толщина линий и размер шрифта в пикселях одинаковы на всех уровнях
+class TileRenderer {
+public:
+    TileRenderer(const transport_catalogue::TransportCatalogue& catalogue, const RenderSettings& settings,
+                 const TileSettings& tile_settings);
+
+    // Бросает std::out_of_range для тайла вне сетки своего уровня
+    std::string RenderTile(TileId tile) const;
+
+    // Пишет непустые тайлы уровней 0..max_zoom в directory/z/x/y.svg. Файлы с тем же
+    // содержимым не перезаписываются, а тайлы, ставшие пустыми, удаляются
+    TileWriteStats WriteTiles(const std::filesystem::path& directory) const;
+
+private:
+    using TileLayers = std::array<std::string, MapRenderer::LAYER_COUNT>;
+    using Tiles = std::map<std::pair<int, int>, TileLayers>;
+
+    // Прямоугольник номеров тайлов, в которых нужно рисовать
+    struct TileRange {
+        int zoom;
+        int x_from;
+        int x_to;
+        int y_from;
+        int y_to;
+    };
+
+    const transport_catalogue::TransportCatalogue& catalogue_;
+    RenderSettings settings_;
+    TileSettings tile_settings_;
+    MapStyles styles_;
+    StopProjection projection_;
+    double world_size_;
+
+    Tiles RenderTiles(const TileRange& range) const;
+    void DrawRoutes(Tiles& tiles, const TileRange& range) const;
+    void DrawRouteLabels(Tiles& tiles, const TileRange& range) const;
+    void DrawStopCircles(Tiles& tiles, const TileRange& range) const;
+    void DrawStopLabels(Tiles& tiles, const TileRange& range) const;
+
+    // Вызывает action(x, y, точка в координатах тайла) для тайлов, в которые
+    // попадает точка карты с запасом margin пикселей
+    template <typename Action>
+    void ForEachTileNear(svg::Point point, double margin, const TileRange& range, Action action) const;
+
+    static std::string MakeDocument(const TileLayers& layers);
+};
+
+// Бросает std::invalid_argument, если уровни вне 0..MAX_TILE_ZOOM или tile_size не положителен
+TileSettings ParseTileSettings(const json::Node& tile_settings_node);
+
+}  // namespace map_renderer
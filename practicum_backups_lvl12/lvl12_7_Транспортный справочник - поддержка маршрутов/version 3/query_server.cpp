@@ -0,0 +1,505 @@
+#include "query_server.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace query_server {
+
+namespace {
+
+// Ответ об ошибке; request_id - если у запроса удалось прочитать id
+void WriteError(json::Writer& writer, const json::Node* request, std::string_view message) {
+    writer.StartDict().Key("error_message").Value(message);
+    if (request && request->IsMap()) {
+        const auto id_it = request->AsMap().find("id");
+        if (id_it != request->AsMap().end() && id_it->second.IsInt()) {
+            writer.Key("request_id").Value(id_it->second.AsInt());
+        }
+    }
+    writer.EndDict();
+}
+
+// Тип запроса или пустая строка, если его нет
+std::string_view GetRequestType(const json::Node& request) {
+    if (!request.IsMap()) {
+        return {};
+    }
+    const auto type_it = request.AsMap().find("type");
+    if (type_it == request.AsMap().end() || !type_it->second.IsString()) {
+        return {};
+    }
+    return type_it->second.AsString();
+}
+
+// Значение id запроса, если оно есть; id не числом - ошибка запроса
+std::optional<int> GetRequestId(const json::Node& request) {
+    const auto id_it = request.AsMap().find("id");
+    if (id_it == request.AsMap().end()) {
+        return std::nullopt;
+    }
+    if (!id_it->second.IsInt()) {
+        throw std::invalid_argument("invalid request id");
+    }
+    return id_it->second.AsInt();
+}
+
+void WriteRequestId(json::Writer& writer, std::optional<int> id) {
+    if (id) {
+        writer.Key("request_id").Value(*id);
+    }
+}
+
+// Строка, которая может оказаться запросом Reload. Проверка без разбора JSON, поэтому
+// лишнее совпадение (например, "Reload" в имени остановки) только зря ставит границу пачки
+bool MayBeReload(const std::string& line) {
+    return line.find("Reload") != std::string::npos;
+}
+
+} // namespace
+
+DataSnapshot::DataSnapshot(const std::string& snapshot_file, request_stats::RequestStats* request_stats)
+    : reader_(catalogue_) {
+    std::ifstream in(snapshot_file, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open snapshot file: " + snapshot_file);
+    }
+    auto snapshot = serialization::LoadSnapshot(in, catalogue_);
+    render_settings_ = std::move(snapshot.render_settings);
+    reader_.SetRouter(std::move(snapshot.router));
+    reader_.SetRequestStats(request_stats);
+    // Отсортированные индексы справочника строятся сразу, а не первым запросом
+    catalogue_.GetSortedAllBuses();
+}
+
+bool DataSnapshot::ProcessRequest(const json::Node& request, json::Writer& writer) {
+    return reader_.ProcessRequest(request, render_settings_, writer);
+}
+
+void DataSnapshot::WriteRequestStats(json::Writer& writer) {
+    reader_.WriteRequestStats(writer);
+}
+
+WorkerPool::WorkerPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this] {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock lock(mutex_);
+                    has_tasks_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+                    if (tasks_.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks_.front());
+                    tasks_.pop_front();
+                }
+                task();
+            }
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard guard(mutex_);
+        stopping_ = true;
+    }
+    has_tasks_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::Submit(std::function<void()> task) {
+    {
+        std::lock_guard guard(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    has_tasks_.notify_one();
+}
+
+QueryServer::QueryServer(const ServerSettings& settings)
+    : settings_(settings)
+    , snapshot_(std::make_shared<DataSnapshot>(settings.snapshot_file, &request_stats_))
+    , pool_(settings.thread_count) {
+}
+
+std::shared_ptr<DataSnapshot> QueryServer::GetSnapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void QueryServer::Reload(const std::string& snapshot_file) {
+    // Загрузка идёт без блокировок: до подмены все читают прежний снимок
+    auto snapshot = std::make_shared<DataSnapshot>(snapshot_file, &request_stats_);
+    std::atomic_store(&snapshot_, std::move(snapshot));
+}
+
+void QueryServer::WriteRequestStats(json::Writer& writer) {
+    GetSnapshot()->WriteRequestStats(writer);
+}
+
+std::string QueryServer::ProcessLines(const std::vector<std::string>& lines) {
+    std::string output;
+    // Снимок берётся один раз на пачку: все её запросы видят одну версию базы
+    std::shared_ptr<DataSnapshot> snapshot = GetSnapshot();
+    for (const auto& line : lines) {
+        ProcessLine(line, snapshot, output);
+    }
+    return output;
+}
+
+void QueryServer::ProcessLine(const std::string& line, std::shared_ptr<DataSnapshot>& snapshot, std::string& output) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+        return;
+    }
+    // Ответ собирается отдельно: если запрос упадёт посреди ответа, недописанный
+    // словарь отбрасывается и вместо него выводится ошибка
+    std::ostringstream response;
+    std::optional<json::Document> document;
+    try {
+        document.emplace(json::LoadJSON(line));
+    } catch (const std::exception&) {
+        json::Writer writer(response, RESPONSE_SETTINGS);
+        WriteError(writer, nullptr, "invalid request");
+    }
+
+    if (document) {
+        const json::Node& request = document->GetRoot();
+        try {
+            json::Writer writer(response, RESPONSE_SETTINGS);
+            WriteResponse(request, snapshot, writer);
+        } catch (const std::exception& e) {
+            response.str({});
+            json::Writer writer(response, RESPONSE_SETTINGS);
+            WriteError(writer, &request, e.what());
+        }
+    }
+    output += response.str();
+    output += '\n';
+}
+
+void QueryServer::WriteResponse(const json::Node& request, std::shared_ptr<DataSnapshot>& snapshot,
+                                json::Writer& writer) {
+    const std::string_view type = GetRequestType(request);
+    if (type == "Reload") {
+        const std::optional<int> id = GetRequestId(request);
+        const auto file_it = request.AsMap().find("file");
+        Reload(file_it != request.AsMap().end() ? file_it->second.AsString() : settings_.snapshot_file);
+        snapshot = GetSnapshot();
+        writer.StartDict();
+        WriteRequestId(writer, id);
+        writer.Key("status").Value("reloaded").EndDict();
+        return;
+    }
+    if (type == "Stats") {
+        writer.StartDict();
+        WriteRequestId(writer, GetRequestId(request));
+        writer.Key("stats");
+        snapshot->WriteRequestStats(writer);
+        writer.EndDict();
+        return;
+    }
+    if (!snapshot->ProcessRequest(request, writer)) {
+        WriteError(writer, &request, "unknown request");
+    }
+}
+
+void QueryServer::Serve(std::istream& input, std::ostream& output) {
+    // Пачки обрабатывает пул, а отдельный поток выводит их результаты по порядку
+    const size_t max_pending = pool_.GetThreadCount() * 4;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::future<std::string>> pending;
+    bool input_done = false;
+
+    std::thread printer([&] {
+        std::unique_lock lock(mutex);
+        while (true) {
+            changed.wait(lock, [&] { return !pending.empty() || input_done; });
+            if (pending.empty()) {
+                return;
+            }
+            std::future<std::string> result = std::move(pending.front());
+            pending.pop_front();
+            changed.notify_all();
+            lock.unlock();
+            output << result.get() << std::flush;
+            lock.lock();
+        }
+    });
+
+    // Пачки, отданные пулу и ещё не обработанные
+    size_t running = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        // Строки, которые уже прочитаны в буфер, идут одной пачкой: так интерактивный
+        // клиент получает ответ сразу, а поток запросов обрабатывается крупными кусками.
+        // Reload заканчивает пачку
+        bool reload = MayBeReload(line);
+        std::vector<std::string> lines{std::move(line)};
+        while (!reload && lines.size() < MAX_BATCH_SIZE && input.rdbuf()->in_avail() > 0
+               && std::getline(input, line)) {
+            reload = MayBeReload(line);
+            lines.push_back(std::move(line));
+        }
+        auto task = std::make_shared<std::packaged_task<std::string()>>([&, reload, lines = std::move(lines)] {
+            std::string result = ProcessLines(lines);
+            if (!reload) {
+                // Результат становится готовым только после выхода отсюда, поэтому
+                // локальные переменные Serve ещё живы
+                {
+                    std::lock_guard guard(mutex);
+                    --running;
+                }
+                changed.notify_all();
+            }
+            return result;
+        });
+        {
+            std::unique_lock lock(mutex);
+            // Reload - граница: предыдущие пачки должны закончиться на старом снимке,
+            // а следующие начаться только на новом
+            changed.wait(lock, [&] { return pending.size() < max_pending && (!reload || running == 0); });
+            pending.push_back(task->get_future());
+            if (!reload) {
+                ++running;
+            }
+        }
+        changed.notify_all();
+        if (reload) {
+            (*task)();
+        } else {
+            pool_.Submit([task] { (*task)(); });
+        }
+    }
+
+    {
+        std::lock_guard guard(mutex);
+        input_done = true;
+    }
+    changed.notify_all();
+    printer.join();
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace {
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// Отправляет сколько примет сокет и убирает отправленное из data. false, если клиент
+// отключился: тогда ответ просто теряется
+bool SendAvailable(int fd, std::string& data) {
+    size_t sent_total = 0;
+    while (sent_total < data.size()) {
+        const ssize_t sent = send(fd, data.data() + sent_total, data.size() - sent_total, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (sent <= 0) {
+            data.clear();
+            return false;
+        }
+        sent_total += static_cast<size_t>(sent);
+    }
+    data.erase(0, sent_total);
+    return true;
+}
+
+std::system_error MakeSystemError(const char* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+void SetNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw MakeSystemError("fcntl");
+    }
+}
+
+} // namespace
+
+void QueryServer::ServeSocket() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (settings_.socket_path.empty() || settings_.socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Invalid socket path: " + settings_.socket_path);
+    }
+    std::copy(settings_.socket_path.begin(), settings_.socket_path.end(), address.sun_path);
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw MakeSystemError("socket");
+    }
+    unlink(settings_.socket_path.c_str());
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listener, SOMAXCONN) < 0) {
+        throw MakeSystemError("bind");
+    }
+    // Рабочие потоки складывают готовые ответы в finished и будят этот поток байтом в канал.
+    // Сами они в сокеты не пишут: клиент, который не читает ответы, занял бы поток пула
+    int wake_pipe[2];
+    if (pipe(wake_pipe) < 0) {
+        throw MakeSystemError("pipe");
+    }
+    // Переполненный канал и так разбудит poll, лишний байт можно не писать
+    SetNonBlocking(wake_pipe[1]);
+    std::mutex finished_mutex;
+    std::vector<std::pair<int, std::string>> finished;
+
+    struct Connection {
+        std::string input;
+        std::string output;   // Ответы, которые сокет ещё не принял
+        bool busy = false;    // Пачка клиента в работе; пока она не закончится, клиента не читаем
+        bool closed = false;  // Клиент отключился, сокет закрывается после текущей пачки
+    };
+    // Состояние клиентов меняет только этот поток
+    std::unordered_map<int, Connection> connections;
+
+    const auto dispatch = [&](int fd, Connection& connection) {
+        const size_t end = connection.input.rfind('\n');
+        if (connection.busy || end == std::string::npos) {
+            return;
+        }
+        std::vector<std::string> lines;
+        for (size_t begin = 0; begin <= end;) {
+            const size_t line_end = connection.input.find('\n', begin);
+            lines.push_back(connection.input.substr(begin, line_end - begin));
+            begin = line_end + 1;
+        }
+        connection.input.erase(0, end + 1);
+        connection.busy = true;
+        pool_.Submit([this, fd, lines = std::move(lines), wake_fd = wake_pipe[1], &finished_mutex, &finished] {
+            std::string output = ProcessLines(lines);
+            {
+                std::lock_guard guard(finished_mutex);
+                finished.emplace_back(fd, std::move(output));
+            }
+            const char byte = 0;
+            [[maybe_unused]] const ssize_t written = write(wake_fd, &byte, 1);
+        });
+    };
+    const auto close_connection = [&](int fd) {
+        close(fd);
+        connections.erase(fd);
+    };
+    // Отправляет накопленные ответы. Следующую пачку клиента берём, только когда он принял
+    // ответы на предыдущую: так необработанный ввод не копится за медленным клиентом
+    const auto flush = [&](int fd, Connection& connection) {
+        if (!SendAvailable(fd, connection.output)) {
+            connection.closed = true;
+        }
+        if (!connection.output.empty() || connection.busy) {
+            return;
+        }
+        if (connection.closed) {
+            close_connection(fd);
+        } else {
+            dispatch(fd, connection);
+        }
+    };
+
+    std::vector<pollfd> poll_fds;
+    std::vector<char> buffer(1 << 16);
+    while (true) {
+        poll_fds.clear();
+        poll_fds.push_back({listener, POLLIN, 0});
+        poll_fds.push_back({wake_pipe[0], POLLIN, 0});
+        for (const auto& [fd, connection] : connections) {
+            if (!connection.output.empty()) {
+                poll_fds.push_back({fd, POLLOUT, 0});
+            } else if (!connection.busy && !connection.closed) {
+                poll_fds.push_back({fd, POLLIN, 0});
+            }
+        }
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw MakeSystemError("poll");
+        }
+
+        if (poll_fds[1].revents & POLLIN) {
+            char bytes[64];
+            [[maybe_unused]] const ssize_t size = read(wake_pipe[0], bytes, sizeof(bytes));
+            std::vector<std::pair<int, std::string>> ready;
+            {
+                std::lock_guard guard(finished_mutex);
+                ready.swap(finished);
+            }
+            for (auto& [fd, output] : ready) {
+                Connection& connection = connections.at(fd);
+                connection.busy = false;
+                connection.output += output;
+                flush(fd, connection);
+            }
+        }
+        if (poll_fds[0].revents & POLLIN) {
+            const int client = accept(listener, nullptr, nullptr);
+            if (client >= 0) {
+                SetNonBlocking(client);
+                connections.emplace(client, Connection{});
+            }
+        }
+        for (size_t i = 2; i < poll_fds.size(); ++i) {
+            if (poll_fds[i].revents == 0) {
+                continue;
+            }
+            const int fd = poll_fds[i].fd;
+            Connection& connection = connections.at(fd);
+            if (poll_fds[i].events & POLLOUT) {
+                flush(fd, connection);
+                continue;
+            }
+            const ssize_t size = read(fd, buffer.data(), buffer.size());
+            if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                continue;
+            }
+            if (size <= 0) {
+                connection.closed = true;
+                if (!connection.busy) {
+                    close_connection(fd);
+                }
+                continue;
+            }
+            connection.input.append(buffer.data(), static_cast<size_t>(size));
+            dispatch(fd, connection);
+        }
+    }
+}
+
+#else
+
+void QueryServer::ServeSocket() {
+    throw std::runtime_error("Unix sockets are not supported on this platform");
+}
+
+#endif
+
+} // namespace query_server
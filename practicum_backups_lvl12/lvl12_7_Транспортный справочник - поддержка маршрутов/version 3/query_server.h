@@ -0,0 +1,115 @@
+#pragma once
+
+#include "json.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "map_renderer.h"
+#include "request_stats.h"
+#include "transport_catalogue.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Долгоживущий режим: снимок базы загружается один раз, запросы приходят по одному JSON
+// на строку (со стандартного ввода или от клиентов unix-сокета) и обрабатываются пулом потоков.
+// Ответ на каждый запрос - тоже одна строка, в порядке запросов своего клиента
+namespace query_server {
+
+struct ServerSettings {
+    std::string snapshot_file;
+    std::string socket_path;  // Пусто - запросы читаются со стандартного ввода
+    size_t thread_count = 0;  // 0 - по числу ядер
+};
+
+// Загруженный снимок базы. После создания справочник не меняется, поэтому запросы к нему
+// обрабатываются параллельно. Перезагрузка создаёт новый снимок, а старый живёт, пока
+// его не отпустят начатые на нём запросы
+class DataSnapshot {
+public:
+    // Время запросов учитывается в request_stats, если он задан
+    explicit DataSnapshot(const std::string& snapshot_file, request_stats::RequestStats* request_stats = nullptr);
+
+    // false, если на запрос нет ответа (см. JsonReader::ProcessRequest)
+    bool ProcessRequest(const json::Node& request, json::Writer& writer);
+    void WriteRequestStats(json::Writer& writer);
+
+private:
+    transport_catalogue::TransportCatalogue catalogue_;
+    map_renderer::RenderSettings render_settings_;
+    json_reader::JsonReader reader_;  // Ссылается на catalogue_
+};
+
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t thread_count);
+    // Дожидается выполнения уже поставленных задач
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    size_t GetThreadCount() const {
+        return threads_.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable has_tasks_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+class QueryServer {
+public:
+    explicit QueryServer(const ServerSettings& settings);
+
+    // Отвечает на строки input, пока он не закончится. Строки, уже лежащие в буфере потока,
+    // обрабатываются пачками параллельно, ответы выводятся в порядке запросов. Reload
+    // выполняется, когда закончены все пачки до него, и следующие пачки ждут его окончания
+    void Serve(std::istream& input, std::ostream& output);
+    // Принимает клиентов на settings.socket_path и обслуживает их, пока процесс не остановят.
+    // Пока пачка запросов клиента в работе, его следующие строки ждут в буфере
+    void ServeSocket();
+
+    // Ответы на пачку строк, по строке на непустой запрос. Запрос {"type": "Reload"}
+    // (с необязательным "file") загружает снимок заново; следующие запросы пачки видят уже
+    // новый. Пачки, идущие одновременно с этой, могут ещё работать на старом.
+    // Запрос {"type": "Stats"} возвращает статистику запросов с запуска сервера
+    std::string ProcessLines(const std::vector<std::string>& lines);
+
+    std::shared_ptr<DataSnapshot> GetSnapshot() const;
+    // Загружает снимок и подменяет им текущий (RCU): читатели берут указатель атомарно
+    // и дорабатывают на старом снимке, память которого освобождает последний из них
+    void Reload(const std::string& snapshot_file);
+
+    // Время и выделения памяти по типам запросов с запуска сервера, кэш текущего роутера
+    void WriteRequestStats(json::Writer& writer);
+
+private:
+    static constexpr size_t MAX_BATCH_SIZE = 256;
+    static constexpr json::WriterSettings RESPONSE_SETTINGS{false, 0, 6};
+
+    ServerSettings settings_;
+    // Общая для всех снимков, поэтому объявлена раньше них
+    request_stats::RequestStats request_stats_;
+    std::shared_ptr<DataSnapshot> snapshot_;  // Только через std::atomic_load и std::atomic_store
+    WorkerPool pool_;
+
+    // Дописывает к output строку ответа на запрос line
+    void ProcessLine(const std::string& line, std::shared_ptr<DataSnapshot>& snapshot, std::string& output);
+    // Ответ на разобранный запрос; Reload заменяет snapshot новым
+    void WriteResponse(const json::Node& request, std::shared_ptr<DataSnapshot>& snapshot, json::Writer& writer);
+};
+
+} // namespace query_server
@@ -0,0 +1,170 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace transport {
+
+RaptorRouter::RaptorRouter(const RouterSettings& settings, const transport_catalogue::TransportCatalogue& catalogue)
+    : catalogue_(catalogue)
+    , bus_wait_time_(static_cast<double>(settings.bus_wait_time))
+    , velocity_coef_(settings.bus_velocity * 1000.0 / 60.0)
+{
+    for (const auto& bus : catalogue.GetAllBuses()) {
+        if (bus.stops.size() < 2) {
+            continue;
+        }
+        AddPattern(bus, false);
+        if (!bus.is_round_trip) {
+            AddPattern(bus, true);
+        }
+    }
+
+    const size_t stop_count = catalogue.GetAllStops().size();
+    stop_pattern_offsets_.assign(stop_count + 1, 0);
+    for (const Pattern& pattern : patterns_) {
+        for (const uint32_t stop : pattern.stops) {
+            ++stop_pattern_offsets_[stop + 1];
+        }
+    }
+    std::partial_sum(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end(), stop_pattern_offsets_.begin());
+
+    stop_patterns_.resize(stop_pattern_offsets_.back());
+    std::vector<uint32_t> next(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end() - 1);
+    for (uint32_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+        const auto& stops = patterns_[pattern].stops;
+        for (uint32_t position = 0; position < stops.size(); ++position) {
+            stop_patterns_[next[stops[position]]++] = {pattern, position};
+        }
+    }
+}
+
+void RaptorRouter::AddPattern(const transport_catalogue::Bus& bus, bool backward) {
+    const size_t stops_count = bus.stops.size();
+    Pattern pattern{&bus, {}, {}};
+    pattern.stops.reserve(stops_count);
+    pattern.distances.reserve(stops_count);
+    for (size_t i = 0; i < stops_count; ++i) {
+        // Обратный проход идёт от последней остановки к первой: путь от неё до stops[k] -
+        // разность накопленных обратных расстояний
+        const size_t k = backward ? stops_count - 1 - i : i;
+        pattern.stops.push_back(bus.stops[k]->id);
+        pattern.distances.push_back(backward ? bus.backward_distances[stops_count - 1] - bus.backward_distances[k]
+                                             : bus.forward_distances[k]);
+    }
+    patterns_.push_back(std::move(pattern));
+}
+
+double RaptorRouter::GetRideTime(const Pattern& pattern, uint32_t board_position, uint32_t alight_position) const {
+    const int distance = pattern.distances[alight_position] - pattern.distances[board_position];
+    return distance / velocity_coef_;
+}
+
+std::vector<RouteOption> RaptorRouter::FindRouteOptions(std::string_view stop_from, std::string_view stop_to,
+                                                        size_t max_transfers) const {
+    const auto* from = catalogue_.FindStop(stop_from);
+    const auto* to = catalogue_.FindStop(stop_to);
+    if (!from || !to) {
+        return {};
+    }
+    if (from == to) {
+        return {RouteOption{}};
+    }
+
+    constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+    const size_t stop_count = catalogue_.GetAllStops().size();
+    const uint32_t target = to->id;
+    const size_t max_rounds = max_transfers == NO_TRANSFER_LIMIT ? max_transfers : max_transfers + 1;
+
+    // arrivals[k][stop] - лучшее время прибытия не более чем за k поездок, labels[k][stop] -
+    // последняя поездка, если время улучшилось именно в раунде k
+    std::vector<std::vector<double>> arrivals(1, std::vector<double>(stop_count, UNREACHED));
+    std::vector<std::vector<Label>> labels(1, std::vector<Label>(stop_count));
+    arrivals[0][from->id] = 0.0;
+
+    std::vector<uint32_t> marked{from->id};
+    std::vector<bool> is_marked(stop_count, false);
+    std::vector<uint32_t> first_position(patterns_.size(), NONE);
+    std::vector<uint32_t> queued_patterns;
+    std::vector<RouteOption> options;
+
+    for (size_t round = 1; round <= max_rounds && !marked.empty(); ++round) {
+        // Каждый проход через улучшенные остановки просматривается с самой ранней из них
+        for (const uint32_t stop : marked) {
+            is_marked[stop] = false;
+            for (uint32_t i = stop_pattern_offsets_[stop]; i < stop_pattern_offsets_[stop + 1]; ++i) {
+                const auto [pattern, position] = stop_patterns_[i];
+                if (first_position[pattern] == NONE) {
+                    queued_patterns.push_back(pattern);
+                    first_position[pattern] = position;
+                } else {
+                    first_position[pattern] = std::min(first_position[pattern], position);
+                }
+            }
+        }
+        marked.clear();
+
+        arrivals.push_back(arrivals.back());
+        labels.emplace_back(stop_count);
+        const std::vector<double>& previous = arrivals[round - 1];
+        std::vector<double>& current = arrivals[round];
+        std::vector<Label>& round_labels = labels[round];
+
+        for (const uint32_t pattern_index : queued_patterns) {
+            const Pattern& pattern = patterns_[pattern_index];
+            uint32_t board_position = NONE;
+            double board_time = UNREACHED;
+            for (uint32_t position = first_position[pattern_index]; position < pattern.stops.size(); ++position) {
+                const uint32_t stop = pattern.stops[position];
+                double arrival = UNREACHED;
+                if (board_position != NONE) {
+                    arrival = board_time + GetRideTime(pattern, board_position, position);
+                    // Прибытие позже уже найденного до цели ничего не даст и в следующих раундах
+                    if (arrival < current[stop] && arrival < current[target]) {
+                        current[stop] = arrival;
+                        round_labels[stop] = {pattern_index, board_position, position};
+                        if (!is_marked[stop]) {
+                            is_marked[stop] = true;
+                            marked.push_back(stop);
+                        }
+                    }
+                }
+                // Сесть здесь, если так доедем дальше раньше, чем уже выбранной поездкой
+                if (previous[stop] + bus_wait_time_ < arrival) {
+                    board_position = position;
+                    board_time = previous[stop] + bus_wait_time_;
+                }
+            }
+            first_position[pattern_index] = NONE;
+        }
+        queued_patterns.clear();
+
+        if (current[target] < previous[target]) {
+            options.push_back({ExtractRoute(labels, arrivals, round, target), round - 1});
+        }
+    }
+    return options;
+}
+
+RouteInfo RaptorRouter::ExtractRoute(const std::vector<std::vector<Label>>& labels,
+                                     const std::vector<std::vector<double>>& arrivals,
+                                     size_t round, uint32_t stop) const {
+    RouteInfo route;
+    route.total_time = arrivals[round][stop];
+    for (; round > 0; --round) {
+        const Label& label = labels[round][stop];
+        if (label.pattern == NONE) {
+            // В этом раунде время не улучшилось: путь тот же, что и в предыдущем
+            continue;
+        }
+        const Pattern& pattern = patterns_[label.pattern];
+        route.items.push_back(BusItem{pattern.bus->name, label.alight_position - label.board_position,
+                                      GetRideTime(pattern, label.board_position, label.alight_position)});
+        stop = pattern.stops[label.board_position];
+        route.items.push_back(WaitItem{catalogue_.GetAllStops()[stop].name, bus_wait_time_});
+    }
+    std::reverse(route.items.begin(), route.items.end());
+    return route;
+}
+
+} // namespace transport
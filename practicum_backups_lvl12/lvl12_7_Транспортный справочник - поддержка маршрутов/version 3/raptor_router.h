@@ -0,0 +1,77 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+// Вариант поездки из множества Парето по паре (время в пути, число пересадок)
+struct RouteOption {
+    RouteInfo route;
+    size_t transfer_count = 0;
+};
+
+// Поиск маршрутов по раундам (RAPTOR) прямо по последовательностям остановок маршрутов
+// справочника, без графа со всеми парами остановок. Раунд k находит лучшее время прибытия
+// на каждую остановку не более чем за k поездок: каждый маршрут просматривается один раз
+// от первой остановки, куда удалось добраться в прошлом раунде. Модель та же, что у Router:
+// каждая посадка стоит bus_wait_time минут, некольцевой маршрут едет в обе стороны, но
+// проехать через конечную нельзя. Имена в ответе ссылаются на справочник
+class RaptorRouter {
+public:
+    static constexpr size_t NO_TRANSFER_LIMIT = std::numeric_limits<size_t>::max();
+
+    RaptorRouter(const RouterSettings& settings, const transport_catalogue::TransportCatalogue& catalogue);
+
+    // Варианты по возрастанию числа пересадок: каждый следующий строго быстрее предыдущего,
+    // первый - с наименьшим числом пересадок, последний - самый быстрый. Пусто, если
+    // остановки не связаны или неизвестны. Метод не меняет состояния и безопасен для
+    // одновременных вызовов
+    std::vector<RouteOption> FindRouteOptions(std::string_view stop_from, std::string_view stop_to,
+                                              size_t max_transfers = NO_TRANSFER_LIMIT) const;
+
+private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    // Проход маршрута в одну сторону: остановки по порядку и накопленные расстояния
+    // от первой из них (разность даёт ровно то же время поездки, что ребро Router)
+    struct Pattern {
+        const transport_catalogue::Bus* bus;
+        std::vector<uint32_t> stops;
+        std::vector<int> distances;
+    };
+
+    // Остановки проходов, отсортированные по id остановки: проходы остановки с id i лежат
+    // в stop_patterns_[stop_pattern_offsets_[i] .. stop_pattern_offsets_[i + 1])
+    struct StopPattern {
+        uint32_t pattern;
+        uint32_t position;
+    };
+
+    // Как попали на остановку в раунде: проход, индексы посадки и высадки в нём
+    struct Label {
+        uint32_t pattern = NONE;
+        uint32_t board_position = 0;
+        uint32_t alight_position = 0;
+    };
+
+    const transport_catalogue::TransportCatalogue& catalogue_;
+    double bus_wait_time_;
+    double velocity_coef_;
+    std::vector<Pattern> patterns_;
+    std::vector<uint32_t> stop_pattern_offsets_;
+    std::vector<StopPattern> stop_patterns_;
+
+    void AddPattern(const transport_catalogue::Bus& bus, bool backward);
+    double GetRideTime(const Pattern& pattern, uint32_t board_position, uint32_t alight_position) const;
+    RouteInfo ExtractRoute(const std::vector<std::vector<Label>>& labels,
+                           const std::vector<std::vector<double>>& arrivals,
+                           size_t round, uint32_t stop) const;
+};
+
+} // namespace transport
@@ -0,0 +1,126 @@
+#include "request_stats.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace request_stats {
+
+namespace {
+
+int ToJsonCount(uint64_t value) {
+    return static_cast<int>(std::min<uint64_t>(value, INT_MAX));
+}
+
+double ToMicroseconds(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e3;
+}
+
+} // namespace
+
+size_t LatencyHistogram::GetBucketIndex(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    // Сдвиг, после которого в значении остаётся SUB_BUCKET_BITS + 1 значащих бит
+    int shift = 0;
+    while ((value >> shift) >= 2 * SUB_BUCKET_COUNT) {
+        ++shift;
+    }
+    return static_cast<size_t>(shift) * SUB_BUCKET_COUNT + static_cast<size_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return index;
+    }
+    const size_t shift = index / SUB_BUCKET_COUNT - 1;
+    const uint64_t mantissa = index - shift * SUB_BUCKET_COUNT;
+    return (mantissa << shift) + ((uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::Record(uint64_t nanoseconds) {
+    ++buckets_[GetBucketIndex(nanoseconds)];
+    ++count_;
+    total_ += nanoseconds;
+    max_ = std::max(max_, nanoseconds);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double quantile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(GetBucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+RequestStats::RequestStats()
+    : start_(std::chrono::steady_clock::now()) {
+}
+
+void RequestStats::Record(std::string_view type, std::chrono::nanoseconds duration, uint64_t allocations) {
+    const uint64_t nanoseconds = static_cast<uint64_t>(std::max<std::chrono::nanoseconds::rep>(duration.count(), 0));
+    std::lock_guard guard(mutex_);
+    auto it = types_.find(type);
+    if (it == types_.end()) {
+        it = types_.emplace(std::string(type), TypeStats{}).first;
+    }
+    it->second.latency.Record(nanoseconds);
+    it->second.allocations += allocations;
+}
+
+void RequestStats::Write(json::Writer& writer, std::optional<graph::Router<double>::CacheStats> route_cache) const {
+    const std::chrono::duration<double> uptime = std::chrono::steady_clock::now() - start_;
+    LatencyHistogram all;
+
+    std::lock_guard guard(mutex_);
+    writer.StartDict().Key("requests").StartDict();
+    for (const auto& [type, stats] : types_) {
+        const LatencyHistogram& latency = stats.latency;
+        all.Merge(latency);
+        const double count = static_cast<double>(latency.GetCount());
+        writer.Key(type).StartDict()
+            .Key("allocations_per_request").Value(stats.allocations / count)
+            .Key("count").Value(ToJsonCount(latency.GetCount()))
+            .Key("max_us").Value(ToMicroseconds(latency.GetMax()))
+            .Key("mean_us").Value(ToMicroseconds(latency.GetTotal()) / count)
+            .Key("p50_us").Value(ToMicroseconds(latency.GetPercentile(0.5)))
+            .Key("p90_us").Value(ToMicroseconds(latency.GetPercentile(0.9)))
+            .Key("p999_us").Value(ToMicroseconds(latency.GetPercentile(0.999)))
+            .Key("p99_us").Value(ToMicroseconds(latency.GetPercentile(0.99)))
+            .Key("total_ms").Value(ToMicroseconds(latency.GetTotal()) / 1e3)
+            .EndDict();
+    }
+    writer.EndDict()
+        .Key("requests_per_second").Value(all.GetCount() / uptime.count());
+
+    if (route_cache) {
+        const uint64_t lookups = route_cache->hits + route_cache->misses;
+        writer.Key("route_cache").StartDict()
+            .Key("hit_rate").Value(lookups == 0 ? 0.0 : static_cast<double>(route_cache->hits) / lookups)
+            .Key("hits").Value(ToJsonCount(route_cache->hits))
+            .Key("misses").Value(ToJsonCount(route_cache->misses))
+            .EndDict();
+    }
+    writer.Key("total_count").Value(ToJsonCount(all.GetCount()))
+        .Key("uptime_s").Value(uptime.count())
+        .EndDict();
+}
+
+} // namespace request_stats
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "json_writer.h"
+#include "router.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace request_stats {
+
+// Гистограмма времени в наносекундах с логарифмически-линейными корзинами, как в HDR Histogram:
+// каждая степень двойки делится на SUB_BUCKET_COUNT равных корзин, поэтому перцентили
+// точны до 1/32 значения при любом порядке величин, а запись - одно приращение счётчика
+class LatencyHistogram {
+public:
+    void Record(uint64_t nanoseconds);
+    void Merge(const LatencyHistogram& other);
+
+    uint64_t GetCount() const {
+        return count_;
+    }
+    uint64_t GetTotal() const {
+        return total_;
+    }
+    uint64_t GetMax() const {
+        return max_;
+    }
+    // Верхняя граница корзины, в которую попало значение с долей quantile (от 0 до 1)
+    uint64_t GetPercentile(double quantile) const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t{1} << SUB_BUCKET_BITS;
+    // Корзины 0..SUB_BUCKET_COUNT - 1 точные, дальше по SUB_BUCKET_COUNT на каждый сдвиг
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    static size_t GetBucketIndex(uint64_t value);
+    static uint64_t GetBucketUpperBound(size_t index);
+
+    std::array<uint64_t, BUCKET_COUNT> buckets_{};
+    uint64_t count_ = 0;
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+};
+
+// Время, число запросов и выделений памяти по типам запросов stat_requests.
+// Выделения считаются, только если в программу слинкован allocation_counter.cpp
+// Record можно вызывать одновременно из нескольких потоков
+class RequestStats {
+public:
+    RequestStats();
+
+    void Record(std::string_view type, std::chrono::nanoseconds duration, uint64_t allocations);
+
+    // Словарь со статистикой по каждому типу запроса (перцентили в микросекундах), общей
+    // пропускной способностью с момента создания и попаданиями в кэш деревьев путей роутера
+    void Write(json::Writer& writer, std::optional<graph::Router<double>::CacheStats> route_cache) const;
+
+private:
+    struct TypeStats {
+        LatencyHistogram latency;
+        uint64_t allocations = 0;
+    };
+
+    const std::chrono::steady_clock::time_point start_;
+    mutable std::mutex mutex_;
+    std::map<std::string, TypeStats, std::less<>> types_;
+};
+
+} // namespace request_stats
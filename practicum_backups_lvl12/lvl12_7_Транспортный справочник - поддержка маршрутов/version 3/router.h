@@ -5,8 +5,12 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <list>
+#include <mutex>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -20,98 +24,280 @@ private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    // Нижняя оценка веса пути от вершины до цели (для A*). Должна быть согласованной:
+    // h(u) <= w(u, v) + h(v) для любого ребра u -> v
+    using Heuristic = std::function<Weight(VertexId vertex, VertexId target)>;
+
+    static constexpr size_t DEFAULT_CACHE_CAPACITY = 64;
+
+    explicit Router(const Graph& graph,
+                    size_t cache_capacity = DEFAULT_CACHE_CAPACITY,
+                    Heuristic heuristic = {});
 
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
+    // Обращения BuildRoute к кэшу деревьев: промах - каждый поиск, посчитанный заново
+    struct CacheStats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    // Можно вызывать одновременно из нескольких потоков: кэш защищён мьютексом,
+    // а деревья путей считаются вне его
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Веса кратчайших путей из from во все вершины. Кэш не используется, поэтому метод
+    // можно вызывать одновременно из нескольких потоков
+    std::vector<std::optional<Weight>> BuildRouteWeights(VertexId from) const;
+
+    // Поддержка кэша при правке графа на месте: вызывается перед увеличением веса или
+    // удалением ребра и после уменьшения веса или добавления ребра. Сбрасываются только
+    // деревья, которые правка может изменить
+    void InvalidateBeforeEdgeIncrease(EdgeId edge_id);
+    void InvalidateAfterEdgeDecrease(EdgeId edge_id);
+    // После добавления вершин в граф: в закэшированных деревьях новые вершины недостижимы
+    void OnVerticesAdded();
+    void ClearCache();
+
+    CacheStats GetCacheStats() const;
+
 private:
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
-
-    void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
-                    throw std::domain_error("Edges' weights should be non-negative");
-                }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
-                }
+    // Дерево кратчайших путей из одной вершины-источника
+    using ShortestPathTree = std::vector<std::optional<RouteInternalData>>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    struct CacheEntry {
+        ShortestPathTree tree;
+        typename std::list<VertexId>::iterator lru_position;
+    };
+
+    ShortestPathTree ComputeShortestPathTree(VertexId from) const {
+        ShortestPathTree tree(graph_.GetVertexCount());
+        tree[from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        Queue queue;
+        queue.push({ZERO_WEIGHT, from});
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (tree[vertex]->weight < weight) {
+                continue;
             }
+            RelaxIncidentEdges(tree, queue, vertex, weight, [](VertexId) { return ZERO_WEIGHT; });
         }
+        return tree;
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    ShortestPathTree ComputeTargetedRoute(VertexId from, VertexId to) const {
+        ShortestPathTree tree(graph_.GetVertexCount());
+        std::vector<bool> settled(graph_.GetVertexCount(), false);
+        const auto estimate = [this, to](VertexId vertex) {
+            return heuristic_(vertex, to);
+        };
+        tree[from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        Queue queue;
+        queue.push({estimate(from), from});
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+            if (settled[vertex]) {
+                continue;
+            }
+            settled[vertex] = true;
+            if (vertex == to) {
+                break;
+            }
+            RelaxIncidentEdges(tree, queue, vertex, tree[vertex]->weight, estimate);
         }
+        return tree;
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
-                }
+    template <typename Estimate>
+    void RelaxIncidentEdges(ShortestPathTree& tree, Queue& queue, VertexId vertex, Weight weight,
+                            const Estimate& estimate) const {
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            auto& route_to = tree[edge.to];
+            if (!route_to || candidate_weight < route_to->weight) {
+                route_to = RouteInternalData{candidate_weight, edge_id};
+                queue.push({candidate_weight + estimate(edge.to), edge.to});
+            }
+        }
+    }
+
+    std::optional<RouteInfo> ExtractRoute(const ShortestPathTree& tree, VertexId to) const {
+        const auto& route_internal_data = tree.at(to);
+        if (!route_internal_data) {
+            return std::nullopt;
+        }
+        const Weight weight = route_internal_data->weight;
+        const auto prev_edge = [this, &tree](EdgeId edge_id) {
+            return tree[graph_.GetEdge(edge_id).from]->prev_edge;
+        };
+        // Сначала считаем длину пути, чтобы выделить память под рёбра один раз
+        size_t edge_count = 0;
+        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge; edge_id; edge_id = prev_edge(*edge_id)) {
+            ++edge_count;
+        }
+        std::vector<EdgeId> edges(edge_count);
+        auto edge_it = edges.rbegin();
+        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge; edge_id; edge_id = prev_edge(*edge_id)) {
+            *edge_it++ = *edge_id;
+        }
+
+        return RouteInfo{weight, std::move(edges)};
+    }
+
+    const ShortestPathTree* FindCachedTree(VertexId from) const {
+        const auto it = cache_.find(from);
+        if (it == cache_.end()) {
+            return nullptr;
+        }
+        lru_order_.splice(lru_order_.begin(), lru_order_, it->second.lru_position);
+        return &it->second.tree;
+    }
+
+    const ShortestPathTree& CacheTree(VertexId from, ShortestPathTree tree) const {
+        if (cache_.size() >= cache_capacity_) {
+            cache_.erase(lru_order_.back());
+            lru_order_.pop_back();
+        }
+        lru_order_.push_front(from);
+        return cache_.emplace(from, CacheEntry{std::move(tree), lru_order_.begin()}).first->second.tree;
+    }
+
+    template <typename Predicate>
+    void EraseCachedTrees(Predicate predicate) {
+        for (auto it = cache_.begin(); it != cache_.end();) {
+            if (predicate(it->second.tree)) {
+                lru_order_.erase(it->second.lru_position);
+                it = cache_.erase(it);
+            } else {
+                ++it;
             }
         }
     }
 
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t cache_capacity_;
+    Heuristic heuristic_;
+
+    // Кэш деревьев кратчайших путей по вершине-источнику, вытеснение по LRU
+    mutable std::mutex cache_mutex_;
+    mutable std::list<VertexId> lru_order_;
+    mutable std::unordered_map<VertexId, CacheEntry> cache_;
+    mutable CacheStats cache_stats_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, size_t cache_capacity, Heuristic heuristic)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , cache_capacity_(cache_capacity)
+    , heuristic_(std::move(heuristic))
 {
-    InitializeRoutesInternalData(graph);
-
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    const size_t edge_count = graph.GetEdgeCount();
+    for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
     }
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
-        return std::nullopt;
-    }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (heuristic_) {
+        // A* не читает и не пополняет кэш деревьев, поэтому не входит и в его статистику
+        return ExtractRoute(ComputeTargetedRoute(from, to), to);
+    }
     {
-        edges.push_back(*edge_id);
+        std::lock_guard guard(cache_mutex_);
+        if (const ShortestPathTree* tree = FindCachedTree(from)) {
+            ++cache_stats_.hits;
+            return ExtractRoute(*tree, to);
+        }
+        ++cache_stats_.misses;
+    }
+    if (cache_capacity_ == 0) {
+        return ExtractRoute(ComputeShortestPathTree(from), to);
+    }
+    ShortestPathTree tree = ComputeShortestPathTree(from);
+    std::lock_guard guard(cache_mutex_);
+    // Пока дерево считалось, его мог положить в кэш другой поток
+    if (const ShortestPathTree* cached_tree = FindCachedTree(from)) {
+        return ExtractRoute(*cached_tree, to);
+    }
+    return ExtractRoute(CacheTree(from, std::move(tree)), to);
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> Router<Weight>::BuildRouteWeights(VertexId from) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const ShortestPathTree tree = ComputeShortestPathTree(from);
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(tree.size());
+    for (const auto& route_internal_data : tree) {
+        weights.push_back(route_internal_data ? std::optional<Weight>(route_internal_data->weight) : std::nullopt);
+    }
+    return weights;
+}
+
+template <typename Weight>
+void Router<Weight>::InvalidateBeforeEdgeIncrease(EdgeId edge_id) {
+    // Если ребро не входит в дерево, пути дерева остаются кратчайшими
+    const VertexId to = graph_.GetEdge(edge_id).to;
+    std::lock_guard guard(cache_mutex_);
+    EraseCachedTrees([to, edge_id](const ShortestPathTree& tree) {
+        return tree[to] && tree[to]->prev_edge == edge_id;
+    });
+}
+
+template <typename Weight>
+void Router<Weight>::InvalidateAfterEdgeDecrease(EdgeId edge_id) {
+    const auto edge = graph_.GetEdge(edge_id);
+    if (edge.weight < ZERO_WEIGHT) {
+        throw std::domain_error("Edges' weights should be non-negative");
+    }
+    // Дерево устарело, только если через ребро теперь можно быстрее попасть в его конец
+    std::lock_guard guard(cache_mutex_);
+    EraseCachedTrees([&edge](const ShortestPathTree& tree) {
+        return tree[edge.from] && (!tree[edge.to] || tree[edge.from]->weight + edge.weight < tree[edge.to]->weight);
+    });
+}
+
+template <typename Weight>
+void Router<Weight>::OnVerticesAdded() {
+    std::lock_guard guard(cache_mutex_);
+    for (auto& [from, entry] : cache_) {
+        entry.tree.resize(graph_.GetVertexCount());
     }
-    std::reverse(edges.begin(), edges.end());
+}
 
-    return RouteInfo{weight, std::move(edges)};
+template <typename Weight>
+void Router<Weight>::ClearCache() {
+    std::lock_guard guard(cache_mutex_);
+    cache_.clear();
+    lru_order_.clear();
+}
+
+template <typename Weight>
+typename Router<Weight>::CacheStats Router<Weight>::GetCacheStats() const {
+    std::lock_guard guard(cache_mutex_);
+    return cache_stats_;
 }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
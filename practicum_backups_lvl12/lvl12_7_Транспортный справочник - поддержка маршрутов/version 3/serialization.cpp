@@ -0,0 +1,232 @@
+#include "serialization.h"
+#include "binary_io.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+namespace serialization {
+
+using namespace binary_io;
+
+namespace {
+
+void SaveCatalogue(std::ostream& out, const transport_catalogue::TransportCatalogue& catalogue) {
+    // Остановки пишутся в порядке их id, поэтому id и служит индексом в снимке
+    const auto& stops = catalogue.GetAllStops();
+    WriteSize(out, stops.size());
+    for (const auto& stop : stops) {
+        WriteString(out, stop.name);
+        WriteValue(out, stop.coordinates.lat);
+        WriteValue(out, stop.coordinates.lng);
+    }
+
+    // Упорядочиваем расстояния, чтобы снимок одной базы всегда был одинаковым
+    std::vector<std::tuple<uint32_t, uint32_t, int>> distances;
+    distances.reserve(catalogue.GetAllDistances().size());
+    for (const auto& [stops_pair, distance] : catalogue.GetAllDistances()) {
+        distances.emplace_back(stops_pair.first->id, stops_pair.second->id, distance);
+    }
+    std::sort(distances.begin(), distances.end());
+    WriteSize(out, distances.size());
+    for (const auto& [from, to, distance] : distances) {
+        WriteValue(out, from);
+        WriteValue(out, to);
+        WriteValue(out, distance);
+    }
+
+    const auto& buses = catalogue.GetAllBuses();
+    WriteSize(out, buses.size());
+    for (const auto& bus : buses) {
+        WriteString(out, bus.name);
+        WriteValue(out, bus.is_round_trip);
+        std::vector<uint32_t> bus_stops;
+        bus_stops.reserve(bus.stops.size());
+        for (const auto* stop : bus.stops) {
+            bus_stops.push_back(stop->id);
+        }
+        WriteVector(out, bus_stops);
+    }
+
+    WriteValue(out, catalogue.GetRoutingSettings().bus_wait_time);
+    WriteValue(out, catalogue.GetRoutingSettings().bus_velocity);
+    WriteValue(out, catalogue.GetRoutingSettings().use_geo_heuristic);
+}
+
+void LoadCatalogue(std::istream& in, transport_catalogue::TransportCatalogue& catalogue) {
+    const size_t stop_count = ReadSize(in);
+    std::vector<const transport_catalogue::Stop*> stops;
+    for (size_t i = 0; i < stop_count; ++i) {
+        const std::string name = ReadString(in);
+        const double lat = ReadValue<double>(in);
+        const double lng = ReadValue<double>(in);
+        if (!std::isfinite(lat) || !std::isfinite(lng) || catalogue.FindStop(name)) {
+            throw FormatError("Invalid stop: " + name);
+        }
+        catalogue.AddStop(name, {lat, lng});
+        stops.push_back(catalogue.FindStop(name));
+    }
+
+    const auto stop_at = [&stops](uint32_t index) {
+        if (index >= stops.size()) {
+            throw FormatError("Stop index is out of range");
+        }
+        return stops[index];
+    };
+
+    const size_t distance_count = ReadSize(in);
+    for (size_t i = 0; i < distance_count; ++i) {
+        const auto* from = stop_at(ReadValue<uint32_t>(in));
+        const auto* to = stop_at(ReadValue<uint32_t>(in));
+        const int distance = ReadValue<int>(in);
+        if (distance < 0) {
+            throw FormatError("Negative distance between stops");
+        }
+        catalogue.SetDistance(from, to, distance);
+    }
+
+    const size_t bus_count = ReadSize(in);
+    for (size_t i = 0; i < bus_count; ++i) {
+        const std::string name = ReadString(in);
+        const bool is_round_trip = ReadValue<bool>(in);
+        std::vector<const transport_catalogue::Stop*> bus_stops;
+        // Длины маршрута справочник суммирует в int
+        int64_t forward_length = 0;
+        int64_t backward_length = 0;
+        for (const uint32_t index : ReadVector<uint32_t>(in)) {
+            bus_stops.push_back(stop_at(index));
+            if (bus_stops.size() > 1) {
+                forward_length += catalogue.GetDistance(bus_stops[bus_stops.size() - 2], bus_stops.back());
+                backward_length += catalogue.GetDistance(bus_stops.back(), bus_stops[bus_stops.size() - 2]);
+            }
+            if (forward_length + backward_length > std::numeric_limits<int>::max()) {
+                throw FormatError("Bus route is too long: " + name);
+            }
+        }
+        catalogue.AddBus(name, bus_stops, is_round_trip);
+    }
+
+    transport_catalogue::RoutingSettings routing_settings;
+    routing_settings.bus_wait_time = ReadValue<int>(in);
+    routing_settings.bus_velocity = ReadValue<double>(in);
+    routing_settings.use_geo_heuristic = ReadValue<bool>(in);
+    catalogue.SetRoutingSettings(routing_settings);
+}
+
+void SaveColor(std::ostream& out, const map_renderer::Color& color) {
+    WriteValue(out, static_cast<uint8_t>(color.index()));
+    if (const auto* name = std::get_if<std::string>(&color)) {
+        WriteString(out, *name);
+    } else if (const auto* rgb = std::get_if<svg::Rgb>(&color)) {
+        WriteValue(out, rgb->red);
+        WriteValue(out, rgb->green);
+        WriteValue(out, rgb->blue);
+    } else if (const auto* rgba = std::get_if<svg::Rgba>(&color)) {
+        // Поля пишутся по одному, чтобы в снимок не попадали байты выравнивания
+        WriteValue(out, rgba->red);
+        WriteValue(out, rgba->green);
+        WriteValue(out, rgba->blue);
+        WriteValue(out, rgba->opacity);
+    }
+}
+
+map_renderer::Color LoadColor(std::istream& in) {
+    switch (ReadValue<uint8_t>(in)) {
+        case 0: return std::monostate{};
+        case 1: return ReadString(in);
+        case 2: {
+            svg::Rgb rgb;
+            rgb.red = ReadValue<uint8_t>(in);
+            rgb.green = ReadValue<uint8_t>(in);
+            rgb.blue = ReadValue<uint8_t>(in);
+            return rgb;
+        }
+        case 3: {
+            svg::Rgba rgba;
+            rgba.red = ReadValue<uint8_t>(in);
+            rgba.green = ReadValue<uint8_t>(in);
+            rgba.blue = ReadValue<uint8_t>(in);
+            rgba.opacity = ReadValue<double>(in);
+            return rgba;
+        }
+        default: throw FormatError("Unknown color type");
+    }
+}
+
+void SaveRenderSettings(std::ostream& out, const map_renderer::RenderSettings& settings) {
+    WriteValue(out, settings.width);
+    WriteValue(out, settings.height);
+    WriteValue(out, settings.padding);
+    WriteValue(out, settings.line_width);
+    WriteValue(out, settings.stop_radius);
+    WriteValue(out, settings.bus_label_font_size);
+    WriteValue(out, settings.bus_label_offset);
+    WriteValue(out, settings.stop_label_font_size);
+    WriteValue(out, settings.stop_label_offset);
+    SaveColor(out, settings.underlayer_color);
+    WriteValue(out, settings.underlayer_width);
+    WriteSize(out, settings.color_palette.size());
+    for (const auto& color : settings.color_palette) {
+        SaveColor(out, color);
+    }
+    WriteValue(out, settings.render_stops);
+}
+
+map_renderer::RenderSettings LoadRenderSettings(std::istream& in) {
+    map_renderer::RenderSettings settings;
+    settings.width = ReadValue<double>(in);
+    settings.height = ReadValue<double>(in);
+    settings.padding = ReadValue<double>(in);
+    settings.line_width = ReadValue<double>(in);
+    settings.stop_radius = ReadValue<double>(in);
+    settings.bus_label_font_size = ReadValue<int>(in);
+    settings.bus_label_offset = ReadValue<std::array<double, 2>>(in);
+    settings.stop_label_font_size = ReadValue<int>(in);
+    settings.stop_label_offset = ReadValue<std::array<double, 2>>(in);
+    settings.underlayer_color = LoadColor(in);
+    settings.underlayer_width = ReadValue<double>(in);
+    const size_t color_count = ReadSize(in);
+    for (size_t i = 0; i < color_count; ++i) {
+        settings.color_palette.push_back(LoadColor(in));
+    }
+    settings.render_stops = ReadValue<bool>(in);
+    return settings;
+}
+
+} // namespace
+
+void SaveSnapshot(std::ostream& out,
+                  const transport_catalogue::TransportCatalogue& catalogue,
+                  const map_renderer::RenderSettings& render_settings,
+                  const transport::Router& router) {
+    out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    WriteValue(out, SNAPSHOT_VERSION);
+    SaveCatalogue(out, catalogue);
+    SaveRenderSettings(out, render_settings);
+    router.Serialize(out);
+    if (!out) {
+        throw std::runtime_error("Failed to write snapshot");
+    }
+}
+
+Snapshot LoadSnapshot(std::istream& in, transport_catalogue::TransportCatalogue& catalogue) {
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+        throw FormatError("Not a transport catalogue snapshot");
+    }
+    if (ReadValue<uint32_t>(in) != SNAPSHOT_VERSION) {
+        throw FormatError("Unsupported snapshot version");
+    }
+
+    LoadCatalogue(in, catalogue);
+    Snapshot snapshot;
+    snapshot.render_settings = LoadRenderSettings(in);
+    snapshot.router = transport::Router::Deserialize(in, catalogue);
+    return snapshot;
+}
+
+} // namespace serialization
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+
+// Двоичный снимок базы: справочник, настройки отрисовки и маршрутизации, построенный граф.
+// Пишется один раз режимом make_base и читается режимом process_requests
+namespace serialization {
+
+inline constexpr char SNAPSHOT_MAGIC[8] = {'T', 'C', 'S', 'N', 'A', 'P', '\0', '\0'};
+inline constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+struct Snapshot {
+    map_renderer::RenderSettings render_settings;
+    std::unique_ptr<transport::Router> router;
+};
+
+void SaveSnapshot(std::ostream& out,
+                  const transport_catalogue::TransportCatalogue& catalogue,
+                  const map_renderer::RenderSettings& render_settings,
+                  const transport::Router& router);
+
+// Заполняет пустой справочник и возвращает остальное содержимое снимка.
+// Бросает binary_io::FormatError для повреждённого файла или другой версии формата
+Snapshot LoadSnapshot(std::istream& in, transport_catalogue::TransportCatalogue& catalogue);
+
+} // namespace serialization
@@ -0,0 +1,140 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace transport_catalogue {
+
+namespace {
+
+constexpr double EARTH_RADIUS = 6371000; // Как в geo::ComputeDistance
+constexpr double DEGREE = M_PI / 180.0;
+
+bool CloserThan(const NearbyStop& lhs, const NearbyStop& rhs) {
+    return lhs.distance < rhs.distance;
+}
+
+}  // namespace
+
+StopSpatialIndex::StopSpatialIndex(const TransportCatalogue& catalogue) {
+    const auto& stops = catalogue.GetAllStops();
+    nodes_.reserve(stops.size());
+    for (const Stop& stop : stops) {
+        nodes_.push_back({stop.coordinates, &stop});
+        min_latitude_cos_ = std::min(min_latitude_cos_, std::cos(stop.coordinates.lat * DEGREE));
+    }
+    min_latitude_cos_ = std::max(min_latitude_cos_, 0.0);
+    Build(0, nodes_.size(), true);
+}
+
+void StopSpatialIndex::Build(size_t begin, size_t end, bool by_latitude) {
+    if (end - begin < 2) {
+        return;
+    }
+    // Середина отрезка - медиана по оси уровня: слева не больше её, справа не меньше
+    const size_t middle = begin + (end - begin) / 2;
+    std::nth_element(nodes_.begin() + begin, nodes_.begin() + middle, nodes_.begin() + end,
+        [by_latitude](const Node& lhs, const Node& rhs) {
+            return by_latitude ? lhs.coordinates.lat < rhs.coordinates.lat
+                               : lhs.coordinates.lng < rhs.coordinates.lng;
+        });
+    Build(begin, middle, !by_latitude);
+    Build(middle + 1, end, !by_latitude);
+}
+
+std::vector<NearbyStop> StopSpatialIndex::FindNearest(geo::Coordinates point, size_t count) const {
+    if (count == 0 || nodes_.empty()) {
+        return {};
+    }
+    count = std::min(count, nodes_.size());
+
+    // Для оценки по долготе берётся широта, где градус долготы короче всего
+    const double latitude_cos = std::min(min_latitude_cos_, std::max(std::cos(point.lat * DEGREE), 0.0));
+
+    // Нижняя граница расстояния до остановок по ту сторону разделяющей прямой
+    const auto min_distance_across = [&](double axis_difference, bool by_latitude) {
+        const double angle = std::min(std::abs(axis_difference), 180.0) * DEGREE;
+        if (by_latitude) {
+            return EARTH_RADIUS * angle;
+        }
+        return 2 * EARTH_RADIUS * std::asin(std::min(1.0, latitude_cos * std::sin(angle / 2)));
+    };
+
+    // Куча с самой дальней из найденных остановок наверху
+    std::priority_queue<NearbyStop, std::vector<NearbyStop>, decltype(&CloserThan)> found(&CloserThan);
+
+    const auto search = [&](const auto& self, size_t begin, size_t end, bool by_latitude) -> void {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const Node& node = nodes_[middle];
+
+        const double distance = geo::ComputeDistance(point, node.coordinates);
+        if (found.size() < count) {
+            found.push({node.stop, distance});
+        } else if (distance < found.top().distance) {
+            found.pop();
+            found.push({node.stop, distance});
+        }
+
+        const double difference = by_latitude ? point.lat - node.coordinates.lat : point.lng - node.coordinates.lng;
+        // Сначала сторона, где лежит сама точка, затем другая - если там может оказаться кто-то ближе
+        if (difference < 0) {
+            self(self, begin, middle, !by_latitude);
+        } else {
+            self(self, middle + 1, end, !by_latitude);
+        }
+        if (found.size() < count || min_distance_across(difference, by_latitude) < found.top().distance) {
+            if (difference < 0) {
+                self(self, middle + 1, end, !by_latitude);
+            } else {
+                self(self, begin, middle, !by_latitude);
+            }
+        }
+    };
+    search(search, 0, nodes_.size(), true);
+
+    std::vector<NearbyStop> result(found.size());
+    for (auto it = result.rbegin(); it != result.rend(); ++it) {
+        *it = found.top();
+        found.pop();
+    }
+    return result;
+}
+
+std::vector<const Stop*> StopSpatialIndex::FindInArea(geo::Coordinates min, geo::Coordinates max) const {
+    std::vector<const Stop*> result;
+
+    const auto search = [&](const auto& self, size_t begin, size_t end, bool by_latitude) -> void {
+        if (begin >= end) {
+            return;
+        }
+        const size_t middle = begin + (end - begin) / 2;
+        const Node& node = nodes_[middle];
+        const geo::Coordinates& coordinates = node.coordinates;
+
+        if (coordinates.lat >= min.lat && coordinates.lat <= max.lat
+            && coordinates.lng >= min.lng && coordinates.lng <= max.lng) {
+            result.push_back(node.stop);
+        }
+
+        const double value = by_latitude ? coordinates.lat : coordinates.lng;
+        if ((by_latitude ? min.lat : min.lng) <= value) {
+            self(self, begin, middle, !by_latitude);
+        }
+        if ((by_latitude ? max.lat : max.lng) >= value) {
+            self(self, middle + 1, end, !by_latitude);
+        }
+    };
+    search(search, 0, nodes_.size(), true);
+
+    std::sort(result.begin(), result.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->name < rhs->name;
+    });
+    return result;
+}
+
+}  // namespace transport_catalogue
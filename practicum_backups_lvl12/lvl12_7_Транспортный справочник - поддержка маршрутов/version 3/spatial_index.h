@@ -0,0 +1,46 @@
+#pragma once
+
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <vector>
+
+namespace transport_catalogue {
+
+struct NearbyStop {
+    const Stop* stop;
+    double distance; // Метры, как у geo::ComputeDistance
+};
+
+// Статическое k-d дерево по координатам всех остановок справочника. Узлы лежат в одном
+// массиве: корень отрезка [begin, end) - его середина, по чётным уровням дерево делится
+// по широте, по нечётным - по долготе. Строится за O(n log n); после изменения
+// справочника индекс нужно построить заново
+class StopSpatialIndex {
+public:
+    explicit StopSpatialIndex(const TransportCatalogue& catalogue);
+
+    // count ближайших к точке остановок по возрастанию расстояния
+    std::vector<NearbyStop> FindNearest(geo::Coordinates point, size_t count) const;
+
+    // Остановки внутри прямоугольника широт и долгот (границы включены), отсортированные по названию
+    std::vector<const Stop*> FindInArea(geo::Coordinates min, geo::Coordinates max) const;
+
+    size_t GetSize() const {
+        return nodes_.size();
+    }
+
+private:
+    struct Node {
+        geo::Coordinates coordinates;
+        const Stop* stop;
+    };
+
+    std::vector<Node> nodes_;
+    // Наименьший косинус широты среди остановок: по нему оценивается снизу расстояние по долготе
+    double min_latitude_cos_ = 1.0;
+
+    void Build(size_t begin, size_t end, bool by_latitude);
+};
+
+}  // namespace transport_catalogue
@@ -1,5 +1,8 @@
 #include "svg.h"
 
+#include <charconv>
+#include <iterator>
+
 namespace svg {
 
 std::ostream& operator<<(std::ostream& out, StrokeLineCap line_cap) {
@@ -22,10 +25,92 @@ std::ostream& operator<<(std::ostream& out, StrokeLineJoin line_join) {
     return out;
 }
 
+// ---------- BufferWriter ------------------
+
+BufferWriter& BufferWriter::operator<<(std::string_view text) {
+    buffer_.append(text);
+    return *this;
+}
+
+BufferWriter& BufferWriter::operator<<(const char* text) {
+    return *this << std::string_view(text);
+}
+
+BufferWriter& BufferWriter::operator<<(const std::string& text) {
+    return *this << std::string_view(text);
+}
+
+BufferWriter& BufferWriter::operator<<(char c) {
+    buffer_.push_back(c);
+    return *this;
+}
+
+BufferWriter& BufferWriter::operator<<(double value) {
+    // Шесть значащих цифр в формате %g - как у std::ostream по умолчанию
+    char digits[32];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), value, std::chars_format::general, 6);
+    buffer_.append(digits, result.ptr);
+    return *this;
+}
+
+BufferWriter& BufferWriter::operator<<(uint32_t value) {
+    char digits[16];
+    const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+    buffer_.append(digits, result.ptr);
+    return *this;
+}
+
+BufferWriter& BufferWriter::operator<<(const Color& color) {
+    std::visit([this](const auto& value) {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, std::monostate>) {
+            *this << "none";
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            *this << value;
+        } else if constexpr (std::is_same_v<T, Rgb>) {
+            *this << "rgb(" << uint32_t{value.red} << ',' << uint32_t{value.green} << ','
+                  << uint32_t{value.blue} << ')';
+        } else if constexpr (std::is_same_v<T, Rgba>) {
+            *this << "rgba(" << uint32_t{value.red} << ',' << uint32_t{value.green} << ','
+                  << uint32_t{value.blue} << ',' << value.opacity << ')';
+        }
+    }, color);
+    return *this;
+}
+
+BufferWriter& BufferWriter::operator<<(StrokeLineCap line_cap) {
+    switch (line_cap) {
+        case StrokeLineCap::BUTT: return *this << "butt";
+        case StrokeLineCap::ROUND: return *this << "round";
+        case StrokeLineCap::SQUARE: return *this << "square";
+    }
+    return *this;
+}
+
+BufferWriter& BufferWriter::operator<<(StrokeLineJoin line_join) {
+    switch (line_join) {
+        case StrokeLineJoin::ARCS: return *this << "arcs";
+        case StrokeLineJoin::BEVEL: return *this << "bevel";
+        case StrokeLineJoin::MITER: return *this << "miter";
+        case StrokeLineJoin::MITER_CLIP: return *this << "miter-clip";
+        case StrokeLineJoin::ROUND: return *this << "round";
+    }
+    return *this;
+}
+
+// ---------- Object ------------------
+
 void Object::Render(const RenderContext& context) const {
-    context.RenderIndent();
-    RenderObject(context);
-    context.out << std::endl;
+    std::string buffer;
+    BufferWriter writer(buffer);
+    Render(writer, context.indent);
+    context.out << buffer;
+}
+
+void Object::Render(BufferWriter& out, int indent) const {
+    out.Indent(indent);
+    RenderObject(out);
+    out << '\n';
 }
 
 // ---------- PathProps ------------------
@@ -55,7 +140,7 @@ PathProps_T& PathProps_T::SetStrokeLineJoin(StrokeLineJoin line_join) {
     return *this;
 }
 
-void PathProps_T::RenderAttrs(std::ostream& out) const {
+void PathProps_T::RenderAttrs(BufferWriter& out) const {
     if (fill_color_) {
         out << " fill=\"" << *fill_color_ << "\"";
     }
@@ -95,8 +180,7 @@ Circle& Circle::SetStrokeColor(Color color) {
     return *this;
 }
 
-void Circle::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
+void Circle::RenderObject(BufferWriter& out) const {
     out << "<circle cx=\"" << center_.x << "\" cy=\"" << center_.y << "\" r=\"" << radius_ << "\"";
     if (fill_color_) {
         out << " fill=\"" << *fill_color_ << "\"";
@@ -114,6 +198,11 @@ Polyline& Polyline::AddPoint(Point point) {
     return *this;
 }
 
+Polyline& Polyline::ClearPoints() {
+    points_.clear();
+    return *this;
+}
+
 Polyline& Polyline::SetFillColor(Color color) {
     PathProps_T::SetFillColor(std::move(color));
     return *this;
@@ -124,14 +213,13 @@ Polyline& Polyline::SetStrokeColor(Color color) {
     return *this;
 }
 
-void Polyline::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
+void Polyline::RenderObject(BufferWriter& out) const {
     out << "<polyline points=\"";
     for (size_t i = 0; i < points_.size(); ++i) {
         if (i > 0) {
-            out << " ";
+            out << ' ';
         }
-        out << points_[i].x << "," << points_[i].y;
+        out << points_[i].x << ',' << points_[i].y;
     }
     out << "\"";
     PathProps_T::RenderAttrs(out); // Добавляем атрибуты stroke-width, stroke-linecap и stroke-linejoin
@@ -175,13 +263,12 @@ Text& Text::SetFontWeight(std::string font_weight) {
     return *this;
 }
 
-Text& Text::SetData(std::string data) {
-    data_ = std::move(data);
+Text& Text::SetData(std::string_view data) {
+    data_.assign(data);
     return *this;
 }
 
-void Text::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
+void Text::RenderObject(BufferWriter& out) const {
     out << "<text";
 
     // Проверка и добавление fill
@@ -224,13 +311,15 @@ void Text::RenderObject(const RenderContext& context) const {
 // ---------- Document ------------------
 
 void Document::Render(std::ostream& out) const {
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n";
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n";
-    RenderContext context(out, 2);
+    // Документ собирается в одной строке и выводится в поток одной записью
+    std::string buffer;
+    BufferWriter writer(buffer);
+    writer << DOCUMENT_PROLOG;
     for (const auto& obj : objects_) {
-        obj->Render(context);
+        obj->Render(writer);
     }
-    out << "</svg>";
+    writer << DOCUMENT_EPILOG;
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 } // namespace svg
\ No newline at end of file
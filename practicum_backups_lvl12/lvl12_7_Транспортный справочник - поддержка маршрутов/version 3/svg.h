@@ -9,6 +9,7 @@
 #include <optional>
 #include <variant>
 #include <string>
+#include <string_view>
 #include <cstdint>
 
 namespace svg {
@@ -27,6 +28,14 @@ struct Rgba {
     double opacity = 1.0;
 };
 
+inline bool operator==(const Rgb& lhs, const Rgb& rhs) {
+    return lhs.red == rhs.red && lhs.green == rhs.green && lhs.blue == rhs.blue;
+}
+
+inline bool operator==(const Rgba& lhs, const Rgba& rhs) {
+    return lhs.red == rhs.red && lhs.green == rhs.green && lhs.blue == rhs.blue && lhs.opacity == rhs.opacity;
+}
+
 using Color = std::variant<std::monostate, std::string, Rgb, Rgba>;
 inline const Color NoneColor{std::monostate{}};
 
@@ -47,6 +56,37 @@ enum class StrokeLineJoin {
 std::ostream& operator<<(std::ostream& out, StrokeLineCap line_cap);
 std::ostream& operator<<(std::ostream& out, StrokeLineJoin line_join);
 
+// Начало и конец документа, как их выводит Document::Render
+inline constexpr std::string_view DOCUMENT_PROLOG =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n";
+inline constexpr std::string_view DOCUMENT_EPILOG = "</svg>";
+
+// Дописывает текст SVG в строку без промежуточных потоков. Числа и цвета
+// форматируются так же, как при выводе в std::ostream с настройками по умолчанию
+class BufferWriter {
+public:
+    explicit BufferWriter(std::string& buffer)
+        : buffer_(buffer) {
+    }
+
+    BufferWriter& operator<<(std::string_view text);
+    BufferWriter& operator<<(const char* text);
+    BufferWriter& operator<<(const std::string& text);
+    BufferWriter& operator<<(char c);
+    BufferWriter& operator<<(double value);
+    BufferWriter& operator<<(uint32_t value);
+    BufferWriter& operator<<(const Color& color);
+    BufferWriter& operator<<(StrokeLineCap line_cap);
+    BufferWriter& operator<<(StrokeLineJoin line_join);
+
+    void Indent(int count) {
+        buffer_.append(count, ' ');
+    }
+
+private:
+    std::string& buffer_;
+};
+
 inline std::ostream& operator<<(std::ostream& out, const Color& color) {
     std::visit([&out](const auto& value) {
         using T = std::decay_t<decltype(value)>;
@@ -75,7 +115,7 @@ public:
     PathProps_T& SetStrokeWidth(double width);
     PathProps_T& SetStrokeLineCap(StrokeLineCap line_cap);
     PathProps_T& SetStrokeLineJoin(StrokeLineJoin line_join);
-    void RenderAttrs(std::ostream& out) const;
+    void RenderAttrs(BufferWriter& out) const;
 
 protected:  // Изменено с private на protected
     std::optional<Color> fill_color_;
@@ -149,9 +189,11 @@ class Object {
 public:
     virtual ~Object() = default;
     void Render(const RenderContext& context) const;
+    // Отступ, элемент и перевод строки дописываются прямо в буфер
+    void Render(BufferWriter& out, int indent = 0) const;
 
 private:
-    virtual void RenderObject(const RenderContext& context) const = 0;
+    virtual void RenderObject(BufferWriter& out) const = 0;
 };
 
 class Circle final : public Object, public PathProps<Circle> {
@@ -163,7 +205,7 @@ public:
     Circle& SetStrokeColor(Color color);
 
 private:
-    void RenderObject(const RenderContext& context) const override;
+    void RenderObject(BufferWriter& out) const override;
 
     Point center_ = {0.0, 0.0};
     double radius_ = 1.0;
@@ -172,12 +214,14 @@ private:
 class Polyline final : public Object, public PathProps<Polyline> {
 public:
     Polyline& AddPoint(Point point);
+    // Удаляет точки, сохраняя выделенную под них память: ломаную можно заполнить заново
+    Polyline& ClearPoints();
 
     Polyline& SetFillColor(Color color);
     Polyline& SetStrokeColor(Color color);
 
 private:
-    void RenderObject(const RenderContext& context) const override;
+    void RenderObject(BufferWriter& out) const override;
 
     std::vector<Point> points_;
 };
@@ -189,13 +233,14 @@ public:
     Text& SetFontSize(uint32_t size);
     Text& SetFontFamily(std::string font_family);
     Text& SetFontWeight(std::string font_weight);
-    Text& SetData(std::string data);
+    // Строка копируется в уже выделенный буфер, так что надпись можно переиспользовать
+    Text& SetData(std::string_view data);
 
     Text& SetFillColor(Color color);
     Text& SetStrokeColor(Color color);
 
 private:
-    void RenderObject(const RenderContext& context) const override;
+    void RenderObject(BufferWriter& out) const override;
 
     Point position_ = {0.0, 0.0};
     Point offset_ = {0.0, 0.0};
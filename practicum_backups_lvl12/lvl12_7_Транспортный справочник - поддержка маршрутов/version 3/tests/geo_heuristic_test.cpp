@@ -0,0 +1,178 @@
+// Поиск A* ("use_geo_heuristic": true в routing_settings) против Дейкстры: на одной базе время
+// маршрутов для случайных пар остановок должно совпадать, в том числе после update_requests,
+// которые делают дороги короче прямой и меняют оценку A*. A* не должен трогать статистику
+// кэша деревьев путей. Код возврата 1 при любом расхождении.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. tests/geo_heuristic_test.cpp json_reader.cpp json_writer.cpp
+//       json.cpp json_sax.cpp map_renderer.cpp map_tiles.cpp spatial_index.cpp svg.cpp
+//       raptor_router.cpp transport_router.cpp transport_catalogue.cpp request_stats.cpp geo.cpp
+//       domain.cpp -o geo_heuristic_test
+
+#include "geo.h"
+#include "json.h"
+#include "json_reader.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int STOP_COUNT = 300;
+constexpr int BUS_COUNT = 40;
+
+geo::Coordinates GetStopCoordinates(int index) {
+    return {55.6 + index % 20 * 0.004, 37.5 + index / 20 * 0.004};
+}
+
+std::string StopName(int index) {
+    return "\"Stop " + std::to_string(index) + "\"";
+}
+
+// Дорога между остановками - прямая, умноженная на ratio
+int RoadDistance(int from, int to, double ratio) {
+    return static_cast<int>(std::ceil(geo::ComputeDistance(GetStopCoordinates(from), GetStopCoordinates(to)) * ratio));
+}
+
+std::string MakeStop(int index, const std::vector<std::pair<int, int>>& distances) {
+    const auto coordinates = GetStopCoordinates(index);
+    std::string stop = R"({"type": "Stop", "name": )" + StopName(index) + R"(, "latitude": )"
+                       + std::to_string(coordinates.lat) + R"(, "longitude": )" + std::to_string(coordinates.lng)
+                       + R"(, "road_distances": {)";
+    for (size_t i = 0; i < distances.size(); ++i) {
+        stop += (i > 0 ? ", " : "") + StopName(distances[i].first) + ": " + std::to_string(distances[i].second);
+    }
+    return stop + "}}";
+}
+
+std::string MakeBus(const std::string& name, const std::vector<int>& stops, bool is_roundtrip) {
+    std::string bus = R"({"type": "Bus", "name": ")" + name + R"(", "stops": [)";
+    for (size_t i = 0; i < stops.size(); ++i) {
+        bus += (i > 0 ? ", " : "") + StopName(stops[i]);
+    }
+    return bus + R"(], "is_roundtrip": )" + (is_roundtrip ? "true" : "false") + "}";
+}
+
+// Маршрут - случайное блуждание по соседним кварталам сетки 20 x 15
+std::vector<int> MakeRoute(std::mt19937& generator) {
+    std::uniform_int_distribution<int> start(0, STOP_COUNT - 1);
+    std::uniform_int_distribution<int> direction(0, 3);
+    constexpr int DX[] = {1, -1, 0, 0};
+    constexpr int DY[] = {0, 0, 1, -1};
+    std::vector<int> stops{start(generator)};
+    while (stops.size() < 12) {
+        const int d = direction(generator);
+        const int next_x = stops.back() % 20 + DX[d];
+        const int next_y = stops.back() / 20 + DY[d];
+        if (next_x >= 0 && next_x < 20 && next_y >= 0 && next_y < STOP_COUNT / 20) {
+            stops.push_back(next_y * 20 + next_x);
+        }
+    }
+    return stops;
+}
+
+struct Base {
+    std::string base_requests;
+    std::string update_requests;
+};
+
+Base MakeBase() {
+    std::mt19937 generator(23);
+    std::uniform_real_distribution<double> ratio(1.1, 1.5);
+    std::vector<std::vector<int>> routes;
+    std::vector<std::vector<std::pair<int, int>>> distances(STOP_COUNT);
+    for (int bus = 0; bus < BUS_COUNT; ++bus) {
+        routes.push_back(MakeRoute(generator));
+        const auto& stops = routes.back();
+        for (size_t i = 1; i < stops.size(); ++i) {
+            distances[stops[i - 1]].emplace_back(stops[i], RoadDistance(stops[i - 1], stops[i], ratio(generator)));
+        }
+    }
+
+    Base base;
+    base.base_requests = "[";
+    for (int stop = 0; stop < STOP_COUNT; ++stop) {
+        base.base_requests += MakeStop(stop, distances[stop]) + ", ";
+    }
+    for (int bus = 0; bus < BUS_COUNT; ++bus) {
+        base.base_requests += MakeBus(std::to_string(bus), routes[bus], bus % 3 == 0) + (bus + 1 < BUS_COUNT ? ", " : "]");
+    }
+
+    // Дороги во много раз короче прямой уменьшают допустимую оценку A*: со старой оценкой
+    // поиск обходил бы эти маршруты, поэтому после правок она строится заново
+    base.update_requests = "[";
+    for (int bus = 0; bus < 10; ++bus) {
+        const auto& stops = routes[bus];
+        for (size_t i = 1; i < stops.size(); ++i) {
+            base.update_requests += R"({"type": "Distance", "from": )" + StopName(stops[i - 1]) + R"(, "to": )"
+                                    + StopName(stops[i]) + R"(, "distance": )"
+                                    + std::to_string(RoadDistance(stops[i - 1], stops[i], 0.05)) + "}, ";
+        }
+    }
+    const auto new_route = MakeRoute(generator);
+    for (size_t i = 1; i < new_route.size(); ++i) {
+        base.update_requests += MakeStop(new_route[i - 1], {{new_route[i], RoadDistance(new_route[i - 1], new_route[i], 0.7)}})
+                                + ", ";
+    }
+    base.update_requests += MakeBus("1", new_route, false) + ", ";
+    base.update_requests += R"({"type": "RemoveBus", "name": "2"}, )";
+    base.update_requests += R"({"type": "RoutingSettings", "bus_wait_time": 4}])";
+    return base;
+}
+
+struct Reader {
+    transport_catalogue::TransportCatalogue catalogue;
+    json_reader::JsonReader reader{catalogue};
+
+    Reader(const Base& base, bool use_geo_heuristic) {
+        reader.LoadData(json::LoadJSON(R"({"base_requests": )" + base.base_requests + "}").GetRoot());
+        reader.LoadRoutingSettings(json::LoadJSON(std::string(R"({"bus_wait_time": 6, "bus_velocity": 40, )")
+                                                  + R"("use_geo_heuristic": )"
+                                                  + (use_geo_heuristic ? "true" : "false") + "}")
+                                       .GetRoot());
+    }
+};
+
+int CompareRoutes(const std::string& stage, Reader& dijkstra, Reader& a_star) {
+    std::mt19937 generator(24);
+    std::uniform_int_distribution<int> stop(0, STOP_COUNT - 1);
+    int failures = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const std::string from = "Stop " + std::to_string(stop(generator));
+        const std::string to = "Stop " + std::to_string(stop(generator));
+        const auto expected = dijkstra.reader.GetRouter().GetRouteInfo(from, to);
+        const auto actual = a_star.reader.GetRouter().GetRouteInfo(from, to);
+        if (expected.has_value() != actual.has_value()
+            || (expected && std::abs(expected->total_time - actual->total_time) > 1e-9)) {
+            std::cerr << stage << ": " << from << " -> " << to << " differs\n";
+            ++failures;
+        }
+    }
+    const auto cache_stats = a_star.reader.GetRouter().GetCacheStats();
+    if (cache_stats.hits != 0 || cache_stats.misses != 0) {
+        std::cerr << stage << ": A* touched the route cache statistics\n";
+        ++failures;
+    }
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    const Base base = MakeBase();
+    Reader dijkstra(base, false);
+    Reader a_star(base, true);
+
+    int failures = CompareRoutes("base", dijkstra, a_star);
+    const json::Document updates = json::LoadJSON(base.update_requests);
+    dijkstra.reader.ApplyUpdates(updates.GetRoot());
+    a_star.reader.ApplyUpdates(updates.GetRoot());
+    failures += CompareRoutes("after updates", dijkstra, a_star);
+
+    std::cout << (failures == 0 ? "OK" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+// Режим serve на повреждённых запросах: каждая строка ввода получает ровно одну строку ответа,
+// ошибка в одном запросе не задевает соседние и не роняет сервер. Reload посреди длинного
+// потока запросов делит ответы ровно по своему месту во вводе. Проверяется с одним потоком
+// и с несколькими. Код возврата 1, если какой-то ответ не совпал с ожидаемым.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. tests/query_server_test.cpp query_server.cpp json_reader.cpp
+//       json_writer.cpp json.cpp json_sax.cpp serialization.cpp map_renderer.cpp map_tiles.cpp
+//       spatial_index.cpp svg.cpp raptor_router.cpp transport_router.cpp transport_catalogue.cpp
+//       request_stats.cpp geo.cpp domain.cpp -o query_server_test
+
+#include "query_server.h"
+#include "serialization.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Во втором снимке есть остановка C с маршрутом 2, в первом её нет. Ещё тысячи остановок
+// второго снимка нужны, чтобы его загрузка занимала заметное время
+void WriteSnapshot(const std::string& file, bool with_stop_c = false) {
+    transport_catalogue::TransportCatalogue catalogue;
+    catalogue.AddStop("A", {55.60, 37.60});
+    catalogue.AddStop("B", {55.61, 37.61});
+    const auto* a = catalogue.FindStop("A");
+    const auto* b = catalogue.FindStop("B");
+    catalogue.SetDistance(a, b, 1000);
+    catalogue.AddBus("1", {a, b}, false);
+    if (with_stop_c) {
+        catalogue.AddStop("C", {55.62, 37.62});
+        const auto* c = catalogue.FindStop("C");
+        catalogue.SetDistance(b, c, 1000);
+        catalogue.AddBus("2", {b, c}, false);
+        std::vector<const transport_catalogue::Stop*> stops;
+        for (int i = 0; i < 3000; ++i) {
+            const std::string name = "Filler " + std::to_string(i);
+            catalogue.AddStop(name, {55.5 + i % 50 * 0.002, 37.5 + i / 50 * 0.002});
+            stops.push_back(catalogue.FindStop(name));
+            if (i > 0) {
+                catalogue.SetDistance(stops[i - 1], stops[i], 500);
+            }
+        }
+        catalogue.AddBus("Filler", stops, false);
+    }
+
+    const transport::Router router(transport::RouterSettings{6, 40.0}, catalogue);
+    std::ofstream out(file, std::ios::binary);
+    serialization::SaveSnapshot(out, catalogue, map_renderer::RenderSettings{}, router);
+}
+
+// Запрос и ожидаемый ответ; пустая строка запроса ответа не получает
+const std::vector<std::pair<std::string, std::string>> CASES = {
+    {R"({"id": "x", "type": "Reload"})", R"({"error_message":"invalid request id"})"},
+    {R"({"id": "x", "type": "Stats"})", R"({"error_message":"invalid request id"})"},
+    {R"({"id": 1, "type": "Stop", "name": 5})", R"({"error_message":"Not a string","request_id":1})"},
+    {R"({"id": "q", "type": "Bus", "name": "1"})", R"({"error_message":"unknown request"})"},
+    {R"({"type": "Bus", "name": "1"})", R"({"error_message":"unknown request"})"},
+    {R"({"id": 2, "type": "Route", "from": "A"})", R"({"error_message":"map::at","request_id":2})"},
+    {"not json", R"({"error_message":"invalid request"})"},
+    {"[1, 2]", R"({"error_message":"unknown request"})"},
+    {"   ", ""},
+    {R"({"id": 3, "type": "Stop", "name": "A"})", R"({"buses":["1"],"request_id":3})"},
+    {R"({"id": 4, "type": "Reload"})", R"({"request_id":4,"status":"reloaded"})"},
+    {R"({"id": 5, "type": "Bus", "name": "nope"})", R"({"error_message":"not found","request_id":5})"},
+};
+
+// Ответы server на input, по строке
+std::vector<std::string> Serve(query_server::QueryServer& server, const std::string& input) {
+    std::istringstream in(input);
+    std::ostringstream out;
+    server.Serve(in, out);
+    std::istringstream responses(out.str());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(responses, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+int CompareResponses(size_t thread_count, const std::vector<std::string>& expected,
+                     const std::vector<std::string>& actual) {
+    int failures = 0;
+    for (size_t i = 0; i < std::max(expected.size(), actual.size()); ++i) {
+        const std::string expected_line = i < expected.size() ? expected[i] : "<none>";
+        const std::string actual_line = i < actual.size() ? actual[i] : "<none>";
+        if (expected_line != actual_line) {
+            std::cerr << "threads=" << thread_count << " response " << i << ": expected " << expected_line
+                      << ", got " << actual_line << "\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+// Запросы до Reload отвечают по старому снимку, после - по новому, даже если их пачки
+// обрабатываются одновременно
+int TestReloadInStream(const std::string& old_file, const std::string& new_file, size_t thread_count) {
+    constexpr int REQUESTS_AROUND = 3000;
+    std::string input;
+    std::vector<std::string> expected;
+    for (int id = 0; id < REQUESTS_AROUND; ++id) {
+        input += R"({"id": )" + std::to_string(id) + R"(, "type": "Stop", "name": "C"})" + "\n";
+        expected.push_back(R"({"error_message":"not found","request_id":)" + std::to_string(id) + "}");
+    }
+    input += R"({"id": -1, "type": "Reload", "file": ")" + new_file + "\"}\n";
+    expected.push_back(R"({"request_id":-1,"status":"reloaded"})");
+    for (int id = REQUESTS_AROUND; id < 2 * REQUESTS_AROUND; ++id) {
+        input += R"({"id": )" + std::to_string(id) + R"(, "type": "Stop", "name": "C"})" + "\n";
+        expected.push_back(R"({"buses":["2"],"request_id":)" + std::to_string(id) + "}");
+    }
+
+    query_server::QueryServer server({old_file, "", thread_count});
+    return CompareResponses(thread_count, expected, Serve(server, input));
+}
+
+} // namespace
+
+int main() {
+    const std::string snapshot_file = "query_server_test.bin";
+    const std::string reloaded_file = "query_server_test_reloaded.bin";
+    WriteSnapshot(snapshot_file);
+    WriteSnapshot(reloaded_file, true);
+
+    std::string input;
+    std::vector<std::string> expected;
+    // Несколько повторов, чтобы при нескольких потоках запросы попали в разные пачки
+    for (int round = 0; round < 50; ++round) {
+        for (const auto& [request, response] : CASES) {
+            input += request + "\n";
+            if (!response.empty()) {
+                expected.push_back(response);
+            }
+        }
+    }
+
+    int failures = 0;
+    // Несколько потоков и на одноядерной машине, чтобы пачки шли одновременно
+    for (const size_t thread_count : {size_t{1}, size_t{0}, size_t{4}}) {
+        query_server::QueryServer server({snapshot_file, "", thread_count});
+        failures += CompareResponses(thread_count, expected, Serve(server, input));
+        failures += TestReloadInStream(snapshot_file, reloaded_file, thread_count);
+    }
+    std::remove(snapshot_file.c_str());
+    std::remove(reloaded_file.c_str());
+
+    std::cout << (failures == 0 ? "OK" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
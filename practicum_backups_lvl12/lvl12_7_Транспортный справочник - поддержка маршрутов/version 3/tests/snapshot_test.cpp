@@ -0,0 +1,115 @@
+// Чтение повреждённого снимка: каждый байт по очереди портится несколькими значениями, снимок
+// обрезается на каждой длине, плюс случайные многобайтовые порчи. Чтение должно либо бросить
+// binary_io::FormatError, либо дать роутер, на котором поиск маршрутов не выходит за границы.
+// Имеет смысл собирать и с -fsanitize=address,undefined. Код возврата 1, если неповреждённый
+// снимок не читается или чтение бросило что-то кроме FormatError.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. tests/snapshot_test.cpp serialization.cpp map_renderer.cpp
+//       map_tiles.cpp spatial_index.cpp svg.cpp transport_router.cpp transport_catalogue.cpp
+//       geo.cpp domain.cpp -o snapshot_test
+
+#include "binary_io.h"
+#include "serialization.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <exception>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string MakeSnapshot() {
+    transport_catalogue::TransportCatalogue catalogue;
+    catalogue.AddStop("A", {55.60, 37.60});
+    catalogue.AddStop("B", {55.61, 37.61});
+    catalogue.AddStop("C", {55.62, 37.60});
+    catalogue.AddStop("D", {55.63, 37.62});
+    const auto* a = catalogue.FindStop("A");
+    const auto* b = catalogue.FindStop("B");
+    const auto* c = catalogue.FindStop("C");
+    const auto* d = catalogue.FindStop("D");
+    catalogue.SetDistance(a, b, 1000);
+    catalogue.SetDistance(b, c, 1500);
+    catalogue.SetDistance(c, d, 800);
+    catalogue.SetDistance(b, d, 3000);
+    catalogue.AddBus("1", {a, b, c}, false);
+    catalogue.AddBus("2", {b, d, b}, true);
+
+    map_renderer::RenderSettings render_settings;
+    render_settings.color_palette = {svg::Color{"green"}, svg::Color{svg::Rgb{255, 160, 0}}};
+    const transport::Router router(transport::RouterSettings{6, 40.0}, catalogue);
+    std::ostringstream out;
+    serialization::SaveSnapshot(out, catalogue, render_settings, router);
+    return out.str();
+}
+
+enum class LoadResult { LOADED, REJECTED, CRASHED };
+
+// Прочитанный снимок сразу используется: порча, прошедшая проверки, не должна ломать поиск
+LoadResult LoadAndQuery(const std::string& data) {
+    try {
+        std::istringstream in(data);
+        transport_catalogue::TransportCatalogue catalogue;
+        const auto snapshot = serialization::LoadSnapshot(in, catalogue);
+        for (const auto* from : catalogue.GetSortedAllStops()) {
+            for (const auto* to : catalogue.GetSortedAllStops()) {
+                snapshot.router->GetRouteInfo(from->name, to->name);
+            }
+        }
+        return LoadResult::LOADED;
+    } catch (const binary_io::FormatError&) {
+        return LoadResult::REJECTED;
+    } catch (const std::exception& e) {
+        std::cerr << "unexpected exception: " << e.what() << "\n";
+        return LoadResult::CRASHED;
+    }
+}
+
+} // namespace
+
+int main() {
+    const std::string snapshot = MakeSnapshot();
+    if (LoadAndQuery(snapshot) != LoadResult::LOADED) {
+        std::cerr << "intact snapshot was not loaded\n";
+        std::cout << "FAILED" << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    size_t loaded = 0;
+    size_t rejected = 0;
+    const auto check = [&](const std::string& data) {
+        switch (LoadAndQuery(data)) {
+            case LoadResult::LOADED: ++loaded; break;
+            case LoadResult::REJECTED: ++rejected; break;
+            case LoadResult::CRASHED: ++failures; break;
+        }
+    };
+
+    for (size_t pos = 0; pos < snapshot.size(); ++pos) {
+        for (const int value : {0x00, 0x01, 0x7F, 0x80, 0xFF}) {
+            std::string data = snapshot;
+            data[pos] = static_cast<char>(value);
+            check(data);
+        }
+        check(snapshot.substr(0, pos));
+    }
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<size_t> position(0, snapshot.size() - 1);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int round = 0; round < 20000; ++round) {
+        std::string data = snapshot;
+        for (int i = 0; i < 4; ++i) {
+            data[position(generator)] = static_cast<char>(byte(generator));
+        }
+        check(data);
+    }
+
+    std::cout << "loaded: " << loaded << ", rejected: " << rejected << "\n";
+    std::cout << (failures == 0 ? "OK" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
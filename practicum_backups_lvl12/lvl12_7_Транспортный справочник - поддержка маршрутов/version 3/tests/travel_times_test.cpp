@@ -0,0 +1,94 @@
+// Матрица ComputeTravelTimes против GetRouteInfo: каждая клетка таблицы должна совпадать со
+// временем отдельного маршрута. Среди источников есть остановки, добавленные правкой графа
+// (Router::AddStop), в том числе не связанная ни с чем. Проверяется с одним потоком и с
+// несколькими. Код возврата 1 при любом расхождении.
+// Сборка из каталога version 3:
+//   g++ -std=c++17 -O2 -pthread -I. tests/travel_times_test.cpp transport_router.cpp
+//       transport_catalogue.cpp geo.cpp domain.cpp -o travel_times_test
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+int main() {
+    constexpr size_t STOP_COUNT = 200;
+    constexpr size_t BUS_COUNT = 30;
+    std::mt19937 generator(18);
+    std::uniform_int_distribution<size_t> stop_index(0, STOP_COUNT - 1);
+    std::uniform_int_distribution<int> distance(300, 3000);
+
+    transport_catalogue::TransportCatalogue catalogue;
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i), {55.5 + i % 20 * 0.005, 37.3 + i / 20 * 0.005});
+    }
+    for (size_t i = 0; i < BUS_COUNT; ++i) {
+        std::vector<const transport_catalogue::Stop*> stops(10);
+        for (auto& stop : stops) {
+            stop = &catalogue.GetAllStops()[stop_index(generator)];
+        }
+        for (size_t j = 1; j < stops.size(); ++j) {
+            catalogue.SetDistance(stops[j - 1], stops[j], distance(generator));
+        }
+        catalogue.AddBus("Bus " + std::to_string(i), stops, i % 2 == 0);
+    }
+    transport::Router router(transport::RouterSettings{6, 40.0}, catalogue);
+
+    // Новые остановки получают вершины в конце графа, а в таблице стоят по имени
+    catalogue.AddStop("Added 1", {55.55, 37.35});
+    catalogue.AddStop("Added 2", {55.56, 37.36});
+    catalogue.AddStop("Added lonely", {55.57, 37.37});
+    const auto* added_1 = catalogue.FindStop("Added 1");
+    const auto* added_2 = catalogue.FindStop("Added 2");
+    const auto* old_stop = &catalogue.GetAllStops()[0];
+    catalogue.SetDistance(added_1, added_2, 1200);
+    catalogue.SetDistance(added_2, old_stop, 800);
+    catalogue.AddBus("Added bus", {added_1, added_2, old_stop}, false);
+    router.AddStop(*catalogue.FindStop("Added lonely"));
+    router.AddBus(catalogue, "Added bus");
+    router.RefreshHeuristic(catalogue);
+
+    const std::vector<std::string_view> sources = {"Stop 0", "Stop 57", "Stop 199", "Added 1", "Added 2",
+                                                   "Added lonely", "Stop 57"};
+
+    std::vector<std::string> expected_stops_to;
+    for (const auto& stop : catalogue.GetAllStops()) {
+        expected_stops_to.push_back(stop.name);
+    }
+    std::sort(expected_stops_to.begin(), expected_stops_to.end());
+
+    int failures = 0;
+    for (const size_t thread_count : {size_t{1}, size_t{3}}) {
+        const auto table = router.ComputeTravelTimes(sources, thread_count);
+        if (table.stops_to != expected_stops_to || table.stops_from.size() != sources.size()
+            || table.times.size() != sources.size() * expected_stops_to.size()) {
+            std::cerr << "threads=" << thread_count << ": wrong table shape\n";
+            ++failures;
+            continue;
+        }
+        for (size_t i = 0; i < sources.size(); ++i) {
+            if (table.stops_from[i] != sources[i]) {
+                std::cerr << "threads=" << thread_count << ": row " << i << " is " << table.stops_from[i] << "\n";
+                ++failures;
+            }
+            for (size_t j = 0; j < table.stops_to.size(); ++j) {
+                const auto time = table.GetTime(i, j);
+                const auto route = router.GetRouteInfo(sources[i], table.stops_to[j]);
+                if (time.has_value() != route.has_value() || (time && std::abs(*time - route->total_time) > 1e-9)) {
+                    std::cerr << "threads=" << thread_count << ": " << sources[i] << " -> " << table.stops_to[j]
+                              << " differs from GetRouteInfo\n";
+                    ++failures;
+                }
+            }
+        }
+    }
+
+    std::cout << (failures == 0 ? "OK" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include "transport_catalogue.h"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <cmath> // Для std::round
@@ -6,31 +7,82 @@
 namespace transport_catalogue {
 
 void TransportCatalogue::AddStop(const std::string& name, const geo::Coordinates& coordinates) {
+    ++version_;
     // Проверяем, существует ли уже запись в stops_map_
     auto it = stops_map_.find(name);
     if (it != stops_map_.end()) {
         // Если запись с таким именем уже существует, обновляем соответствующий объект Stop
         const Stop* existing_stop = it->second; // Получаем указатель на уже существующий объект Stop
         const_cast<Stop*>(existing_stop)->coordinates = coordinates;
+        stop_coordinates_[existing_stop->id] = coordinates;
+        // Географическая длина проходящих через остановку маршрутов изменилась
+        RefreshBusesAtStop(existing_stop);
     } else {
         // Если записи не существует, добавляем новый объект Stop и обновляем карту
-        stops_.emplace_back(Stop{name, coordinates}); // Добавляем в дек
-        stops_map_[name] = &stops_.back(); // Обновляем мапу, устанавливая ссылку на только что добавленный элемент
+        stops_.emplace_back(Stop{name, coordinates, static_cast<uint32_t>(stops_.size())}); // Добавляем в дек
+        stops_map_[stops_.back().name] = &stops_.back(); // Обновляем мапу, устанавливая ссылку на только что добавленный элемент
+        stop_coordinates_.push_back(coordinates);
+        stop_to_buses_.emplace_back();
+        InvalidateSortedIndex();
     }
 }
 
 void TransportCatalogue::AddBus(const std::string& name, const std::vector<const Stop*>& stops, bool is_round_trip) {
-    buses_.emplace_back(Bus{name, stops, is_round_trip});
-    buses_map_[name] = &buses_.back(); // Используем name
+    ++version_;
+    buses_.emplace_back(Bus{name, stops, is_round_trip, {}, {}, {}, static_cast<uint32_t>(buses_.size())});
+    ComputeBusDistances(buses_.back());
+    ComputeBusStats(buses_.back());
+    buses_map_[buses_.back().name] = &buses_.back(); // Ключ - имя внутри дека
 
     for (const auto* stop : stops) {
-        stop_to_buses_map_[stop].insert(&buses_.back()); // Используем указатели
+        auto& stop_buses = stop_to_buses_[stop->id];
+        // Маршрут может проходить через остановку несколько раз, запоминаем его один раз
+        if (stop_buses.empty() || stop_buses.back() != &buses_.back()) {
+            stop_buses.push_back(&buses_.back());
+        }
+    }
+    InvalidateSortedIndex();
+}
+
+bool TransportCatalogue::RemoveBus(std::string_view name) {
+    const auto it = buses_map_.find(name);
+    if (it == buses_map_.end()) {
+        return false;
+    }
+    ++version_;
+    Bus* removed = const_cast<Bus*>(it->second);
+    buses_map_.erase(it);
+    for (const auto* stop : removed->stops) {
+        auto& stop_buses = stop_to_buses_[stop->id];
+        stop_buses.erase(std::remove(stop_buses.begin(), stop_buses.end(), removed), stop_buses.end());
+    }
+
+    // Переносим последний маршрут на освободившееся место
+    Bus* last = &buses_.back();
+    if (removed != last) {
+        buses_map_.erase(last->name);
+        for (const auto* stop : last->stops) {
+            auto& stop_buses = stop_to_buses_[stop->id];
+            std::replace(stop_buses.begin(), stop_buses.end(), static_cast<const Bus*>(last),
+                         static_cast<const Bus*>(removed));
+        }
+        const uint32_t id = removed->id;
+        *removed = std::move(*last);
+        removed->id = id;
+        buses_map_[removed->name] = removed;
     }
+    buses_.pop_back();
+    InvalidateSortedIndex();
+    return true;
 }
     
 void TransportCatalogue::SetDistance(const Stop* from, const Stop* to, int distance) {
     if (from != nullptr && to != nullptr) {
+        ++version_;
         between_stops_distance_[{from, to}] = distance; // Добавляем расстояние в мапу
+
+        // Пересчитываем расстояния и статистику маршрутов, уже проходящих через остановку
+        RefreshBusesAtStop(from);
     }
     //else std::cout << "\n Error SetDistance \n";// Сюда попадать не должны
 }
@@ -48,89 +100,117 @@ int TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
     return 0;
 }
 
-const Bus* TransportCatalogue::FindBus(const std::string& name) const {
+const std::unordered_map<std::pair<const Stop*, const Stop*>, int, CustomHash>& TransportCatalogue::GetAllDistances() const {
+    return between_stops_distance_;
+}
+
+void TransportCatalogue::ComputeBusDistances(Bus& bus) const {
+    const size_t stops_count = bus.stops.size();
+    bus.forward_distances.assign(stops_count, 0);
+    bus.backward_distances.assign(stops_count, 0);
+    for (size_t k = 1; k < stops_count; ++k) {
+        bus.forward_distances[k] = bus.forward_distances[k - 1] + GetDistance(bus.stops[k - 1], bus.stops[k]);
+        bus.backward_distances[k] = bus.backward_distances[k - 1] + GetDistance(bus.stops[k], bus.stops[k - 1]);
+    }
+}
+
+const Bus* TransportCatalogue::FindBus(std::string_view name) const {
     auto it = buses_map_.find(name);
     return it != buses_map_.end() ? it->second : nullptr;
 }
 
-const Stop* TransportCatalogue::FindStop(const std::string& name) const {
+const Stop* TransportCatalogue::FindStop(std::string_view name) const {
     auto it = stops_map_.find(name);
     return it != stops_map_.end() ? it->second : nullptr;
 }
 
-BusInfo TransportCatalogue::GetBusInfo(const std::string& name, int request_id) const {
+BusInfo TransportCatalogue::GetBusInfo(std::string_view name, int request_id) const {
     const Bus* bus = FindBus(name); // Используем FindBus для поиска автобуса
     if (bus) {
-        BusInfo bus_info;
-        bus_info.request_id = request_id; // Устанавливаем request_id
-        // Количество остановок
-        bus_info.stop_count = bus->is_round_trip ? static_cast<int>(bus->stops.size()) : static_cast<int>(bus->stops.size() * 2 - 1);
-
-        // Подсчет уникальных остановок без копирования
-        std::unordered_map<std::string, int> stop_counter;
-        for (const auto& stop : bus->stops) {
-            stop_counter[stop->name]++;
+        // Статистика посчитана заранее, запрос только копирует её
+        const BusStats& stats = bus->stats;
+        return BusInfo{stats.stop_count, stats.unique_stop_count, stats.route_length, stats.curvature, request_id};
+    }
+    return BusInfo{}; // Если автобус не найден
+}
+
+void TransportCatalogue::ComputeBusStats(Bus& bus) const {
+    BusStats stats;
+    if (bus.stops.empty()) {
+        bus.stats = stats;
+        return;
+    }
+
+    // Количество остановок
+    stats.stop_count = bus.is_round_trip ? static_cast<int>(bus.stops.size()) : static_cast<int>(bus.stops.size() * 2 - 1);
+
+    // Подсчет уникальных остановок без копирования
+    std::unordered_set<const Stop*> unique_stops(bus.stops.begin(), bus.stops.end());
+    stats.unique_stop_count = static_cast<int>(unique_stops.size());
+
+    // Длина маршрута
+    double route_length = 0.0;
+    double geographical_distance = 0.0; 
+
+    // Вектор для хранения развернутого маршрута
+    std::vector<const Stop*> expanded_stops = bus.stops;
+    if (!bus.is_round_trip) {
+        // Добавляем остановки в обратном порядке
+        for (size_t i = bus.stops.size() - 1; i > 0; --i) {
+            expanded_stops.push_back(bus.stops[i - 1]);
         }
-        bus_info.unique_stop_count = static_cast<int>(stop_counter.size());
-
-        // Длина маршрута
-        double route_length = 0.0;
-        double geographical_distance = 0.0; 
-
-        // Вектор для хранения развернутого маршрута
-        std::vector<const Stop*> expanded_stops= bus->stops;        
-        if (!bus->is_round_trip) {
-            // Добавляем остановки в обратном порядке
-            for (size_t i = bus->stops.size()-1; i > 0; --i) {
-            expanded_stops.push_back(bus->stops[i - 1]);
-            }
+    }
+    
+    // Теперь у нас есть развернутый маршрут в expanded_stops
+    for (size_t i = 0; i + 1 < expanded_stops.size(); i++) {
+        const auto& from_stop = expanded_stops[i];
+        const auto& to_stop = expanded_stops[i + 1];
+
+        // Получаем расстояние от текущей остановки до следующей
+        auto it = between_stops_distance_.find({from_stop, to_stop});
+        auto reverse_it = between_stops_distance_.find({to_stop, from_stop});
+
+        if (it != between_stops_distance_.end() && it->second > 0) {
+            route_length += it->second; // Добавляем расстояние
+        } else if (reverse_it != between_stops_distance_.end() && reverse_it->second > 0) {
+            route_length += reverse_it->second; // Добавляем расстояние в обратном направлении
         }
         
-        // Теперь у нас есть развернутый маршрут в expanded_stops
-        for (size_t i = 0; i < expanded_stops.size() - 1; i++) {
-            const auto& from_stop = expanded_stops[i];
-            const auto& to_stop = expanded_stops[i + 1];
-
-            // Получаем расстояние от текущей остановки до следующей
-            auto it = between_stops_distance_.find({from_stop, to_stop});
-            auto reverse_it = between_stops_distance_.find({to_stop, from_stop});
-
-            if (it != between_stops_distance_.end() && it->second > 0) {
-                route_length += it->second; // Добавляем расстояние
-            } else if (reverse_it != between_stops_distance_.end() && reverse_it->second > 0) {
-                route_length += reverse_it->second; // Добавляем расстояние в обратном направлении
-            }
-            
-            // Добавляем географическое расстояние
-            geographical_distance += ComputeDistance(from_stop->coordinates, to_stop->coordinates);
-        }
+        // Добавляем географическое расстояние
+        geographical_distance += ComputeDistance(from_stop->coordinates, to_stop->coordinates);
+    }
 
-        // Устанавливаем общую длину маршрута
-        bus_info.route_length = route_length;
+    // Устанавливаем общую длину маршрута
+    stats.route_length = route_length;
 
-        // Вычисляем коэффициент извилистости (C)
-        if (geographical_distance > 0.0) {
-            bus_info.curvature = route_length / geographical_distance; // C = L / D
-        } else {
-            bus_info.curvature = 1.0L; // Если географическое расстояние равно 0, устанавливаем извилистость в 1
-        }
-           
-        return bus_info; // Возвращаем уникальный указатель
+    // Вычисляем коэффициент извилистости (C)
+    if (geographical_distance > 0.0) {
+        stats.curvature = route_length / geographical_distance; // C = L / D
+    } else {
+        stats.curvature = 1.0; // Если географическое расстояние равно 0, устанавливаем извилистость в 1
     }
-    return BusInfo{}; // Если автобус не найден
+    bus.stats = stats;
 }
 
-const std::unordered_set<const Bus*, CustomHash>& TransportCatalogue::GetBusesByStop(const std::string& stop_name) const {
-    auto stop_it = stops_map_.find(stop_name); // Используем stop_name
-    if (stop_it != stops_map_.end()) {
-        const Stop* stop = stop_it->second;
-        auto bus_it = stop_to_buses_map_.find(stop);
-        if (bus_it != stop_to_buses_map_.end()) {
-            return bus_it->second;
-        }
+void TransportCatalogue::RefreshBusesAtStop(const Stop* stop) {
+    for (const Bus* bus : stop_to_buses_[stop->id]) {
+        Bus& mutable_bus = const_cast<Bus&>(*bus);
+        ComputeBusDistances(mutable_bus);
+        ComputeBusStats(mutable_bus);
+    }
+}
+
+TransportCatalogue::BusesRange TransportCatalogue::GetBusesByStop(std::string_view stop_name) const {
+    return GetBusesByStop(FindStop(stop_name));
+}
+
+TransportCatalogue::BusesRange TransportCatalogue::GetBusesByStop(const Stop* stop) const {
+    const SortedIndex& index = GetSortedIndex();
+    if (!stop) {
+        return {index.stop_buses.end(), index.stop_buses.end()};
     }
-    static const std::unordered_set<const Bus*, CustomHash> empty_set;
-    return empty_set;
+    return {index.stop_buses.begin() + index.stop_bus_offsets[stop->id],
+            index.stop_buses.begin() + index.stop_bus_offsets[stop->id + 1]};
 }
 
 const std::deque<Stop>& TransportCatalogue::GetAllStops() const {
@@ -141,20 +221,58 @@ const std::deque<Bus>& TransportCatalogue::GetAllBuses() const {
     return buses_;
 }
 
-const std::map<std::string_view, const Bus*> TransportCatalogue::GetSortedAllBuses() const {
-    std::map<std::string_view, const Bus*> result;
-    for (const auto& bus : buses_map_) {
-        result.emplace(bus.first, bus.second);
-    }
-    return result;
+const std::vector<const Bus*>& TransportCatalogue::GetSortedAllBuses() const {
+    return GetSortedIndex().buses;
 }
 
-const std::map<std::string_view, const Stop*> TransportCatalogue::GetSortedAllStops() const {
-    std::map<std::string_view, const Stop*> result;
-    for (const auto& stop : stops_map_) {
-        result.emplace(stop.first, stop.second);
+const std::vector<const Stop*>& TransportCatalogue::GetSortedAllStops() const {
+    return GetSortedIndex().stops;
+}
+
+const std::vector<geo::Coordinates>& TransportCatalogue::GetStopCoordinates() const {
+    return stop_coordinates_;
+}
+
+void TransportCatalogue::InvalidateSortedIndex() {
+    sorted_index_ready_.store(false, std::memory_order_release);
+}
+
+const TransportCatalogue::SortedIndex& TransportCatalogue::GetSortedIndex() const {
+    if (sorted_index_ready_.load(std::memory_order_acquire)) {
+        return sorted_index_;
+    }
+    std::lock_guard guard(sorted_index_mutex_);
+    if (sorted_index_ready_.load(std::memory_order_relaxed)) {
+        return sorted_index_;
     }
-    return result;
+
+    const auto by_name = [](const auto* lhs, const auto* rhs) {
+        return lhs->name < rhs->name;
+    };
+    SortedIndex index;
+    index.stops.reserve(stops_.size());
+    for (const auto& stop : stops_) {
+        index.stops.push_back(&stop);
+    }
+    std::sort(index.stops.begin(), index.stops.end(), by_name);
+
+    index.buses.reserve(buses_map_.size());
+    for (const auto& [name, bus] : buses_map_) {
+        index.buses.push_back(bus);
+    }
+    std::sort(index.buses.begin(), index.buses.end(), by_name);
+
+    index.stop_bus_offsets.reserve(stop_to_buses_.size() + 1);
+    index.stop_bus_offsets.push_back(0);
+    for (const auto& stop_buses : stop_to_buses_) {
+        const auto first = index.stop_buses.insert(index.stop_buses.end(), stop_buses.begin(), stop_buses.end());
+        std::sort(first, index.stop_buses.end(), by_name);
+        index.stop_bus_offsets.push_back(static_cast<uint32_t>(index.stop_buses.size()));
+    }
+
+    sorted_index_ = std::move(index);
+    sorted_index_ready_.store(true, std::memory_order_release);
+    return sorted_index_;
 }
 
 // transport_catalogue.cpp
@@ -166,4 +284,8 @@ const RoutingSettings& TransportCatalogue::GetRoutingSettings() const {
     return routing_settings_;
 }
 
+uint64_t TransportCatalogue::GetVersion() const {
+    return version_;
+}
+
 } // namespace transport_catalogue
\ No newline at end of file
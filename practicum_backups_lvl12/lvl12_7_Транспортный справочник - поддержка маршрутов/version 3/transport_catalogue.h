@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -10,6 +13,7 @@
 #include <vector>
 #include <functional>
 #include "geo.h" 
+#include "ranges.h"
 #include <map>
 
 namespace transport_catalogue {
@@ -17,12 +21,27 @@ namespace transport_catalogue {
 struct Stop {
     std::string name;
     geo::Coordinates coordinates;
+    uint32_t id = 0; // Плотный номер остановки в порядке добавления
+};
+
+// Статистика маршрута, считается один раз при добавлении в справочник
+struct BusStats {
+    int stop_count = 0;
+    int unique_stop_count = 0;
+    double route_length = 0.0;
+    double curvature = 1.0;
 };
 
 struct Bus {
     std::string name;
     std::vector<const Stop*> stops; // Используем вектор для хранения указателей на остановки
     bool is_round_trip;
+    // Накопленные дорожные расстояния: forward_distances[k] - путь от stops[0] до stops[k],
+    // backward_distances[k] - путь от stops[k] обратно до stops[0]
+    std::vector<int> forward_distances;
+    std::vector<int> backward_distances;
+    BusStats stats;
+    uint32_t id = 0; // Плотный номер маршрута в порядке добавления
 
     const std::string& GetName() const {
         return name; // Добавим метод для доступа к имени автобуса
@@ -73,33 +92,74 @@ struct CustomHash {
 struct RoutingSettings {
     int bus_wait_time = 0;
     double bus_velocity = 0.0;
+    // Поиск маршрута A* с оценкой по географическому расстоянию ("use_geo_heuristic")
+    bool use_geo_heuristic = false;
 };
 
 class TransportCatalogue {
 public:
+    using BusesRange = ranges::Range<std::vector<const Bus*>::const_iterator>;
+
     void AddStop(const std::string& name, const geo::Coordinates& coordinates);
     void AddBus(const std::string& name, const std::vector<const Stop*>& stops, bool is_round_trip);
+    // Удаляет маршрут, его место в деке занимает последний маршрут (id остаются плотными).
+    // Указатели на удалённый и на последний маршрут после этого недействительны
+    bool RemoveBus(std::string_view name);
     void SetDistance(const Stop* from, const Stop* to, int distance);
     int GetDistance(const Stop* from, const Stop* to) const;
-    const Bus* FindBus(const std::string& name) const;
-    const Stop* FindStop(const std::string& name) const;
-    BusInfo GetBusInfo(const std::string& name, int request_id) const;
-    const std::unordered_set<const Bus*, CustomHash>& GetBusesByStop(const std::string& stop_name) const;
+    const std::unordered_map<std::pair<const Stop*, const Stop*>, int, CustomHash>& GetAllDistances() const;
+    // Поиск по string_view не создаёт временных строк
+    const Bus* FindBus(std::string_view name) const;
+    const Stop* FindStop(std::string_view name) const;
+    BusInfo GetBusInfo(std::string_view name, int request_id) const;
+    // Маршруты через остановку, отсортированные по имени
+    BusesRange GetBusesByStop(std::string_view stop_name) const;
+    BusesRange GetBusesByStop(const Stop* stop) const;
     const std::deque<Stop>& GetAllStops() const;
     const std::deque<Bus>& GetAllBuses() const;
     void SetRoutingSettings(const RoutingSettings& settings);
     const RoutingSettings& GetRoutingSettings() const;
-    const std::map<std::string_view, const Bus*> GetSortedAllBuses() const;
-    const std::map<std::string_view, const Stop*> GetSortedAllStops() const;
+    const std::vector<const Bus*>& GetSortedAllBuses() const;
+    const std::vector<const Stop*>& GetSortedAllStops() const;
+    // Координаты остановок по их id
+    const std::vector<geo::Coordinates>& GetStopCoordinates() const;
+    // Растёт при каждом изменении остановок, маршрутов и расстояний. По нему
+    // кэши производных данных (например, отрисованной карты) узнают, что устарели
+    uint64_t GetVersion() const;
     
+
 private:
     std::deque<Stop> stops_; // Дек объектов Stop
     std::deque<Bus> buses_;   // Дек объектов Bus
-    std::unordered_map<std::string, const Stop*> stops_map_;
-    std::unordered_map<std::string, const Bus*> buses_map_;
-    std::unordered_map<const Stop*, std::unordered_set<const Bus*, CustomHash>, CustomHash> stop_to_buses_map_;
+    // Ключи ссылаются на имена внутри деков: элементы дека не перемещаются при добавлении
+    std::unordered_map<std::string_view, const Stop*> stops_map_;
+    std::unordered_map<std::string_view, const Bus*> buses_map_;
+    std::vector<geo::Coordinates> stop_coordinates_;
+    std::vector<std::vector<const Bus*>> stop_to_buses_; // По id остановки, без повторов
     std::unordered_map<std::pair<const Stop*, const Stop*>, int, CustomHash> between_stops_distance_;
     RoutingSettings routing_settings_;
+    uint64_t version_ = 0;
+
+    // Отсортированные по именам индексы. Строятся при первом обращении после изменения
+    // справочника; построение защищено мьютексом, чтобы читать можно было из нескольких потоков
+    struct SortedIndex {
+        std::vector<const Stop*> stops;
+        std::vector<const Bus*> buses;
+        // CSR остановка -> маршруты: маршруты остановки с id i лежат в
+        // stop_buses[stop_bus_offsets[i] .. stop_bus_offsets[i + 1])
+        std::vector<uint32_t> stop_bus_offsets;
+        std::vector<const Bus*> stop_buses;
+    };
+    mutable SortedIndex sorted_index_;
+    mutable std::atomic<bool> sorted_index_ready_ = false;
+    mutable std::mutex sorted_index_mutex_;
+
+    const SortedIndex& GetSortedIndex() const;
+    void InvalidateSortedIndex();
+
+    void ComputeBusDistances(Bus& bus) const;
+    void ComputeBusStats(Bus& bus) const;
+    void RefreshBusesAtStop(const Stop* stop);
 };
 
 } // namespace transport_catalogue
\ No newline at end of file
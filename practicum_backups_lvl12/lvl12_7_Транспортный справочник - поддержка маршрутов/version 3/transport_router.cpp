@@ -1,82 +1,373 @@
 #include "transport_router.h"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
 
 namespace transport {
 
+namespace {
+
+// Вызывает action(from, to, distance) для каждой пары остановок маршрута (индексы в bus.stops)
+// в том порядке, в котором рёбра поездок добавляются в граф
+template <typename Action>
+void ForEachBusSegment(const transport_catalogue::Bus& bus, Action action) {
+    const size_t stops_count = bus.stops.size();
+    for (size_t i = 0; i < stops_count; ++i) {
+        for (size_t j = i + 1; j < stops_count; ++j) {
+            // Расстояние для прямого направления - разность накопленных сумм
+            action(i, j, bus.forward_distances[j] - bus.forward_distances[i]);
+            // Для некольцевых маршрутов добавляем обратное ребро
+            if (!bus.is_round_trip) {
+                action(j, i, bus.backward_distances[j] - bus.backward_distances[i]);
+            }
+        }
+    }
+}
+
+size_t GetSpanCount(size_t from, size_t to) {
+    return from < to ? to - from : from - to;
+}
+
+}  // namespace
+
 void Router::BuildGraph(const transport_catalogue::TransportCatalogue& catalogue) {
     const auto& all_stops = catalogue.GetSortedAllStops();
     graph::DirectedWeightedGraph<double> stops_graph(all_stops.size() * 2);
-    std::unordered_map<std::string, graph::VertexId> stop_ids;
+    std::unordered_map<std::string_view, graph::VertexId> stop_ids;
+    // Вершина ожидания по плотному id остановки
+    std::vector<graph::VertexId> stop_vertex(catalogue.GetAllStops().size());
     graph::VertexId vertex_id = 0;
+    names_.clear();
+    name_ids_.clear();
+    wait_edges_.clear();
+    wait_edges_.reserve(all_stops.size());
+    vertex_coordinates_.clear();
+    vertex_coordinates_.reserve(all_stops.size() * 2);
 
     // Создаем вершины и ребра ожидания
-    for (const auto& [stop_name, stop_info] : all_stops) {
+    for (const auto* stop_info : all_stops) {
         stop_ids[stop_info->name] = vertex_id;
-        stops_graph.AddEdge({
-            stop_info->name,
+        stop_vertex[stop_info->id] = vertex_id;
+        vertex_coordinates_.push_back(stop_info->coordinates);
+        vertex_coordinates_.push_back(stop_info->coordinates);
+        wait_edges_.push_back(stops_graph.AddEdge({
+            AddName(stop_info->name),
             0,
             vertex_id,
             vertex_id + 1,
             static_cast<double>(settings_.bus_wait_time)
-        });
+        }));
         vertex_id += 2;
     }
     stop_ids_ = std::move(stop_ids);
+    stop_count_ = all_stops.size();
 
     // Предварительно рассчитываем коэффициент скорости
     const double velocity_coef = settings_.bus_velocity * 1000.0 / 60.0;
 
     // Создаем ребра поездки на автобусе
     const auto& all_buses = catalogue.GetSortedAllBuses();
-    for (const auto& [bus_name, bus_info] : all_buses) {
-        const auto& stops = bus_info->stops;
-        const size_t stops_count = stops.size();
-        
-        for (size_t i = 0; i < stops_count; ++i) {
-            for (size_t j = i + 1; j < stops_count; ++j) {
-                const auto* stop_from = stops[i];
-                const auto* stop_to = stops[j];
-                
-                // Рассчитываем расстояние для прямого направления
-                int distance = 0;
-                for (size_t k = i + 1; k <= j; ++k) {
-                    distance += catalogue.GetDistance(stops[k - 1], stops[k]);
-                }                
-                // Добавляем прямое ребро
-                AddBusEdge(stops_graph, bus_info->name, static_cast<size_t>(j - i), 
-                                stop_from->name, stop_to->name, distance, velocity_coef);
-
-                // Для некольцевых маршрутов добавляем обратное ребро
-                if (!bus_info->is_round_trip) {
-                    int reverse_distance = 0;
-                    for (size_t k = j; k > i; --k) {
-                        reverse_distance += catalogue.GetDistance(stops[k], stops[k - 1]);
-                    }
-                    
-                    AddBusEdge(stops_graph, bus_info->name, static_cast<size_t>(j - i),
-                              stop_to->name, stop_from->name, reverse_distance, velocity_coef);
-                }
-            }
+    for (const auto* bus_info : all_buses) {
+        const graph::NameId bus_name_id = AddName(bus_info->name);
+
+        // Вершины остановок маршрута ищем один раз, а не для каждой пары
+        std::vector<graph::VertexId> stop_vertices;
+        stop_vertices.reserve(bus_info->stops.size());
+        for (const auto* stop : bus_info->stops) {
+            stop_vertices.push_back(stop_vertex[stop->id]);
         }
+
+        ForEachBusSegment(*bus_info, [&](size_t from, size_t to, int distance) {
+            AddBusEdge(stops_graph, bus_name_id, GetSpanCount(from, to),
+                       stop_vertices[from], stop_vertices[to], distance, velocity_coef);
+        });
     }
     
+    stops_graph.Finalize();
     graph_ = std::move(stops_graph);
-    router_ = std::make_unique<graph::Router<double>>(graph_);
+    bus_edges_.clear();
+    bus_edges_ready_ = false;
+    InitializeRouter(catalogue);
+}
+
+void Router::AddBus(const transport_catalogue::TransportCatalogue& catalogue, std::string_view bus_name) {
+    const auto* bus = catalogue.FindBus(bus_name);
+    if (!bus) {
+        throw std::invalid_argument("Unknown bus: " + std::string(bus_name));
+    }
+    EnsureBusEdges();
+    RemoveBus(bus->name);
+    for (const auto* stop : bus->stops) {
+        AddStop(*stop);
+    }
+
+    const double velocity_coef = settings_.bus_velocity * 1000.0 / 60.0;
+    const graph::NameId bus_name_id = AddName(bus->name);
+    auto& edges = bus_edges_[bus->name];
+    ForEachBusSegment(*bus, [&](size_t from, size_t to, int distance) {
+        const graph::EdgeId edge_id = AddBusEdge(graph_, bus_name_id, GetSpanCount(from, to),
+                                                 stop_ids_.at(bus->stops[from]->name),
+                                                 stop_ids_.at(bus->stops[to]->name), distance, velocity_coef);
+        // Новое ребро - то же, что ребро с бесконечным весом, который уменьшился
+        router_->InvalidateAfterEdgeDecrease(edge_id);
+        edges.push_back(edge_id);
+    });
+    heuristic_stale_ = true;
+}
+
+bool Router::RemoveBus(std::string_view bus_name) {
+    EnsureBusEdges();
+    const auto it = bus_edges_.find(std::string(bus_name));
+    if (it == bus_edges_.end()) {
+        return false;
+    }
+    for (const graph::EdgeId edge_id : it->second) {
+        router_->InvalidateBeforeEdgeIncrease(edge_id);
+        graph_.RemoveEdge(edge_id);
+    }
+    bus_edges_.erase(it);
+    // Оценка A* без рёбер маршрута остаётся допустимой: пути могут стать только длиннее
+    return true;
+}
+
+void Router::UpdateBusTimes(const transport_catalogue::TransportCatalogue& catalogue, std::string_view bus_name) {
+    const auto* bus = catalogue.FindBus(bus_name);
+    if (!bus) {
+        throw std::invalid_argument("Unknown bus: " + std::string(bus_name));
+    }
+    EnsureBusEdges();
+    const size_t stops_count = bus->stops.size();
+    const size_t segment_count = stops_count * (stops_count - std::min<size_t>(stops_count, 1)) / 2
+                                 * (bus->is_round_trip ? 1 : 2);
+    const auto it = bus_edges_.find(bus->name);
+    if (it == bus_edges_.end() || it->second.size() != segment_count) {
+        // Маршрута нет в графе или в справочнике он заменён другим с тем же именем
+        AddBus(catalogue, bus_name);
+        return;
+    }
+
+    const double velocity_coef = settings_.bus_velocity * 1000.0 / 60.0;
+    auto edge_it = it->second.begin();
+    ForEachBusSegment(*bus, [&](size_t, size_t, int distance) {
+        SetEdgeWeight(*edge_it++, distance / velocity_coef);
+    });
+    heuristic_stale_ = true;
+}
+
+void Router::AddStop(const transport_catalogue::Stop& stop) {
+    if (const auto it = stop_ids_.find(stop.name); it != stop_ids_.end()) {
+        vertex_coordinates_[it->second] = stop.coordinates;
+        vertex_coordinates_[it->second + 1] = stop.coordinates;
+        return;
+    }
+    const graph::VertexId vertex_id = graph_.AddVertex();
+    graph_.AddVertex();
+    router_->OnVerticesAdded();
+    stop_ids_[stop.name] = vertex_id;
+    vertex_coordinates_.push_back(stop.coordinates);
+    vertex_coordinates_.push_back(stop.coordinates);
+    // Из новой остановки ещё ничего не выходит, поэтому кэш не меняется
+    wait_edges_.push_back(graph_.AddEdge({
+        AddName(stop.name),
+        0,
+        vertex_id,
+        vertex_id + 1,
+        static_cast<double>(settings_.bus_wait_time)
+    }));
+    ++stop_count_;
+}
+
+void Router::SetBusWaitTime(int bus_wait_time) {
+    settings_.bus_wait_time = bus_wait_time;
+    for (const graph::EdgeId edge_id : wait_edges_) {
+        graph_.SetEdgeWeight(edge_id, static_cast<double>(bus_wait_time));
+    }
+    // Ожидание входит почти в каждый путь
+    router_->ClearCache();
+}
+
+void Router::SetEdgeWeight(graph::EdgeId edge_id, double weight) {
+    const double old_weight = graph_.GetEdge(edge_id).weight;
+    if (weight > old_weight) {
+        router_->InvalidateBeforeEdgeIncrease(edge_id);
+        graph_.SetEdgeWeight(edge_id, weight);
+    } else if (weight < old_weight) {
+        graph_.SetEdgeWeight(edge_id, weight);
+        router_->InvalidateAfterEdgeDecrease(edge_id);
+    }
 }
 
-void Router::AddBusEdge(graph::DirectedWeightedGraph<double>& graph,
-                       const std::string& bus_name,
+void Router::EnsureBusEdges() {
+    if (bus_edges_ready_) {
+        return;
+    }
+    // Рёбра одного маршрута добавлялись подряд, поэтому порядок идентификаторов совпадает
+    // с порядком ForEachBusSegment
+    for (graph::VertexId vertex = 0; vertex < graph_.GetVertexCount(); ++vertex) {
+        for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto edge = graph_.GetEdge(edge_id);
+            if (edge.span_count != 0) {
+                bus_edges_[names_[edge.name_id]].push_back(edge_id);
+            }
+        }
+    }
+    for (auto& [name, edges] : bus_edges_) {
+        std::sort(edges.begin(), edges.end());
+    }
+    bus_edges_ready_ = true;
+}
+
+void Router::RefreshHeuristic(const transport_catalogue::TransportCatalogue& catalogue) {
+    if (heuristic_stale_ && settings_.use_geo_heuristic) {
+        InitializeRouter(catalogue);
+    }
+    heuristic_stale_ = false;
+}
+
+const std::string& Router::GetStopName(size_t stop_index) const {
+    return names_[graph_.GetEdge(wait_edges_[stop_index]).name_id];
+}
+
+void Router::InitializeRouter(const transport_catalogue::TransportCatalogue& catalogue) {
+    const double velocity_coef = settings_.bus_velocity * 1000.0 / 60.0;
+    heuristic_stale_ = false;
+    router_ = std::make_unique<graph::Router<double>>(
+        graph_,
+        settings_.route_cache_capacity,
+        settings_.use_geo_heuristic ? MakeGeoHeuristic(catalogue, velocity_coef) : graph::Router<double>::Heuristic{});
+}
+
+void Router::Serialize(std::ostream& out) const {
+    binary_io::WriteValue(out, settings_.bus_wait_time);
+    binary_io::WriteValue(out, settings_.bus_velocity);
+    binary_io::WriteValue(out, settings_.use_geo_heuristic);
+    binary_io::WriteSize(out, settings_.route_cache_capacity);
+    binary_io::WriteSize(out, stop_count_);
+    binary_io::WriteSize(out, names_.size());
+    for (const auto& name : names_) {
+        binary_io::WriteString(out, name);
+    }
+    graph_.Serialize(out);
+}
+
+std::unique_ptr<Router> Router::Deserialize(std::istream& in, const transport_catalogue::TransportCatalogue& catalogue) {
+    auto router = std::make_unique<Router>();
+    router->settings_.bus_wait_time = binary_io::ReadValue<int>(in);
+    router->settings_.bus_velocity = binary_io::ReadValue<double>(in);
+    router->settings_.use_geo_heuristic = binary_io::ReadValue<bool>(in);
+    router->settings_.route_cache_capacity = binary_io::ReadSize(in);
+    if (router->settings_.bus_wait_time < 0 || !std::isfinite(router->settings_.bus_velocity)
+        || router->settings_.bus_velocity <= 0.0) {
+        throw binary_io::FormatError("Invalid routing settings");
+    }
+    router->stop_count_ = binary_io::ReadSize(in);
+    const size_t name_count = binary_io::ReadSize(in);
+    for (size_t i = 0; i < name_count; ++i) {
+        router->names_.push_back(binary_io::ReadString(in));
+        router->name_ids_.emplace(router->names_.back(), static_cast<graph::NameId>(i));
+    }
+    router->graph_ = graph::DirectedWeightedGraph<double>::Deserialize(in);
+    if (router->stop_count_ > router->names_.size() || router->graph_.GetVertexCount() != router->stop_count_ * 2) {
+        throw binary_io::FormatError("Router data does not match its graph");
+    }
+    for (graph::EdgeId edge_id = 0; edge_id < router->graph_.GetEdgeCount(); ++edge_id) {
+        const auto edge = router->graph_.GetEdge(edge_id);
+        if (edge.name_id >= router->names_.size()) {
+            throw binary_io::FormatError("Router edge name is out of range");
+        }
+        if (!std::isfinite(edge.weight) || edge.weight < 0.0) {
+            throw binary_io::FormatError("Router edge weight is invalid");
+        }
+    }
+
+    // Имя остановки хранит её ребро ожидания: остановки, добавленные правкой графа,
+    // не лежат в начале таблицы имён
+    router->wait_edges_.reserve(router->stop_count_);
+    for (size_t i = 0; i < router->stop_count_; ++i) {
+        const auto edges = router->graph_.GetIncidentEdges(i * 2);
+        const auto wait_edge = std::find_if(edges.begin(), edges.end(), [&router](graph::EdgeId edge_id) {
+            return router->graph_.GetEdge(edge_id).span_count == 0;
+        });
+        if (wait_edge == edges.end()) {
+            throw binary_io::FormatError("Router stop has no wait edge");
+        }
+        router->wait_edges_.push_back(*wait_edge);
+    }
+
+    // Вершины остановок и их координаты восстанавливаем по именам остановок
+    router->vertex_coordinates_.reserve(router->stop_count_ * 2);
+    for (size_t i = 0; i < router->stop_count_; ++i) {
+        const auto* stop = catalogue.FindStop(router->GetStopName(i));
+        if (!stop || !router->stop_ids_.emplace(stop->name, i * 2).second) {
+            throw binary_io::FormatError("Router refers to an unknown stop: " + router->GetStopName(i));
+        }
+        router->vertex_coordinates_.push_back(stop->coordinates);
+        router->vertex_coordinates_.push_back(stop->coordinates);
+    }
+    // Граф строится по всем остановкам справочника, и запросы ищут их вершины без проверок
+    if (router->stop_ids_.size() != catalogue.GetAllStops().size()) {
+        throw binary_io::FormatError("Router does not cover all stops");
+    }
+    router->InitializeRouter(catalogue);
+    return router;
+}
+
+graph::Router<double>::Heuristic Router::MakeGeoHeuristic(const transport_catalogue::TransportCatalogue& catalogue,
+                                                          double velocity) const {
+    // Дорожное расстояние может быть короче географического, поэтому оценка масштабируется
+    // минимальным по всем перегонам отношением "дорога / прямая". Тогда по неравенству
+    // треугольника оценка не превышает реального времени в пути и A* остаётся точным
+    double min_ratio = std::numeric_limits<double>::infinity();
+    for (const auto& bus : catalogue.GetAllBuses()) {
+        for (size_t i = 1; i < bus.stops.size(); ++i) {
+            const double geo_distance = geo::ComputeDistance(bus.stops[i - 1]->coordinates, bus.stops[i]->coordinates);
+            if (geo_distance <= 0.0) {
+                continue;
+            }
+            min_ratio = std::min(min_ratio, catalogue.GetDistance(bus.stops[i - 1], bus.stops[i]) / geo_distance);
+            if (!bus.is_round_trip) {
+                min_ratio = std::min(min_ratio, catalogue.GetDistance(bus.stops[i], bus.stops[i - 1]) / geo_distance);
+            }
+        }
+    }
+    if (min_ratio == std::numeric_limits<double>::infinity()) {
+        min_ratio = 0.0;
+    }
+    // Запас на погрешность вычисления ComputeDistance
+    const double time_per_meter = min_ratio * (1.0 - 1e-9) / velocity;
+
+    return [this, time_per_meter](graph::VertexId vertex, graph::VertexId target) {
+        const double distance = geo::ComputeDistance(vertex_coordinates_[vertex], vertex_coordinates_[target]);
+        // acos от значения чуть больше 1 для совпадающих точек даёт NaN
+        return std::isnan(distance) ? 0.0 : distance * time_per_meter;
+    };
+}
+
+graph::NameId Router::AddName(const std::string& name) {
+    const auto [it, inserted] = name_ids_.emplace(name, static_cast<graph::NameId>(names_.size()));
+    if (inserted) {
+        names_.push_back(name);
+    }
+    return it->second;
+}
+
+graph::EdgeId Router::AddBusEdge(graph::DirectedWeightedGraph<double>& graph,
+                       graph::NameId bus_name_id,
                        size_t span_count,  
-                       const std::string& from_stop,
-                       const std::string& to_stop,
+                       graph::VertexId from_stop,
+                       graph::VertexId to_stop,
                        double distance,
                        double velocity) const {
     double time = distance / velocity;
-    graph.AddEdge({
-        bus_name,
+    return graph.AddEdge({
+        bus_name_id,
         span_count,  
-        stop_ids_.at(from_stop) + 1,
-        stop_ids_.at(to_stop),
+        from_stop + 1,
+        to_stop,
         time
     });
 }
@@ -87,8 +378,8 @@ std::optional<RouteInfo> Router::GetRouteInfo(std::string_view stop_from, std::s
     }
 
     auto route = router_->BuildRoute(
-        stop_ids_.at(std::string(stop_from)),
-        stop_ids_.at(std::string(stop_to))
+        stop_ids_.at(stop_from),
+        stop_ids_.at(stop_to)
     );
 
     if (!route) {
@@ -97,17 +388,74 @@ std::optional<RouteInfo> Router::GetRouteInfo(std::string_view stop_from, std::s
 
     RouteInfo result;
     result.total_time = route->weight;
+    result.items.reserve(route->edges.size());
 
     for (const auto edge_id : route->edges) {
         const auto& edge = graph_.GetEdge(edge_id);
         if (edge.span_count == 0) {
-            result.items.push_back(WaitItem{edge.name, edge.weight});
+            result.items.push_back(WaitItem{names_[edge.name_id], edge.weight});
         } else {
-            result.items.push_back(BusItem{edge.name, edge.span_count, edge.weight});
+            result.items.push_back(BusItem{names_[edge.name_id], edge.span_count, edge.weight});
         }
     }
 
     return result;
 }
 
+TravelTimeTable Router::ComputeTravelTimes(const std::vector<std::string_view>& stops_from,
+                                           size_t thread_count) const {
+    TravelTimeTable table;
+    if (!router_) {
+        return table;
+    }
+
+    // Остановки, добавленные правкой графа, идут в конце, поэтому столбцы сортируются отдельно
+    std::vector<size_t> stop_order(stop_count_);
+    std::iota(stop_order.begin(), stop_order.end(), 0);
+    std::sort(stop_order.begin(), stop_order.end(), [this](size_t lhs, size_t rhs) {
+        return GetStopName(lhs) < GetStopName(rhs);
+    });
+    table.stops_to.reserve(stop_count_);
+    for (const size_t stop : stop_order) {
+        table.stops_to.push_back(GetStopName(stop));
+    }
+    table.stops_from.reserve(stops_from.size());
+    std::vector<graph::VertexId> sources;
+    sources.reserve(stops_from.size());
+    for (const auto stop : stops_from) {
+        sources.push_back(stop_ids_.at(stop));
+        table.stops_from.emplace_back(stop);
+    }
+    table.times.resize(sources.size() * stop_count_);
+
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = std::min(thread_count, sources.size());
+
+    // Каждый поток берёт очередную строку и пишет только в свой диапазон таблицы
+    std::atomic<size_t> next_row = 0;
+    const auto worker = [&] {
+        for (size_t row = next_row++; row < sources.size(); row = next_row++) {
+            const auto weights = router_->BuildRouteWeights(sources[row]);
+            auto row_it = table.times.begin() + row * stop_count_;
+            for (const size_t stop : stop_order) {
+                *row_it++ = weights[stop * 2];
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    return table;
+}
+
 } // namespace transport
\ No newline at end of file
@@ -3,22 +3,26 @@
 #include "router.h"
 #include "transport_catalogue.h"
 
+#include <istream>
 #include <memory>
 #include <optional>
+#include <ostream>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <variant>
 
 namespace transport {
 
+// Имена в элементах маршрута ссылаются на таблицу имён роутера и живут, пока жив роутер
 struct WaitItem {
-    std::string stop_name;
+    std::string_view stop_name;
     double time = 0.0;
 };
 
 struct BusItem {
-    std::string bus;
+    std::string_view bus;
     size_t span_count = 0;
     double time = 0.0;
 };
@@ -28,9 +32,25 @@ struct RouteInfo {
     std::vector<std::variant<WaitItem, BusItem>> items;
 };
 
+// Матрица времени в пути от выбранных остановок до всех остановок справочника
+struct TravelTimeTable {
+    std::vector<std::string> stops_from;
+    std::vector<std::string> stops_to; // Все остановки графа в порядке сортировки по имени
+    // Время stops_from[i] -> stops_to[j] хранится в times[i * stops_to.size() + j]
+    std::vector<std::optional<double>> times;
+
+    std::optional<double> GetTime(size_t from_index, size_t to_index) const {
+        return times.at(from_index * stops_to.size() + to_index);
+    }
+};
+
 struct RouterSettings {
     int bus_wait_time = 0;
     double bus_velocity = 0.0;
+    // A* с оценкой по географическому расстоянию вместо поиска полного дерева из источника
+    bool use_geo_heuristic = false;
+    // Сколько деревьев кратчайших путей (по остановке отправления) держать в кэше
+    size_t route_cache_capacity = graph::Router<double>::DEFAULT_CACHE_CAPACITY;
 };
 
 class Router {
@@ -44,19 +64,69 @@ public:
 
     std::optional<RouteInfo> GetRouteInfo(std::string_view stop_from, std::string_view stop_to) const;
 
+    // Считает деревья кратчайших путей от каждой из stops_from параллельно в thread_count
+    // потоках (0 - по числу ядер). Строки таблицы идут в порядке stops_from
+    TravelTimeTable ComputeTravelTimes(const std::vector<std::string_view>& stops_from,
+                                       size_t thread_count = 0) const;
+
+    // Правка построенного графа без полной перестройки: меняются только рёбра затронутого
+    // маршрута или остановки, а из кэша уходят только деревья путей, которые правка может
+    // изменить. Маршруты и остановки берутся из справочника, поэтому он меняется первым.
+    // После пачки AddBus/UpdateBusTimes нужен RefreshHeuristic
+    void AddBus(const transport_catalogue::TransportCatalogue& catalogue, std::string_view bus_name);
+    bool RemoveBus(std::string_view bus_name);
+    // Пересчитывает время поездок маршрута после изменения расстояний в справочнике
+    void UpdateBusTimes(const transport_catalogue::TransportCatalogue& catalogue, std::string_view bus_name);
+    void AddStop(const transport_catalogue::Stop& stop);
+    void SetBusWaitTime(int bus_wait_time);
+    // Оценка A* зависит от расстояний всех маршрутов, поэтому после их правки строится заново,
+    // один раз на пачку правок. Без правок и без A* ничего не делает
+    void RefreshHeuristic(const transport_catalogue::TransportCatalogue& catalogue);
+
+    graph::Router<double>::CacheStats GetCacheStats() const {
+        return router_ ? router_->GetCacheStats() : graph::Router<double>::CacheStats{};
+    }
+
+    // Двоичная запись построенного графа вместе с настройками и таблицей имён. При чтении
+    // граф не перестраивается, справочник нужен только для координат остановок
+    void Serialize(std::ostream& out) const;
+    static std::unique_ptr<Router> Deserialize(std::istream& in,
+                                               const transport_catalogue::TransportCatalogue& catalogue);
+
 private:
     void BuildGraph(const transport_catalogue::TransportCatalogue& catalogue);
-    void AddBusEdge(graph::DirectedWeightedGraph<double>& graph,
-               const std::string& bus_name,
+    void InitializeRouter(const transport_catalogue::TransportCatalogue& catalogue);
+    void EnsureBusEdges();
+    void SetEdgeWeight(graph::EdgeId edge_id, double weight);
+    const std::string& GetStopName(size_t stop_index) const;
+    graph::NameId AddName(const std::string& name);
+    graph::EdgeId AddBusEdge(graph::DirectedWeightedGraph<double>& graph,
+               graph::NameId bus_name_id,
                size_t span_count,
-               const std::string& from_stop,
-               const std::string& to_stop,
+               graph::VertexId from_stop,
+               graph::VertexId to_stop,
                double distance,
                double velocity) const;
+    graph::Router<double>::Heuristic MakeGeoHeuristic(const transport_catalogue::TransportCatalogue& catalogue,
+                                                      double velocity) const;
     
     RouterSettings settings_;
     graph::DirectedWeightedGraph<double> graph_;
-    std::unordered_map<std::string, graph::VertexId> stop_ids_;
+    // Ключи ссылаются на имена остановок справочника, поэтому справочник должен жить дольше роутера
+    std::unordered_map<std::string_view, graph::VertexId> stop_ids_;
+    // Имена остановок и маршрутов, на которые ссылаются рёбра графа по NameId
+    std::vector<std::string> names_;
+    // Номер имени в names_: повторно добавленный маршрут получает прежний NameId
+    std::unordered_map<std::string, graph::NameId> name_ids_;
+    size_t stop_count_ = 0;
+    // Ребро ожидания остановки по её номеру в графе; остановка i - вершины 2i и 2i + 1
+    std::vector<graph::EdgeId> wait_edges_;
+    // Рёбра поездок каждого маршрута в порядке добавления. Собирается при первой правке графа
+    std::unordered_map<std::string, std::vector<graph::EdgeId>> bus_edges_;
+    bool bus_edges_ready_ = false;
+    // Маршруты менялись после построения оценки A*
+    bool heuristic_stale_ = false;
+    std::vector<geo::Coordinates> vertex_coordinates_;
     std::unique_ptr<graph::Router<double>> router_;
 };
 
@@ -2,12 +2,14 @@
 #include "read_input_functions.h"
 #include "request_queue.h"
 #include "search_server.h"
+#include "test_example_functions.h"
 #include <iostream>
 #include <cstdint>
 
 using namespace std;
 
 int main() {
+    TestSearchServer();
     SearchServer search_server("and in at"s);
     RequestQueue request_queue(search_server);
     search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
@@ -15,6 +17,7 @@ int main() {
     search_server.AddDocument(3, "big cat fancy collar "s, DocumentStatus::ACTUAL, {1, 2, 8});
     search_server.AddDocument(4, "big dog sparrow Eugene"s, DocumentStatus::ACTUAL, {1, 3, 2});
     search_server.AddDocument(5, "big dog sparrow Vasiliy"s, DocumentStatus::ACTUAL, {1, 1, 1});
+    search_server.Finalize();
     // 1439    
     for (int i = 0; i < 1439; ++i) {
         request_queue.AddFindRequest("empty request"s);
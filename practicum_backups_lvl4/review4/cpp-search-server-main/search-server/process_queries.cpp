@@ -0,0 +1,25 @@
+#include "process_queries.h"
+#include <algorithm>
+#include <execution>
+#include <utility>
+
+JoinedDocuments::JoinedDocuments(std::vector<std::vector<Document>> results)
+    : results_(std::move(results)) {
+    for (const auto& documents : results_) {
+        size_ += documents.size();
+    }
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                  const std::vector<std::string>& queries) {
+    std::vector<std::vector<Document>> results(queries.size());
+    std::transform(std::execution::par, queries.begin(), queries.end(), results.begin(),
+                   [&search_server](const std::string& query) {
+                       return search_server.FindTopDocuments(query);
+                   });
+    return results;
+}
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
+    return JoinedDocuments(ProcessQueries(search_server, queries));
+}
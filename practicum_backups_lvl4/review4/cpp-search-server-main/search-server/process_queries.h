@@ -0,0 +1,91 @@
+#pragma once
+#include "document.h"
+#include "search_server.h"
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Results of all queries one after another, read in place from the per-query vectors
+class JoinedDocuments {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator(const std::vector<std::vector<Document>>* results, size_t query_index)
+            : results_(results)
+            , query_index_(query_index) {
+            SkipEmptyResults();
+        }
+
+        reference operator*() const {
+            return (*results_)[query_index_][document_index_];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        Iterator& operator++() {
+            ++document_index_;
+            SkipEmptyResults();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return query_index_ == other.query_index_ && document_index_ == other.document_index_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const std::vector<std::vector<Document>>* results_;
+        size_t query_index_;
+        size_t document_index_ = 0;
+
+        void SkipEmptyResults() {
+            while (query_index_ < results_->size() && document_index_ == (*results_)[query_index_].size()) {
+                ++query_index_;
+                document_index_ = 0;
+            }
+        }
+    };
+
+    explicit JoinedDocuments(std::vector<std::vector<Document>> results);
+
+    Iterator begin() const {
+        return Iterator(&results_, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(&results_, results_.size());
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+private:
+    std::vector<std::vector<Document>> results_;
+    size_t size_ = 0;
+};
+
+// FindTopDocuments for every query, evaluated concurrently; results are in the order of queries
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                  const std::vector<std::string>& queries);
+
+// The same results as one flat sequence
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
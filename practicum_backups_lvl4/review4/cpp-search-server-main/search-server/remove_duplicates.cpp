@@ -0,0 +1,44 @@
+#include "remove_duplicates.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct WordSetHasher {
+    size_t operator()(const std::vector<std::string_view>& words) const {
+        size_t hash = words.size();
+        for (const std::string_view word : words) {
+            hash = hash * 37 + std::hash<std::string_view>{}(word);
+        }
+        return hash;
+    }
+};
+
+} // namespace
+
+void RemoveDuplicates(SearchServer& search_server) {
+    std::vector<int> document_ids(search_server.begin(), search_server.end());
+    std::sort(document_ids.begin(), document_ids.end());
+
+    // Word maps are ordered, so equal sets give equal vectors
+    std::unordered_set<std::vector<std::string_view>, WordSetHasher> seen_word_sets;
+    std::vector<int> duplicate_ids;
+    for (const int document_id : document_ids) {
+        std::vector<std::string_view> words;
+        for (const auto& [word, _] : search_server.GetWordFrequencies(document_id)) {
+            words.push_back(word);
+        }
+        if (!seen_word_sets.insert(std::move(words)).second) {
+            duplicate_ids.push_back(document_id);
+        }
+    }
+
+    for (const int document_id : duplicate_ids) {
+        std::cout << "Found duplicate document id " << document_id << std::endl;
+        search_server.RemoveDocument(document_id);
+    }
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "search_server.h"
+
+// Removes documents whose set of words repeats a document with a smaller id
+void RemoveDuplicates(SearchServer& search_server);
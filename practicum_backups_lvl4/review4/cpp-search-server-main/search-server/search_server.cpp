@@ -1,36 +1,90 @@
 #include "search_server.h"
 
 #include <cmath>
+#include <execution>
 
 using namespace std;//   
 
 SearchServer::SearchServer(const string& stop_words_text)
+    : SearchServer(string_view(stop_words_text))
+{
+}
+
+SearchServer::SearchServer(string_view stop_words_text)
     : SearchServer(SplitIntoWords(stop_words_text))  // Invoke delegating constructor from string container
 {
 }
 
-void SearchServer::AddDocument(int document_id, const string& document, DocumentStatus status,
+void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
                                const vector<int>& ratings) {
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw invalid_argument("Invalid document_id"s);
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    // Map nodes never move, so views into the stored text stay valid
+    const string& text = documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status,
+                                                                      string(document)}).first->second.text;
+    vector<string_view> words;
+    try {
+        words = SplitIntoWordsNoStop(text);
+    } catch (...) {
+        documents_.erase(document_id);
+        throw;
+    }
 
     const double inv_word_count = 1.0 / words.size();
-    for (const string& word : words) {
+    auto& word_freqs = document_to_word_freqs_[document_id];
+    for (const string_view word : words) {
         word_to_document_freqs_[word][document_id] += inv_word_count;
+        word_freqs[word] += inv_word_count;
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
     document_ids_.push_back(document_id);
+    finalized_index_.reset();
+}
+
+void SearchServer::Finalize() {
+    FinalizedIndex index;
+    index.document_ids.reserve(documents_.size());
+    index.document_ratings.reserve(documents_.size());
+    index.document_statuses.reserve(documents_.size());
+    for (const auto& [document_id, document_data] : documents_) {
+        index.document_ids.push_back(document_id);
+        index.document_ratings.push_back(document_data.rating);
+        index.document_statuses.push_back(document_data.status);
+    }
+
+    size_t posting_count = 0;
+    for (const auto& [_, word_freqs] : document_to_word_freqs_) {
+        posting_count += word_freqs.size();
+    }
+    index.words.reserve(word_to_document_freqs_.size());
+    index.word_offsets.reserve(word_to_document_freqs_.size() + 1);
+    index.posting_documents.reserve(posting_count);
+    index.posting_freqs.reserve(posting_count);
+    index.word_offsets.push_back(0);
+    // Both maps are ordered, so the postings come out sorted by document number
+    for (const auto& [word, document_freqs] : word_to_document_freqs_) {
+        index.words.push_back(word);
+        for (const auto& [document_id, term_freq] : document_freqs) {
+            const auto number = lower_bound(index.document_ids.begin(), index.document_ids.end(), document_id);
+            index.posting_documents.push_back(static_cast<int>(number - index.document_ids.begin()));
+            index.posting_freqs.push_back(term_freq);
+        }
+        index.word_offsets.push_back(index.posting_documents.size());
+    }
+    finalized_index_ = move(index);
 }
 
-vector<Document> SearchServer::FindTopDocuments(const string& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
+bool SearchServer::IsFinalized() const {
+    return finalized_index_.has_value();
+}
+
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) {
         return document_status == status;
     });
 }
 
-vector<Document> SearchServer::FindTopDocuments(const string& raw_query) const {
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
@@ -42,23 +96,93 @@ int SearchServer::GetDocumentId(int index) const {
     return document_ids_.at(index);
 }
 
-tuple<vector<string>, DocumentStatus> SearchServer::MatchDocument(const string& raw_query, int document_id) const {
+vector<int>::const_iterator SearchServer::begin() const {
+    return document_ids_.begin();
+}
+
+vector<int>::const_iterator SearchServer::end() const {
+    return document_ids_.end();
+}
+
+const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
+    static const map<string_view, double> empty_word_freqs;
+    const auto document = document_to_word_freqs_.find(document_id);
+    return document != document_to_word_freqs_.end() ? document->second : empty_word_freqs;
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocument(const execution::sequenced_policy&, int document_id) {
+    const auto document = document_to_word_freqs_.find(document_id);
+    if (document == document_to_word_freqs_.end()) {
+        return;
+    }
+    for (const auto& [word, _] : document->second) {
+        word_to_document_freqs_.find(word)->second.erase(document_id);
+        ReleaseWord(word);
+    }
+    EraseDocumentData(document_id);
+}
+
+void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
+    const auto document = document_to_word_freqs_.find(document_id);
+    if (document == document_to_word_freqs_.end()) {
+        return;
+    }
+    // Every word has its own posting map, so they can be edited concurrently
+    vector<map<int, double>*> postings(document->second.size());
+    transform(execution::par, document->second.begin(), document->second.end(), postings.begin(),
+              [this](const auto& word_freq) {
+                  return &word_to_document_freqs_.find(word_freq.first)->second;
+              });
+    for_each(execution::par, postings.begin(), postings.end(), [document_id](map<int, double>* document_freqs) {
+        document_freqs->erase(document_id);
+    });
+    // The set of words changes only here, in one thread
+    for (const auto& [word, _] : document->second) {
+        ReleaseWord(word);
+    }
+    EraseDocumentData(document_id);
+}
+
+void SearchServer::ReleaseWord(string_view word) {
+    const auto postings = word_to_document_freqs_.find(word);
+    if (postings->second.empty()) {
+        word_to_document_freqs_.erase(postings);
+        return;
+    }
+    if (postings->first.data() != word.data()) {
+        return;
+    }
+    // The key points into the text being removed; borrow the same word from a remaining document
+    auto node = word_to_document_freqs_.extract(postings);
+    const auto& holder_freqs = document_to_word_freqs_.at(node.mapped().begin()->first);
+    node.key() = holder_freqs.find(word)->first;
+    word_to_document_freqs_.insert(move(node));
+}
+
+void SearchServer::EraseDocumentData(int document_id) {
+    finalized_index_.reset();
+    document_to_word_freqs_.erase(document_id);
+    documents_.erase(document_id);
+    document_ids_.erase(find(document_ids_.begin(), document_ids_.end(), document_id));
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_view raw_query, int document_id) const {
     const auto query = ParseQuery(raw_query);
+    // Keys of the document's own words point into its text, unlike keys of the postings
+    const auto& word_freqs = document_to_word_freqs_.at(document_id);
 
-    vector<string> matched_words;
-    for (const string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+    vector<string_view> matched_words;
+    for (const string_view word : query.plus_words) {
+        if (const auto word_freq = word_freqs.find(word); word_freq != word_freqs.end()) {
+            matched_words.push_back(word_freq->first);
         }
     }
-    for (const string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+    for (const string_view word : query.minus_words) {
+        if (word_freqs.count(word)) {
             matched_words.clear();
             break;
         }
@@ -66,22 +190,53 @@ tuple<vector<string>, DocumentStatus> SearchServer::MatchDocument(const string&
     return {matched_words, documents_.at(document_id).status};
 }
 
-bool SearchServer::IsStopWord(const string& word) const {
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::sequenced_policy&,
+                                                                  string_view raw_query, int document_id) const {
+    return MatchDocument(raw_query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::parallel_policy&,
+                                                                  string_view raw_query, int document_id) const {
+    // Duplicates are cheaper to drop from the few matched words than from the whole query
+    const auto query = ParseQuery(raw_query, true);
+    const auto& word_freqs = document_to_word_freqs_.at(document_id);
+    const DocumentStatus status = documents_.at(document_id).status;
+    const auto word_in_document = [&word_freqs](string_view word) {
+        return word_freqs.count(word) > 0;
+    };
+
+    if (any_of(execution::par, query.minus_words.begin(), query.minus_words.end(), word_in_document)) {
+        return {vector<string_view>{}, status};
+    }
+    // Words absent from the document become empty views
+    vector<string_view> matched_words(query.plus_words.size());
+    transform(execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+              [&word_freqs](string_view word) {
+                  const auto word_freq = word_freqs.find(word);
+                  return word_freq != word_freqs.end() ? word_freq->first : string_view{};
+              });
+    matched_words.erase(remove(matched_words.begin(), matched_words.end(), string_view{}), matched_words.end());
+    sort(matched_words.begin(), matched_words.end());
+    matched_words.erase(unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    return {matched_words, status};
+}
+
+bool SearchServer::IsStopWord(string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(const string& word) {
+bool SearchServer::IsValidWord(string_view word) {
     //  
     return none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
     });
 }
 
-vector<string> SearchServer::SplitIntoWordsNoStop(const string& text) const {
-    vector<string> words;
-    for (const string& word : SplitIntoWords(text)) {
+vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
+    vector<string_view> words;
+    for (const string_view word : SplitIntoWords(text)) {
         if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word "s + word + " is invalid"s);
+            throw std::invalid_argument("Word "s + string(word) + " is invalid"s);
         }
         if (!IsStopWord(word)) {
             words.push_back(word);
@@ -101,39 +256,67 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(const string& text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty"s);
     }
-    string word = text;
+    string_view word = text;
     bool is_minus = false;
     if (word[0] == '-') {
         is_minus = true;
-        word = word.substr(1);
+        word.remove_prefix(1);
     }
     if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-        throw std::invalid_argument("Query word "s + text + " is invalid");
+        throw std::invalid_argument("Query word "s + string(text) + " is invalid");
     }
 
     return {word, is_minus, IsStopWord(word)};
 }
 
-SearchServer::Query SearchServer::ParseQuery(const string& text) const {
+SearchServer::Query SearchServer::ParseQuery(string_view text, bool keep_duplicates) const {
     Query result;
-    for (const string& word : SplitIntoWords(text)) {
+    for (const string_view word : SplitIntoWords(text)) {
         const auto query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                result.minus_words.insert(query_word.data);
+                result.minus_words.push_back(query_word.data);
             } else {
-                result.plus_words.insert(query_word.data);
+                result.plus_words.push_back(query_word.data);
             }
         }
     }
+    if (!keep_duplicates) {
+        for (auto* words : {&result.plus_words, &result.minus_words}) {
+            sort(words->begin(), words->end());
+            words->erase(unique(words->begin(), words->end()), words->end());
+        }
+    }
     return result;
 }
 
+vector<SearchServer::PostingCursor> SearchServer::GetPostingCursors(const vector<string_view>& words,
+                                                                   int first_document, int last_document) const {
+    const FinalizedIndex& index = *finalized_index_;
+    vector<PostingCursor> cursors;
+    cursors.reserve(words.size());
+    for (const string_view word : words) {
+        const auto found = lower_bound(index.words.begin(), index.words.end(), word);
+        if (found == index.words.end() || *found != word) {
+            continue;
+        }
+        const size_t word_index = found - index.words.begin();
+        const int* postings_begin = index.posting_documents.data() + index.word_offsets[word_index];
+        const int* postings_end = index.posting_documents.data() + index.word_offsets[word_index + 1];
+        const int* first = lower_bound(postings_begin, postings_end, first_document);
+        const int* last = lower_bound(first, postings_end, last_document);
+        const double inverse_document_freq = log(GetDocumentCount() * 1.0 / (postings_end - postings_begin));
+        cursors.push_back({first, last, index.posting_freqs.data() + (first - index.posting_documents.data()),
+                           inverse_document_freq});
+    }
+    return cursors;
+}
+
 // Existence required
-double SearchServer::ComputeWordInverseDocumentFreq(const string& word) const {
+double SearchServer::ComputeWordInverseDocumentFreq(string_view word) const {
     return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
 }
@@ -1,68 +1,165 @@
 #pragma once
+#include "concurrent_map.h"
 #include "document.h"
 #include "string_processing.h"
 #include <algorithm>
+#include <execution>
 #include <map>
+#include <numeric>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPSILON = 1e-6;
+// Buckets of the relevance map shared by threads of a parallel search
+const size_t RELEVANCE_BUCKET_COUNT = 128;
+// Document ranges of a finalized index searched in parallel
+const int FINALIZED_CHUNK_COUNT = 64;
 
 class SearchServer {
 public: 
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words);
     explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(std::string_view stop_words_text);
 
-    void AddDocument(int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings);
+    // The server keeps its own copy of the text; both indexes refer to words inside it
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const;
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(const std::string& raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // policy is std::execution::seq or std::execution::par. The parallel version handles
+    // the words of one query on all cores and accumulates relevance in a bucketed map
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                           DocumentPredicate document_predicate) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                           DocumentStatus status) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
+
+    // Packs the index into sorted arrays, so searches merge contiguous posting lists
+    // instead of walking trees. AddDocument and RemoveDocument drop the packed index;
+    // call Finalize again once the documents are loaded
+    void Finalize();
+    bool IsFinalized() const;
 
     int GetDocumentCount() const;
     int GetDocumentId(int index) const;
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
+
+    // Ids of the documents in the order they were added
+    std::vector<int>::const_iterator begin() const;
+    std::vector<int>::const_iterator end() const;
+
+    // Term frequencies of the document's words; empty for an unknown document
+    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+
+    // Touches only the postings of the document's own words. Unknown ids are ignored
+    void RemoveDocument(int document_id);
+    void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
+    void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+
+    // Matched words point into the document's text and stay valid until it is removed
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&,
+                                                                            std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&,
+                                                                            std::string_view raw_query, int document_id) const;
 
 private:
     struct DocumentData {
         int rating;
         DocumentStatus status;
+        std::string text;
     };
-    const std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
+    const std::set<std::string, std::less<>> stop_words_;
+    // Each word points into the text of one of the documents in its postings
+    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
+    // Reverse index; words point into the text of the document itself
+    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
     std::map<int, DocumentData> documents_;
     std::vector<int> document_ids_;
 
-    bool IsStopWord(const std::string& word) const;
-    static bool IsValidWord(const std::string& word);
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    // Documents are numbered in order of id; every array is indexed by word or document number
+    struct FinalizedIndex {
+        // Sorted; postings of words[i] are in [word_offsets[i], word_offsets[i + 1])
+        std::vector<std::string_view> words;
+        std::vector<size_t> word_offsets;
+        std::vector<int> posting_documents;
+        std::vector<double> posting_freqs;
+        std::vector<int> document_ids;
+        std::vector<int> document_ratings;
+        std::vector<DocumentStatus> document_statuses;
+    };
+    std::optional<FinalizedIndex> finalized_index_;
+
+    bool IsStopWord(std::string_view word) const;
+    static bool IsValidWord(std::string_view word);
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
     static int ComputeAverageRating(const std::vector<int>& ratings);
+    // Called after the document's posting of the word is erased. Drops the word if nobody
+    // else has it, or moves its key into another document's text
+    void ReleaseWord(std::string_view word);
+    // Drops the document itself once its postings are gone
+    void EraseDocumentData(int document_id);
 
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(const std::string& text) const;
+    QueryWord ParseQueryWord(std::string_view text) const;
 
+    // Words point into the raw query
     struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
     };
 
-    Query ParseQuery(const std::string& text) const;
+    // Words are sorted and unique unless keep_duplicates is set
+    Query ParseQuery(std::string_view text, bool keep_duplicates = false) const;
 
     // Existence required
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    double ComputeWordInverseDocumentFreq(std::string_view word) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query,
+                                           DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query,
+                                           DocumentPredicate document_predicate) const;
+
+    // Postings of a finalized word within a range of document numbers
+    struct PostingCursor {
+        const int* document;
+        const int* end;
+        const double* freq;
+        double inverse_document_freq;
+    };
+
+    // Unknown words are skipped
+    std::vector<PostingCursor> GetPostingCursors(const std::vector<std::string_view>& words, int first_document,
+                                                 int last_document) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllFinalizedDocuments(const std::execution::sequenced_policy&, const Query& query,
+                                                    DocumentPredicate document_predicate) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllFinalizedDocuments(const std::execution::parallel_policy&, const Query& query,
+                                                    DocumentPredicate document_predicate) const;
+    // Document-at-a-time merge of the posting lists over [first_document, last_document)
+    template <typename DocumentPredicate>
+    std::vector<Document> MergePostings(const Query& query, DocumentPredicate document_predicate,
+                                        int first_document, int last_document) const;
 };
 
 template <typename StringContainer>
@@ -78,12 +175,19 @@ SearchServer::SearchServer(const StringContainer& stop_words)
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const {
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                     DocumentPredicate document_predicate) const {
     const auto query = ParseQuery(raw_query);
 
-    auto matched_documents = FindAllDocuments(query, document_predicate);
+    auto matched_documents = finalized_index_ ? FindAllFinalizedDocuments(policy, query, document_predicate)
+                                              : FindAllDocuments(policy, query, document_predicate);
 
-    sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
+    sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
         if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
             return lhs.rating > rhs.rating;
         } else {
@@ -97,10 +201,24 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_quer
     return matched_documents;
 }
 
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query,
+                                                     DocumentStatus status) const {
+    return FindTopDocuments(policy, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query,
+                                                     DocumentPredicate document_predicate) const {
     std::map<int, double> document_to_relevance;
-    for (const std::string& word : query.plus_words) {
+    for (const std::string_view word : query.plus_words) {
         if (word_to_document_freqs_.count(word) == 0) {
             continue;
         }
@@ -113,7 +231,7 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
         }
     }
 
-    for (const std::string& word : query.minus_words) {
+    for (const std::string_view word : query.minus_words) {
         if (word_to_document_freqs_.count(word) == 0) {
             continue;
         }
@@ -127,4 +245,105 @@ std::vector<Document> SearchServer::FindAllDocuments(const Query& query, Documen
         matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
     }
     return matched_documents;
-}
\ No newline at end of file
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query,
+                                                     DocumentPredicate document_predicate) const {
+    ConcurrentMap<int, double> document_to_relevance(RELEVANCE_BUCKET_COUNT);
+    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), [&](std::string_view word) {
+        const auto postings = word_to_document_freqs_.find(word);
+        if (postings == word_to_document_freqs_.end()) {
+            return;
+        }
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+        for (const auto &[document_id, term_freq] : postings->second) {
+            const auto& document_data = documents_.at(document_id);
+            if (document_predicate(document_id, document_data.status, document_data.rating)) {
+                document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+            }
+        }
+    });
+
+    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(), [&](std::string_view word) {
+        const auto postings = word_to_document_freqs_.find(word);
+        if (postings == word_to_document_freqs_.end()) {
+            return;
+        }
+        for (const auto &[document_id, _] : postings->second) {
+            document_to_relevance.Erase(document_id);
+        }
+    });
+
+    std::vector<Document> matched_documents;
+    for (const auto &[document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
+        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+    }
+    return matched_documents;
+}
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllFinalizedDocuments(const std::execution::sequenced_policy&, const Query& query,
+                                                              DocumentPredicate document_predicate) const {
+    return MergePostings(query, document_predicate, 0, static_cast<int>(finalized_index_->document_ids.size()));
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllFinalizedDocuments(const std::execution::parallel_policy&, const Query& query,
+                                                              DocumentPredicate document_predicate) const {
+    // Chunks split every posting list too, so even a one-word query uses all cores
+    const int document_count = static_cast<int>(finalized_index_->document_ids.size());
+    const int chunk_size = std::max(1, (document_count + FINALIZED_CHUNK_COUNT - 1) / FINALIZED_CHUNK_COUNT);
+    std::vector<int> chunks((document_count + chunk_size - 1) / chunk_size);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    std::vector<std::vector<Document>> chunk_documents(chunks.size());
+    std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](int chunk) {
+        const int first_document = chunk * chunk_size;
+        chunk_documents[chunk] = MergePostings(query, document_predicate, first_document,
+                                               std::min(first_document + chunk_size, document_count));
+    });
+
+    std::vector<Document> matched_documents;
+    for (auto& documents : chunk_documents) {
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+    }
+    return matched_documents;
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::MergePostings(const Query& query, DocumentPredicate document_predicate,
+                                                  int first_document, int last_document) const {
+    const FinalizedIndex& index = *finalized_index_;
+    auto plus_cursors = GetPostingCursors(query.plus_words, first_document, last_document);
+    auto minus_cursors = GetPostingCursors(query.minus_words, first_document, last_document);
+
+    std::vector<Document> matched_documents;
+    while (true) {
+        // Every cursor stops before last_document, so it marks that all of them are done
+        int document = last_document;
+        for (const PostingCursor& cursor : plus_cursors) {
+            document = std::min(document, cursor.document != cursor.end ? *cursor.document : last_document);
+        }
+        if (document == last_document) {
+            break;
+        }
+        // Words are added in query order, as in FindAllDocuments
+        double relevance = 0.0;
+        for (PostingCursor& cursor : plus_cursors) {
+            if (cursor.document != cursor.end && *cursor.document == document) {
+                relevance += *cursor.freq * cursor.inverse_document_freq;
+                ++cursor.document;
+                ++cursor.freq;
+            }
+        }
+        bool has_minus_word = false;
+        for (PostingCursor& cursor : minus_cursors) {
+            cursor.document = std::lower_bound(cursor.document, cursor.end, document);
+            has_minus_word = has_minus_word || (cursor.document != cursor.end && *cursor.document == document);
+        }
+        if (!has_minus_word && document_predicate(index.document_ids[document], index.document_statuses[document],
+                                                  index.document_ratings[document])) {
+            matched_documents.push_back({index.document_ids[document], relevance, index.document_ratings[document]});
+        }
+    }
+    return matched_documents;
+}
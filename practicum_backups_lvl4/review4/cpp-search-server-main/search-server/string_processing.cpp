@@ -1,23 +1,17 @@
 #include "string_processing.h"
-#include <string>
+#include <string_view>
 #include <vector>
 
-std::vector<std::string> SplitIntoWords(const std::string& text) {
-    std::vector<std::string> words;
-    std::string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
-            }
-        } else {
-            word += c;
+std::vector<std::string_view> SplitIntoWords(std::string_view text) {
+    std::vector<std::string_view> words;
+    while (!text.empty()) {
+        const size_t space = text.find(' ');
+        const std::string_view word = text.substr(0, space);
+        if (!word.empty()) {
+            words.push_back(word);
         }
-    }
-    if (!word.empty()) {
-        words.push_back(word);
+        text.remove_prefix(space == std::string_view::npos ? text.size() : space + 1);
     }
 
     return words;
-}
\ No newline at end of file
+}
@@ -0,0 +1,267 @@
+#include "test_example_functions.h"
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "test_runner_p.h"
+#include <cmath>
+#include <execution>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const vector<string> TEST_DOCUMENTS = {
+    "white cat and fashionable collar"s,
+    "fluffy cat fluffy tail"s,
+    "groomed dog expressive eyes"s,
+    "groomed starling eugene"s,
+    "fluffy dog and fashionable collar"s,
+    "big cat big dog"s,
+    "nasty rat with a funny tail"s,
+    "big starling with white collar"s,
+    "cat and dog in the garden"s,
+    "expressive eyes of a fluffy cat"s,
+};
+
+const vector<string> TEST_QUERIES = {
+    "fluffy groomed cat"s,
+    "curly and funny -not"s,
+    "big collar -rat"s,
+    "fluffy -cat"s,
+    "eyes tail starling dog"s,
+    "and in the"s,
+    "parrot"s,
+};
+
+// Every document gets its own rating, so no two results tie and the order is fixed
+void AddTestDocuments(SearchServer& search_server) {
+    for (int i = 0; i < static_cast<int>(TEST_DOCUMENTS.size()); ++i) {
+        const DocumentStatus status = i % 4 == 3 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(i + 1, TEST_DOCUMENTS[i], status, {i, 2 * i, -i});
+    }
+}
+
+void AssertEqualDocuments(const vector<Document>& lhs, const vector<Document>& rhs, const string& hint) {
+    AssertEqual(lhs.size(), rhs.size(), hint);
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        AssertEqual(lhs[i].id, rhs[i].id, hint);
+        AssertEqual(lhs[i].rating, rhs[i].rating, hint);
+        Assert(abs(lhs[i].relevance - rhs[i].relevance) < EPSILON, hint);
+    }
+}
+
+// Both policies give the same top documents and matched words as the plain calls
+void TestExecutionPoliciesAgree() {
+    SearchServer search_server("and in the"s);
+    AddTestDocuments(search_server);
+    const auto is_even = [](int document_id, DocumentStatus, int) {
+        return document_id % 2 == 0;
+    };
+    for (const string& query : TEST_QUERIES) {
+        const auto expected = search_server.FindTopDocuments(query);
+        AssertEqualDocuments(search_server.FindTopDocuments(execution::seq, query), expected, query);
+        AssertEqualDocuments(search_server.FindTopDocuments(execution::par, query), expected, query);
+
+        const auto expected_banned = search_server.FindTopDocuments(query, DocumentStatus::BANNED);
+        AssertEqualDocuments(search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                             expected_banned, query);
+        const auto expected_even = search_server.FindTopDocuments(query, is_even);
+        AssertEqualDocuments(search_server.FindTopDocuments(execution::par, query, is_even), expected_even, query);
+
+        for (const int document_id : search_server) {
+            const auto [words, status] = search_server.MatchDocument(query, document_id);
+            const auto [seq_words, seq_status] = search_server.MatchDocument(execution::seq, query, document_id);
+            const auto [par_words, par_status] = search_server.MatchDocument(execution::par, query, document_id);
+            AssertEqual(seq_words, words, query);
+            AssertEqual(par_words, words, query);
+            Assert(seq_status == status && par_status == status, query);
+        }
+    }
+}
+
+// Matched words must point into the matched document's own text, which lives as long as the document
+void TestMatchedWordsPointIntoDocument() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "big cat"s, DocumentStatus::ACTUAL, {1});
+    const auto& word_freqs = search_server.GetWordFrequencies(2);
+
+    const auto [seq_words, seq_status] = search_server.MatchDocument("cat -mouse"s, 2);
+    const auto [par_words, par_status] = search_server.MatchDocument(execution::par, "cat big cat"s, 2);
+    ASSERT_EQUAL(seq_words, vector<string_view>({"cat"sv}));
+    ASSERT_EQUAL(par_words, vector<string_view>({"big"sv, "cat"sv}));
+    ASSERT(seq_words[0].data() == word_freqs.find("cat"sv)->first.data());
+    ASSERT(par_words[1].data() == word_freqs.find("cat"sv)->first.data());
+
+    search_server.RemoveDocument(1);
+    ASSERT_EQUAL(seq_words[0], "cat"sv);
+    ASSERT_EQUAL(par_words[0], "big"sv);
+}
+
+// A word first added by a removed document stays searchable in the others
+void TestRemovedDocumentKeepsSharedWords() {
+    for (const bool parallel : {false, true}) {
+        SearchServer search_server("and"s);
+        search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+        search_server.AddDocument(2, "big cat"s, DocumentStatus::ACTUAL, {2});
+        search_server.AddDocument(3, "cat and dog"s, DocumentStatus::ACTUAL, {3});
+        if (parallel) {
+            search_server.RemoveDocument(execution::par, 1);
+        } else {
+            search_server.RemoveDocument(1);
+        }
+
+        const auto documents = search_server.FindTopDocuments("cat dog"s);
+        ASSERT_EQUAL(documents.size(), 2u);
+        ASSERT_EQUAL(documents[0].id, 3);
+        ASSERT_EQUAL(documents[1].id, 2);
+        const auto [words, status] = search_server.MatchDocument("cat dog"s, 3);
+        ASSERT_EQUAL(words, vector<string_view>({"cat"sv, "dog"sv}));
+        ASSERT(search_server.FindTopDocuments("-cat"s).empty());
+    }
+}
+
+// Results come in the order of queries; the joined sequence skips empty ones
+void TestProcessQueries() {
+    SearchServer search_server("and in the"s);
+    AddTestDocuments(search_server);
+
+    const auto results = ProcessQueries(search_server, TEST_QUERIES);
+    AssertEqual(results.size(), TEST_QUERIES.size());
+    vector<Document> expected_joined;
+    for (size_t i = 0; i < TEST_QUERIES.size(); ++i) {
+        const auto expected = search_server.FindTopDocuments(TEST_QUERIES[i]);
+        AssertEqualDocuments(results[i], expected, TEST_QUERIES[i]);
+        expected_joined.insert(expected_joined.end(), expected.begin(), expected.end());
+    }
+    ASSERT(!results.front().empty());
+    ASSERT(results.back().empty());
+
+    const auto joined = ProcessQueriesJoined(search_server, TEST_QUERIES);
+    AssertEqual(joined.size(), expected_joined.size());
+    AssertEqualDocuments(vector<Document>(joined.begin(), joined.end()), expected_joined, "joined"s);
+
+    ASSERT(ProcessQueries(search_server, {}).empty());
+    const auto nothing_found = ProcessQueriesJoined(search_server, {"parrot"s, "-cat"s});
+    ASSERT_EQUAL(nothing_found.size(), 0u);
+    ASSERT(nothing_found.begin() == nothing_found.end());
+}
+
+// After removals the server answers like one built from the remaining documents only
+void TestRemoveDocument() {
+    SearchServer expected_server("and in the"s);
+    for (const int document_id : {1, 2, 4, 6, 7, 9}) {
+        expected_server.AddDocument(document_id, TEST_DOCUMENTS[document_id - 1], DocumentStatus::ACTUAL, {document_id});
+    }
+    for (const bool parallel : {false, true}) {
+        SearchServer search_server("and in the"s);
+        for (int document_id = 1; document_id <= static_cast<int>(TEST_DOCUMENTS.size()); ++document_id) {
+            search_server.AddDocument(document_id, TEST_DOCUMENTS[document_id - 1], DocumentStatus::ACTUAL, {document_id});
+        }
+        for (const int document_id : {3, 5, 8, 10, 42}) {
+            if (parallel) {
+                search_server.RemoveDocument(execution::par, document_id);
+            } else {
+                search_server.RemoveDocument(execution::seq, document_id);
+            }
+        }
+
+        ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+        ASSERT_EQUAL(vector<int>(search_server.begin(), search_server.end()), vector<int>({1, 2, 4, 6, 7, 9}));
+        ASSERT(search_server.GetWordFrequencies(3).empty());
+        for (const int document_id : expected_server) {
+            ASSERT_EQUAL(search_server.GetWordFrequencies(document_id).size(),
+                         expected_server.GetWordFrequencies(document_id).size());
+        }
+        for (const string& query : TEST_QUERIES) {
+            AssertEqualDocuments(search_server.FindTopDocuments(query), expected_server.FindTopDocuments(query), query);
+        }
+    }
+}
+
+// Documents with the same set of words as an earlier one are removed, whatever the order and count of words
+void TestRemoveDuplicates() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(3, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(4, "funny pet and curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(5, "funny funny pet and nasty nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(6, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(7, "very nasty rat and not very funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(8, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(9, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+
+    ostringstream output;
+    streambuf* const cout_buffer = cout.rdbuf(output.rdbuf());
+    RemoveDuplicates(search_server);
+    cout.rdbuf(cout_buffer);
+
+    ASSERT_EQUAL(output.str(), "Found duplicate document id 3\nFound duplicate document id 4\n"
+                               "Found duplicate document id 5\nFound duplicate document id 7\n"s);
+    ASSERT_EQUAL(vector<int>(search_server.begin(), search_server.end()), vector<int>({1, 2, 6, 8, 9}));
+}
+
+// The finalized index gives the same results as the maps, and any change drops it
+void TestFinalizedIndex() {
+    SearchServer search_server("and in the"s);
+    SearchServer finalized_server("and in the"s);
+    AddTestDocuments(search_server);
+    AddTestDocuments(finalized_server);
+    ASSERT(!finalized_server.IsFinalized());
+    finalized_server.Finalize();
+    ASSERT(finalized_server.IsFinalized());
+
+    const auto has_rating = [](int, DocumentStatus, int rating) {
+        return rating > 1;
+    };
+    const auto check_same_results = [&] {
+        for (const string& query : TEST_QUERIES) {
+            const auto expected = search_server.FindTopDocuments(query);
+            AssertEqualDocuments(finalized_server.FindTopDocuments(query), expected, query);
+            AssertEqualDocuments(finalized_server.FindTopDocuments(execution::par, query), expected, query);
+            AssertEqualDocuments(finalized_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                                 search_server.FindTopDocuments(query, DocumentStatus::BANNED), query);
+            AssertEqualDocuments(finalized_server.FindTopDocuments(query, has_rating),
+                                 search_server.FindTopDocuments(query, has_rating), query);
+        }
+    };
+    check_same_results();
+
+    search_server.RemoveDocument(2);
+    finalized_server.RemoveDocument(2);
+    ASSERT(!finalized_server.IsFinalized());
+    check_same_results();
+    finalized_server.Finalize();
+    check_same_results();
+
+    search_server.AddDocument(20, "fluffy groomed cat"s, DocumentStatus::ACTUAL, {100});
+    finalized_server.AddDocument(20, "fluffy groomed cat"s, DocumentStatus::ACTUAL, {100});
+    ASSERT(!finalized_server.IsFinalized());
+    finalized_server.Finalize();
+    check_same_results();
+    ASSERT_EQUAL(finalized_server.FindTopDocuments("fluffy groomed cat"s).front().id, 20);
+
+    SearchServer empty_server("and"s);
+    empty_server.Finalize();
+    ASSERT(empty_server.FindTopDocuments("cat"s).empty());
+    ASSERT(empty_server.FindTopDocuments(execution::par, "cat"s).empty());
+}
+
+} // namespace
+
+void TestSearchServer() {
+    TestRunner tr;
+    RUN_TEST(tr, TestExecutionPoliciesAgree);
+    RUN_TEST(tr, TestProcessQueries);
+    RUN_TEST(tr, TestRemoveDocument);
+    RUN_TEST(tr, TestRemoveDuplicates);
+    RUN_TEST(tr, TestFinalizedIndex);
+    RUN_TEST(tr, TestMatchedWordsPointIntoDocument);
+    RUN_TEST(tr, TestRemovedDocumentKeepsSharedWords);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Runs the unit tests of the search server; failures are printed to std::cerr
+// and end the program with exit code 1
+void TestSearchServer();